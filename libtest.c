@@ -236,4 +236,25 @@ int increment_thread_safe(void) {
     pthread_mutex_unlock(&counter_mutex);
     LOGI("🔒 increment_thread_safe() = %d\n", result);
     return result;
-}
\ No newline at end of file
+}
+// IFUNC 测试：解析函数只应在符号被查找（或被重定位引用）时调用
+#if defined(__ELF__) && defined(__GLIBC__)
+static int ifunc_resolver_count = 0;
+
+static int ifunc_impl(void) {
+    return 7;
+}
+
+static int (*resolve_ifunc_value(void))(void) {
+    ifunc_resolver_count++;
+    return ifunc_impl;
+}
+
+__attribute__((visibility("default")))
+int ifunc_value(void) __attribute__((ifunc("resolve_ifunc_value")));
+
+__attribute__((visibility("default")))
+int ifunc_resolver_calls(void) {
+    return ifunc_resolver_count;
+}
+#endif
@@ -0,0 +1,51 @@
+/*******************************************************************************
+ * File: libtest_dep.c
+ * Project: memdl test library
+ * Created: 2025/11/7
+ * Author: eternalfuture-e38299
+ * Github: https://github.com/eternalfuture-e38299
+ *
+ * MIT License
+ *
+ * Copyright (c) 2025 EternalFuture
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+
+// 依赖测试库：同一源文件编译为 libtest_dep.so（被依赖方）和 libtest_top.so（定义 MEMDL_TEST_TOP，DT_NEEDED libtest_dep.so）
+
+__attribute__((visibility("default")))
+int dep_value(void);
+
+#ifndef MEMDL_TEST_TOP
+int dep_value(void) {
+    return 41;
+}
+#else
+__attribute__((visibility("default")))
+int top_value(void) {
+    return dep_value() + 1;
+}
+
+// 返回实际绑定的 dep_value 地址，用于确认依赖来自内存中的实例
+__attribute__((visibility("default")))
+void* top_dep_addr(void) {
+    return (void*) &dep_value;
+}
+#endif
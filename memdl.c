@@ -28,11 +28,17 @@
  * SOFTWARE.
  *******************************************************************************/
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "memdl.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
 
 // 平台特定头文件
 #if defined(_WIN32) || defined(_WIN64)
@@ -64,7 +70,7 @@
 #include <sys/mman.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <errno.h>
+#include <sys/stat.h>
 #endif
 
 // 内存文件描述符相关头文件
@@ -77,423 +83,7208 @@
 #include <stdlib.h>  // 为了mkstemp
 #endif
 
-// 内部错误信息
-static char memdl_error_msg[256] = {0};
+// 句柄缓存与零拷贝相关
+#if defined(MEMDL_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/vfs.h>
+#include <elf.h>
+#include <link.h>
+#include <gnu/lib-names.h>
+#if defined(__has_include)
+#if __has_include(<linux/userfaultfd.h>)
+#include <sys/ioctl.h>
+#include <linux/userfaultfd.h>
+#define MEMDL_HAVE_UFFD
+#endif
+#endif
+#endif
+
+// 线程局部存储
+#if defined(_MSC_VER)
+#define MEMDL_THREAD_LOCAL __declspec(thread)
+#else
+#define MEMDL_THREAD_LOCAL _Thread_local
+#endif
+
+// 内部错误信息（每个线程独立，并发加载互不覆盖）
+static MEMDL_THREAD_LOCAL memdl_error_info_t memdl_last_error_info;
+static MEMDL_THREAD_LOCAL int memdl_stage = MEMDL_STAGE_NONE;
 
 // 设置错误信息
+static void memdl_set_error_v(const int code, const int sys_errno, const char *format, va_list args) {
+    memdl_last_error_info.code = code;
+    memdl_last_error_info.stage = memdl_stage;
+    memdl_last_error_info.sys_errno = sys_errno;
+    vsnprintf(memdl_last_error_info.message, sizeof(memdl_last_error_info.message), format, args);
+}
+
+static void memdl_set_error_code(const int code, const int sys_errno, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    memdl_set_error_v(code, sys_errno, format, args);
+    va_end(args);
+}
+
+#if !defined(MEMDL_LINUX)
 static void memdl_set_error(const char *msg) {
-    strncpy(memdl_error_msg, msg, sizeof(memdl_error_msg) - 1);
-    memdl_error_msg[sizeof(memdl_error_msg) - 1] = '\0';
+    memdl_set_error_code(MEMDL_ERR_FAILED, 0, "%s", msg ? msg : "Unknown error");
 }
 
 static void memdl_set_error_format(const char *format, ...) {
     va_list args;
     va_start(args, format);
-    vsnprintf(memdl_error_msg, sizeof(memdl_error_msg), format, args);
+    memdl_set_error_v(MEMDL_ERR_FAILED, 0, format, args);
     va_end(args);
 }
+#endif
 
-// 平台检测
-int memdl_get_platform(void) {
-#if defined(MEMDL_WINDOWS)
-    return MEMDL_PLATFORM_WINDOWS;
-#elif defined(MEMDL_IOS)
-    return MEMDL_PLATFORM_IOS;
-#elif defined(MEMDL_MACOS)
-    return MEMDL_PLATFORM_MACOS;
-#elif defined(MEMDL_ANDROID)
-    return MEMDL_PLATFORM_ANDROID;
-#elif defined(MEMDL_LINUX)
-    return MEMDL_PLATFORM_LINUX;
-#else
-    return MEMDL_PLATFORM_UNKNOWN;
+#if !defined(MEMDL_WINDOWS)
+// 记录系统调用失败及 errno
+static void memdl_set_sys_error(const char *what) {
+    const int err = errno;
+    memdl_set_error_code(MEMDL_ERR_SYSTEM, err, "%s: %s", what, strerror(err));
+}
+
+// 记录动态链接器的错误文本
+static void memdl_set_dl_error(void) {
+    const char *err = dlerror();
+    memdl_set_error_code(MEMDL_ERR_LOADER, 0, "%s", err ? err : "Unknown loader error");
+}
 #endif
+
+// 64位哈希 (XXH64)，用于包内名字索引；镜像内容摘要见下方 XXH3
+#define MEMDL_PRIME64_1 0x9E3779B185EBCA87ULL
+#define MEMDL_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define MEMDL_PRIME64_3 0x165667B19E3779F9ULL
+#define MEMDL_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define MEMDL_PRIME64_5 0x27D4EB2F165667C5ULL
+#define MEMDL_PRIME32_1 0x9E3779B1u
+#define MEMDL_PRIME32_2 0x85EBCA77u
+#define MEMDL_PRIME32_3 0xC2B2AE3Du
+#define MEMDL_PRIME32_4 0x27D4EB2Fu
+#define MEMDL_PRIME32_5 0x165667B1u
+
+static uint64_t memdl_rotl64(const uint64_t x, const int r) {
+    return (x << r) | (x >> (64 - r));
 }
 
-// 验证ELF/Mach-O/PE头
-int memdl_validate(const void *so_data, const size_t so_size) {
-    if (!so_data || so_size < 4) {
-        memdl_set_error("Invalid data or size");
-        return -1;
-    }
+static uint64_t memdl_read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
 
-    const unsigned char *data = so_data;
+static uint32_t memdl_read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
 
-    // 检查ELF头 (Linux/Android)
-    if (data[0] == 0x7F && data[1] == 'E' &&
-        data[2] == 'L' && data[3] == 'F') {
-        return 0;
-    }
+static uint64_t memdl_xxh64_round(uint64_t acc, const uint64_t input) {
+    acc += input * MEMDL_PRIME64_2;
+    acc = memdl_rotl64(acc, 31);
+    return acc * MEMDL_PRIME64_1;
+}
 
-    // 检查Mach-O头 (macOS/iOS)
-    const uint32_t magic = *(const uint32_t *) data;
-    if (magic == 0xFEEDFACE || magic == 0xFEEDFACF || // 32位
-        magic == 0xCEFAEDFE || magic == 0xCFFAEDFE) {
-        // 64位
-        return 0;
+static uint64_t memdl_xxh64_merge(uint64_t acc, const uint64_t val) {
+    acc ^= memdl_xxh64_round(0, val);
+    return acc * MEMDL_PRIME64_1 + MEMDL_PRIME64_4;
+}
+
+static uint64_t memdl_hash64(const void *input, const size_t len, const uint64_t seed) {
+    const unsigned char *p = input;
+    const unsigned char *const end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        const unsigned char *const limit = end - 32;
+        uint64_t v1 = seed + MEMDL_PRIME64_1 + MEMDL_PRIME64_2;
+        uint64_t v2 = seed + MEMDL_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - MEMDL_PRIME64_1;
+        do {
+            v1 = memdl_xxh64_round(v1, memdl_read64(p));
+            v2 = memdl_xxh64_round(v2, memdl_read64(p + 8));
+            v3 = memdl_xxh64_round(v3, memdl_read64(p + 16));
+            v4 = memdl_xxh64_round(v4, memdl_read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = memdl_rotl64(v1, 1) + memdl_rotl64(v2, 7) + memdl_rotl64(v3, 12) + memdl_rotl64(v4, 18);
+        h = memdl_xxh64_merge(h, v1);
+        h = memdl_xxh64_merge(h, v2);
+        h = memdl_xxh64_merge(h, v3);
+        h = memdl_xxh64_merge(h, v4);
+    } else {
+        h = seed + MEMDL_PRIME64_5;
     }
 
-    // 检查PE头 (Windows)
-    if (data[0] == 'M' && data[1] == 'Z') {
-        return 0;
+    h += (uint64_t) len;
+    while (p + 8 <= end) {
+        h ^= memdl_xxh64_round(0, memdl_read64(p));
+        h = memdl_rotl64(h, 27) * MEMDL_PRIME64_1 + MEMDL_PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t) memdl_read32(p) * MEMDL_PRIME64_1;
+        h = memdl_rotl64(h, 23) * MEMDL_PRIME64_2 + MEMDL_PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * MEMDL_PRIME64_5;
+        h = memdl_rotl64(h, 11) * MEMDL_PRIME64_1;
+        p++;
     }
 
-    memdl_set_error("Not a valid executable format");
-    return -1;
+    h ^= h >> 33;
+    h *= MEMDL_PRIME64_2;
+    h ^= h >> 29;
+    h *= MEMDL_PRIME64_3;
+    h ^= h >> 32;
+    return h;
 }
 
-// 获取架构信息
-int memdl_get_arch(const void *so_data, const size_t so_size) {
-    if (memdl_validate(so_data, so_size) != 0) {
-        return MEMDL_ARCH_UNKNOWN;
-    }
+// ---------------------------------------------------------------------------
+// 镜像摘要 (XXH3-64，默认密钥，种子 0)：句柄缓存键与 memdl_open_verified 的校验共用。
+// 长输入的条带累加按 CPU 在运行时选用 AVX2/SSE2（x86-64）或 NEON（AArch64），其余平台为标量实现
+// ---------------------------------------------------------------------------
 
-    const unsigned char *data = (const unsigned char *) so_data;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MEMDL_XXH3_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define MEMDL_XXH3_NEON 1
+#include <arm_neon.h>
+#endif
 
-    // ELF格式
-    if (data[0] == 0x7F && data[1] == 'E' && data[2] == 'L' && data[3] == 'F') {
-        return data[4] == 1
-                   ? MEMDL_ARCH_X86
-                   : // 32位
-                   data[4] == 2
-                       ? MEMDL_ARCH_X86_64
-                       : // 64位
-                       data[4] == 40
-                           ? MEMDL_ARCH_ARM
-                           : // ARM
-                           data[4] == 183
-                               ? MEMDL_ARCH_ARM64
-                               : // ARM64
-                               MEMDL_ARCH_UNKNOWN;
-    }
+#define MEMDL_PRIME_MX1 0x165667919E3779F9ULL
+#define MEMDL_PRIME_MX2 0x9FB21C651E98DF25ULL
+
+#define MEMDL_XXH3_STRIPE       64
+#define MEMDL_XXH3_SECRET_SIZE  192
+#define MEMDL_XXH3_BLOCK_STRIPES ((MEMDL_XXH3_SECRET_SIZE - MEMDL_XXH3_STRIPE) / 8)
+#define MEMDL_XXH3_BLOCK        (MEMDL_XXH3_STRIPE * MEMDL_XXH3_BLOCK_STRIPES)
+#define MEMDL_XXH3_CHUNK_BLOCKS 256     // 融合复制时每 256KB 交给 sink 一次，数据仍在缓存中
+
+static const unsigned char memdl_xxh3_secret[MEMDL_XXH3_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+// 融合复制的去向：按顺序收到已经计算过摘要的数据块，失败返回非 0
+typedef int (*memdl_sink_fn)(void *ctx, const void *data, size_t len);
+// 累加 stripes 个连续条带（每个条带使用的密钥前移 8 字节）；打乱累加器
+typedef void (*memdl_xxh3_acc_fn)(uint64_t *acc, const unsigned char *input, const unsigned char *secret,
+                                  size_t stripes);
+typedef void (*memdl_xxh3_scramble_fn)(uint64_t *acc, const unsigned char *secret);
 
-    // 其他格式暂返回未知
-    return MEMDL_ARCH_UNKNOWN;
+static uint64_t memdl_mul128_fold64(const uint64_t a, const uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    const __uint128_t product = (__uint128_t) a * b;
+    return (uint64_t) product ^ (uint64_t) (product >> 64);
+#else
+    const uint64_t lo_lo = (a & 0xffffffffu) * (b & 0xffffffffu);
+    const uint64_t hi_lo = (a >> 32) * (b & 0xffffffffu);
+    const uint64_t lo_hi = (a & 0xffffffffu) * (b >> 32);
+    const uint64_t hi_hi = (a >> 32) * (b >> 32);
+    const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffffu) + lo_hi;
+    const uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    return ((cross << 32) | (lo_lo & 0xffffffffu)) ^ upper;
+#endif
 }
 
-// 平台特定实现
-#ifdef MEMDL_WINDOWS
+static uint64_t memdl_xxh64_avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= MEMDL_PRIME64_2;
+    h ^= h >> 29;
+    h *= MEMDL_PRIME64_3;
+    return h ^ (h >> 32);
+}
 
-#include <stdio.h>
+static uint64_t memdl_xxh3_avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= MEMDL_PRIME_MX1;
+    return h ^ (h >> 32);
+}
 
-memdl_handle_t memdl_open_file(const char *filename, const int flags) {
-    return LoadLibraryA(filename);
+static uint64_t memdl_xxh3_rrmxmx(uint64_t h, const uint64_t len) {
+    h ^= memdl_rotl64(h, 49) ^ memdl_rotl64(h, 24);
+    h *= MEMDL_PRIME_MX2;
+    h ^= (h >> 35) + len;
+    h *= MEMDL_PRIME_MX2;
+    return h ^ (h >> 28);
 }
 
-memdl_handle_t memdl_open(const void *so_data, size_t so_size, int flags) {
-    if (memdl_validate(so_data, so_size) != 0) {
-        return NULL;
-    }
+static uint64_t memdl_xxh3_mix16(const unsigned char *input, const unsigned char *secret) {
+    return memdl_mul128_fold64(memdl_read64(input) ^ memdl_read64(secret),
+                               memdl_read64(input + 8) ^ memdl_read64(secret + 8));
+}
 
-    // Windows内存加载比较复杂，使用临时文件方案
-    char temp_path[MAX_PATH];
-    DWORD ret = GetTempPathA(MAX_PATH, temp_path);
-    if (ret == 0 || ret > MAX_PATH) {
-        memdl_set_error("Failed to get temp path");
-        return NULL;
+// 不超过 240 字节的输入
+static uint64_t memdl_xxh3_short(const unsigned char *input, const size_t len) {
+    const unsigned char *secret = memdl_xxh3_secret;
+    if (len == 0) {
+        return memdl_xxh64_avalanche(memdl_read64(secret + 56) ^ memdl_read64(secret + 64));
     }
+    if (len <= 3) {
+        const uint32_t combined = ((uint32_t) input[0] << 16) | ((uint32_t) input[len >> 1] << 24) |
+                                  (uint32_t) input[len - 1] | ((uint32_t) len << 8);
+        return memdl_xxh64_avalanche(combined ^ (uint64_t) (memdl_read32(secret) ^ memdl_read32(secret + 4)));
+    }
+    if (len <= 8) {
+        const uint64_t input64 = memdl_read32(input + len - 4) + ((uint64_t) memdl_read32(input) << 32);
+        return memdl_xxh3_rrmxmx(input64 ^ (memdl_read64(secret + 8) ^ memdl_read64(secret + 16)), len);
+    }
+    if (len <= 16) {
+        const uint64_t lo = memdl_read64(input) ^ (memdl_read64(secret + 24) ^ memdl_read64(secret + 32));
+        const uint64_t hi = memdl_read64(input + len - 8) ^ (memdl_read64(secret + 40) ^ memdl_read64(secret + 48));
+        return memdl_xxh3_avalanche(len + __builtin_bswap64(lo) + hi + memdl_mul128_fold64(lo, hi));
+    }
+    uint64_t acc = len * MEMDL_PRIME64_1;
+    if (len <= 128) {
+        for (size_t i = 0; i <= (len - 1) / 32; i++) {
+            acc += memdl_xxh3_mix16(input + 16 * i, secret + 32 * i);
+            acc += memdl_xxh3_mix16(input + len - 16 * (i + 1), secret + 32 * i + 16);
+        }
+        return memdl_xxh3_avalanche(acc);
+    }
+    for (size_t i = 0; i < 8; i++) {
+        acc += memdl_xxh3_mix16(input + 16 * i, secret + 16 * i);
+    }
+    acc = memdl_xxh3_avalanche(acc);
+    uint64_t acc_end = memdl_xxh3_mix16(input + len - 16, secret + 136 - 17);
+    for (size_t i = 8; i < len / 16; i++) {
+        acc_end += memdl_xxh3_mix16(input + 16 * i, secret + 16 * (i - 8) + 3);
+    }
+    return memdl_xxh3_avalanche(acc + acc_end);
+}
 
-    char temp_file[MAX_PATH];
-    if (GetTempFileNameA(temp_path, "memdl", 0, temp_file) == 0) {
-        memdl_set_error("Failed to create temp file");
-        return NULL;
+#if !defined(MEMDL_XXH3_X86) && !defined(MEMDL_XXH3_NEON)
+static void memdl_xxh3_acc_scalar(uint64_t *acc, const unsigned char *input, const unsigned char *secret,
+                                  const size_t stripes) {
+    for (size_t n = 0; n < stripes; n++, input += MEMDL_XXH3_STRIPE, secret += 8) {
+        for (size_t i = 0; i < 8; i++) {
+            const uint64_t data = memdl_read64(input + 8 * i);
+            const uint64_t key = data ^ memdl_read64(secret + 8 * i);
+            acc[i ^ 1] += data;
+            acc[i] += (key & 0xffffffffu) * (key >> 32);
+        }
     }
+}
 
-    // 写入临时文件
-    HANDLE hFile = CreateFileA(temp_file, GENERIC_WRITE, 0, NULL,
-                               CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hFile == INVALID_HANDLE_VALUE) {
-        memdl_set_error("Failed to create temp file");
-        return NULL;
+static void memdl_xxh3_scramble_scalar(uint64_t *acc, const unsigned char *secret) {
+    for (size_t i = 0; i < 8; i++) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= memdl_read64(secret + 8 * i);
+        acc[i] = a * MEMDL_PRIME32_1;
     }
+}
+#endif
 
-    DWORD written;
-    if (!WriteFile(hFile, so_data, (DWORD) so_size, &written, NULL) ||
-        written != so_size) {
-        CloseHandle(hFile);
-        DeleteFileA(temp_file);
-        memdl_set_error("Failed to write temp file");
-        return NULL;
+#ifdef MEMDL_XXH3_X86
+static void memdl_xxh3_acc_sse2(uint64_t *acc, const unsigned char *input, const unsigned char *secret,
+                                const size_t stripes) {
+    __m128i a[4];
+    for (int i = 0; i < 4; i++) a[i] = _mm_loadu_si128((const __m128i *) acc + i);
+    for (size_t n = 0; n < stripes; n++, input += MEMDL_XXH3_STRIPE, secret += 8) {
+        for (int i = 0; i < 4; i++) {
+            const __m128i data = _mm_loadu_si128((const __m128i *) input + i);
+            const __m128i key = _mm_xor_si128(data, _mm_loadu_si128((const __m128i *) secret + i));
+            const __m128i product = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+            a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
     }
-    CloseHandle(hFile);
+    for (int i = 0; i < 4; i++) _mm_storeu_si128((__m128i *) acc + i, a[i]);
+}
 
-    // 加载DLL
-    HMODULE handle = LoadLibraryA(temp_file);
+static void memdl_xxh3_scramble_sse2(uint64_t *acc, const unsigned char *secret) {
+    const __m128i prime = _mm_set1_epi32((int) MEMDL_PRIME32_1);
+    for (int i = 0; i < 4; i++) {
+        __m128i a = _mm_loadu_si128((const __m128i *) acc + i);
+        a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+        a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i *) secret + i));
+        const __m128i lo = _mm_mul_epu32(a, prime);
+        const __m128i hi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        _mm_storeu_si128((__m128i *) acc + i, _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+    }
+}
 
-    // 删除临时文件
-    DeleteFileA(temp_file);
+__attribute__((target("avx2")))
+static void memdl_xxh3_acc_avx2(uint64_t *acc, const unsigned char *input, const unsigned char *secret,
+                                const size_t stripes) {
+    __m256i a0 = _mm256_loadu_si256((const __m256i *) acc);
+    __m256i a1 = _mm256_loadu_si256((const __m256i *) acc + 1);
+    for (size_t n = 0; n < stripes; n++, input += MEMDL_XXH3_STRIPE, secret += 8) {
+        const __m256i d0 = _mm256_loadu_si256((const __m256i *) input);
+        const __m256i d1 = _mm256_loadu_si256((const __m256i *) input + 1);
+        const __m256i k0 = _mm256_xor_si256(d0, _mm256_loadu_si256((const __m256i *) secret));
+        const __m256i k1 = _mm256_xor_si256(d1, _mm256_loadu_si256((const __m256i *) secret + 1));
+        const __m256i p0 = _mm256_mul_epu32(k0, _mm256_srli_epi64(k0, 32));
+        const __m256i p1 = _mm256_mul_epu32(k1, _mm256_srli_epi64(k1, 32));
+        a0 = _mm256_add_epi64(a0, _mm256_add_epi64(p0, _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2))));
+        a1 = _mm256_add_epi64(a1, _mm256_add_epi64(p1, _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+    _mm256_storeu_si256((__m256i *) acc, a0);
+    _mm256_storeu_si256((__m256i *) acc + 1, a1);
+}
 
-    if (!handle) {
-        memdl_set_error_format("LoadLibrary failed: %lu", GetLastError());
+__attribute__((target("avx2")))
+static void memdl_xxh3_scramble_avx2(uint64_t *acc, const unsigned char *secret) {
+    const __m256i prime = _mm256_set1_epi32((int) MEMDL_PRIME32_1);
+    for (int i = 0; i < 2; i++) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) acc + i);
+        a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+        a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i *) secret + i));
+        const __m256i lo = _mm256_mul_epu32(a, prime);
+        const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+        _mm256_storeu_si256((__m256i *) acc + i, _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
     }
+}
+#endif
 
-    return (memdl_handle_t) handle;
+#ifdef MEMDL_XXH3_NEON
+static void memdl_xxh3_acc_neon(uint64_t *acc, const unsigned char *input, const unsigned char *secret,
+                                const size_t stripes) {
+    uint64x2_t a[4];
+    for (int i = 0; i < 4; i++) a[i] = vld1q_u64(acc + 2 * i);
+    for (size_t n = 0; n < stripes; n++, input += MEMDL_XXH3_STRIPE, secret += 8) {
+        for (int i = 0; i < 4; i++) {
+            const uint64x2_t data = vreinterpretq_u64_u8(vld1q_u8(input + 16 * i));
+            const uint64x2_t key = veorq_u64(data, vreinterpretq_u64_u8(vld1q_u8(secret + 16 * i)));
+            const uint64x2_t sum = vmlal_u32(vextq_u64(data, data, 1), vmovn_u64(key), vshrn_n_u64(key, 32));
+            a[i] = vaddq_u64(a[i], sum);
+        }
+    }
+    for (int i = 0; i < 4; i++) vst1q_u64(acc + 2 * i, a[i]);
 }
 
-void *memdl_sym(memdl_handle_t handle, const char *symbol) {
-    if (!handle) {
-        memdl_set_error("Invalid handle");
-        return NULL;
+static void memdl_xxh3_scramble_neon(uint64_t *acc, const unsigned char *secret) {
+    const uint32x2_t prime = vdup_n_u32(MEMDL_PRIME32_1);
+    for (int i = 0; i < 4; i++) {
+        uint64x2_t a = vld1q_u64(acc + 2 * i);
+        a = veorq_u64(a, vshrq_n_u64(a, 47));
+        a = veorq_u64(a, vreinterpretq_u64_u8(vld1q_u8(secret + 16 * i)));
+        const uint64x2_t hi = vshlq_n_u64(vmull_u32(vshrn_n_u64(a, 32), prime), 32);
+        vst1q_u64(acc + 2 * i, vmlal_u32(hi, vmovn_u64(a), prime));
     }
-    return (void *) GetProcAddress((HMODULE) handle, symbol);
 }
+#endif
 
-int memdl_close(memdl_handle_t handle) {
-    if (!handle) {
-        memdl_set_error("Invalid handle");
-        return -1;
+// 按 CPU 选择长输入的累加实现；__builtin_cpu_supports 只是查询 libgcc 已填好的特性表，开销可以忽略
+static void memdl_xxh3_select(memdl_xxh3_acc_fn *acc, memdl_xxh3_scramble_fn *scramble) {
+#if defined(MEMDL_XXH3_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        *acc = memdl_xxh3_acc_avx2;
+        *scramble = memdl_xxh3_scramble_avx2;
+    } else {
+        *acc = memdl_xxh3_acc_sse2;
+        *scramble = memdl_xxh3_scramble_sse2;
     }
-    return FreeLibrary((HMODULE) handle) ? 0 : -1;
+#elif defined(MEMDL_XXH3_NEON)
+    *acc = memdl_xxh3_acc_neon;
+    *scramble = memdl_xxh3_scramble_neon;
+#else
+    *acc = memdl_xxh3_acc_scalar;
+    *scramble = memdl_xxh3_scramble_scalar;
+#endif
 }
 
-#elif defined(MEMDL_ANDROID)
+// 计算摘要；sink 非 NULL 时每算完一段就把这段交给 sink（数据只从内存读一次），sink 失败时返回 -1
+static int memdl_digest_copy(const void *data, const size_t len, uint64_t *digest, const memdl_sink_fn sink,
+                             void *ctx) {
+    const unsigned char *input = data;
+    if (len <= 240) {
+        *digest = memdl_xxh3_short(input, len);
+        return sink && len && sink(ctx, input, len) != 0 ? -1 : 0;
+    }
+    memdl_xxh3_acc_fn accumulate;
+    memdl_xxh3_scramble_fn scramble;
+    memdl_xxh3_select(&accumulate, &scramble);
+    const unsigned char *secret = memdl_xxh3_secret;
+    uint64_t acc[8] = {MEMDL_PRIME32_3, MEMDL_PRIME64_1, MEMDL_PRIME64_2, MEMDL_PRIME64_3,
+                       MEMDL_PRIME64_4, MEMDL_PRIME32_2, MEMDL_PRIME64_5, MEMDL_PRIME32_1};
+    const size_t blocks = (len - 1) / MEMDL_XXH3_BLOCK;
+    size_t flushed = 0;
+    for (size_t n = 0; n < blocks; n++) {
+        accumulate(acc, input + n * MEMDL_XXH3_BLOCK, secret, MEMDL_XXH3_BLOCK_STRIPES);
+        scramble(acc, secret + MEMDL_XXH3_SECRET_SIZE - MEMDL_XXH3_STRIPE);
+        if (sink && (n + 1) % MEMDL_XXH3_CHUNK_BLOCKS == 0) {
+            const size_t end = (n + 1) * MEMDL_XXH3_BLOCK;
+            if (sink(ctx, input + flushed, end - flushed) != 0) return -1;
+            flushed = end;
+        }
+    }
+    // 最后不完整的块，再以最后 64 字节作为一个条带收尾
+    accumulate(acc, input + blocks * MEMDL_XXH3_BLOCK, secret,
+               ((len - 1) - blocks * MEMDL_XXH3_BLOCK) / MEMDL_XXH3_STRIPE);
+    accumulate(acc, input + len - MEMDL_XXH3_STRIPE, secret + MEMDL_XXH3_SECRET_SIZE - MEMDL_XXH3_STRIPE - 7, 1);
 
-static bool is_android_7_plus() {
-    char version[PROP_VALUE_MAX] = {0};
-    if (__system_property_get("ro.build.version.sdk", version) <= 0) {
-        return false;
+    uint64_t h = len * MEMDL_PRIME64_1;
+    for (size_t i = 0; i < 4; i++) {
+        h += memdl_mul128_fold64(acc[2 * i] ^ memdl_read64(secret + 11 + 16 * i),
+                                 acc[2 * i + 1] ^ memdl_read64(secret + 19 + 16 * i));
     }
-    return atoi(version) >= 24; // Android 7.0 = API 24
+    *digest = memdl_xxh3_avalanche(h);
+    return sink && sink(ctx, input + flushed, len - flushed) != 0 ? -1 : 0;
 }
 
-memdl_handle_t memdl_open_file(const char *filename, const int flags) {
-    int dl_flags = (flags & MEMDL_NOW) ? RTLD_NOW : RTLD_LAZY;
-    dl_flags |= (flags & MEMDL_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
-    return dlopen(filename, dl_flags);
+uint64_t memdl_digest(const void *data, const size_t size) {
+    uint64_t digest = 0;
+    memdl_digest_copy(data, size, &digest, NULL, NULL);
+    return digest;
 }
 
-memdl_handle_t memdl_open(const void *so_data, size_t so_size, int flags) {
-    if (memdl_validate(so_data, so_size) != 0) {
-        return NULL;
+// ELF 符号哈希（DT_GNU_HASH / DT_HASH）
+static uint32_t memdl_gnu_hash(const char *name) {
+    uint32_t h = 5381;
+    for (const unsigned char *p = (const unsigned char *) name; *p; p++) {
+        h = h * 33 + *p;
     }
+    return h;
+}
 
-    int dl_flags = (flags & MEMDL_NOW) ? RTLD_NOW : RTLD_LAZY;
-    dl_flags |= (flags & MEMDL_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
+static uint32_t memdl_sysv_hash(const char *name) {
+    uint32_t h = 0;
+    for (const unsigned char *p = (const unsigned char *) name; *p; p++) {
+        h = (h << 4) + *p;
+        const uint32_t g = h & 0xf0000000;
+        if (g) h ^= g >> 24;
+        h &= ~g;
+    }
+    return h;
+}
 
-    // Android 7+ 使用memfd方案
-    if (is_android_7_plus()) {
-// 定义MFD_CLOEXEC常量（如果系统头文件没有定义）
-#ifndef MFD_CLOEXEC
-#define MFD_CLOEXEC 0x0001U
+// 平台检测
+int memdl_get_platform(void) {
+#if defined(MEMDL_WINDOWS)
+    return MEMDL_PLATFORM_WINDOWS;
+#elif defined(MEMDL_IOS)
+    return MEMDL_PLATFORM_IOS;
+#elif defined(MEMDL_MACOS)
+    return MEMDL_PLATFORM_MACOS;
+#elif defined(MEMDL_ANDROID)
+    return MEMDL_PLATFORM_ANDROID;
+#elif defined(MEMDL_LINUX)
+    return MEMDL_PLATFORM_LINUX;
+#else
+    return MEMDL_PLATFORM_UNKNOWN;
 #endif
+}
 
-int fd = syscall(SYS_memfd_create, "memdl_lib", MFD_CLOEXEC);
-        if (fd>= 0) {
-            ssize_t written = write(fd, so_data, so_size);
-            if (written == (ssize_t)so_size) {
-                lseek(fd, 0, SEEK_SET);
+// ---------------------------------------------------------------------------
+// 镜像描述符：一次解析并校验文件头、程序头与动态段，校验、架构识别、符号查找和加载都复用
+// ---------------------------------------------------------------------------
 
-                android_dlextinfo info = {
-                    .flags = ANDROID_DLEXT_USE_LIBRARY_FD,
-                    .library_fd = fd,
-                };
+// 不依赖 <elf.h>，在所有平台上解析任意字节序和位数的 ELF
+#define MEMDL_ELF_PT_LOAD      1
+#define MEMDL_ELF_PT_DYNAMIC   2
+#define MEMDL_ELF_DT_NULL      0
+#define MEMDL_ELF_DT_NEEDED    1
+#define MEMDL_ELF_DT_HASH      4
+#define MEMDL_ELF_DT_STRTAB    5
+#define MEMDL_ELF_DT_SYMTAB    6
+#define MEMDL_ELF_DT_STRSZ     10
+#define MEMDL_ELF_DT_SYMENT    11
+#define MEMDL_ELF_DT_SONAME    14
+#define MEMDL_ELF_DT_GNU_HASH  0x6ffffef5
+#define MEMDL_ELF_DT_VERSYM    0x6ffffff0
+#define MEMDL_ELF_DT_VERDEF    0x6ffffffc
+#define MEMDL_ELF_DT_VERDEFNUM 0x6ffffffd
 
-                void* handle = android_dlopen_ext("/memfd", dl_flags, &info);
-                close(fd);
+#define MEMDL_NO_OFFSET ((size_t) -1)
 
-                if (handle) return handle;
-            } else {
-                close(fd);
-            }
-        }
+struct memdl_image {
+    const unsigned char *data;
+    size_t size;
+    uint64_t hash;              // 内容哈希，memdl_image_prepare 时计算一次
+    int format;                 // MEMDL_FORMAT_*
+    int arch;                   // MEMDL_ARCH_*
+    int bits;
+    int big_endian;
+    int machine;
+    int type;
+    // 以下仅 ELF；表的位置均为文件偏移，MEMDL_NO_OFFSET 表示不存在
+    size_t phoff;
+    size_t phentsize;
+    size_t phnum;
+    size_t segments;            // PT_LOAD 个数
+    size_t dyn_off;
+    size_t dyn_count;
+    size_t strtab_off;
+    size_t strsz;
+    size_t symtab_off;
+    size_t syment;
+    size_t hash_off;            // DT_HASH
+    size_t gnu_hash_off;        // DT_GNU_HASH
+    size_t versym_off;
+    size_t verdef_off;          // DT_VERDEF
+    size_t verdefnum;
+    size_t needed;              // DT_NEEDED 个数
+    size_t soname;              // DT_SONAME 在字符串表中的偏移
+};
+
+// 按镜像字节序读取 width 字节的无符号整数
+static uint64_t memdl_image_read(const memdl_image_t *img, const size_t off, const size_t width) {
+    const unsigned char *p = img->data + off;
+    uint64_t v = 0;
+    for (size_t i = 0; i < width; i++) {
+        v |= (uint64_t) p[img->big_endian ? width - 1 - i : i] << (8 * i);
     }
+    return v;
+}
 
-// 降级方案：临时文件
-char template[] = "/data/local/tmp/memdl_tmp";
-int fd = mkstemp(template);
-    if (fd>= 0) {
-        if (write(fd, so_data, so_size) == (ssize_t)so_size) {
-            void* handle = dlopen(template, dl_flags);
-            unlink(template);
-            close(fd);
+typedef struct {
+    uint32_t type;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t filesz;
+    uint64_t memsz;
+} memdl_phdr_t;
 
-            if (!handle) {
-                set_error(dlerror());
-            }
-            return handle;
-        }
-        close(fd);
-        unlink(template);
+static void memdl_image_phdr(const memdl_image_t *img, const size_t i, memdl_phdr_t *ph) {
+    const size_t off = img->phoff + i * img->phentsize;
+    ph->type = (uint32_t) memdl_image_read(img, off, 4);
+    if (img->bits == 64) {
+        ph->flags = (uint32_t) memdl_image_read(img, off + 4, 4);
+        ph->offset = memdl_image_read(img, off + 8, 8);
+        ph->vaddr = memdl_image_read(img, off + 16, 8);
+        ph->filesz = memdl_image_read(img, off + 32, 8);
+        ph->memsz = memdl_image_read(img, off + 40, 8);
+    } else {
+        ph->offset = memdl_image_read(img, off + 4, 4);
+        ph->vaddr = memdl_image_read(img, off + 8, 4);
+        ph->filesz = memdl_image_read(img, off + 16, 4);
+        ph->memsz = memdl_image_read(img, off + 20, 4);
+        ph->flags = (uint32_t) memdl_image_read(img, off + 24, 4);
     }
-
-set_error("All loading methods failed");
-    return NULL;
 }
 
-void *memdl_sym(memdl_handle_t handle, const char *symbol) {
-    if (!handle) {
-        set_error("Invalid handle");
-        return NULL;
-    }
-    void *sym = dlsym(handle, symbol);
-    if (!sym) {
-        set_error(dlerror());
-    }
-    return sym;
+static void memdl_image_dyn(const memdl_image_t *img, const size_t i, uint64_t *tag, uint64_t *val) {
+    const size_t width = img->bits / 8;
+    const size_t off = img->dyn_off + i * 2 * width;
+    *tag = memdl_image_read(img, off, width);
+    *val = memdl_image_read(img, off + width, width);
 }
 
-int memdl_close(memdl_handle_t handle) {
-    if (!handle) {
-        set_error("Invalid handle");
-        return -1;
-    }
-    int result = dlclose(handle);
-    if (result != 0) {
-        set_error(dlerror());
+// 把虚拟地址换算为文件偏移，要求 [vaddr, vaddr + len) 落在某个 PT_LOAD 的文件内容中
+static size_t memdl_image_offset(const memdl_image_t *img, const uint64_t vaddr, const uint64_t len) {
+    for (size_t i = 0; i < img->phnum; i++) {
+        memdl_phdr_t ph;
+        memdl_image_phdr(img, i, &ph);
+        if (ph.type == MEMDL_ELF_PT_LOAD && vaddr >= ph.vaddr && vaddr - ph.vaddr <= ph.filesz &&
+            len <= ph.filesz - (vaddr - ph.vaddr)) {
+            return (size_t) (ph.offset + (vaddr - ph.vaddr));
+        }
     }
-    return result;
+    return MEMDL_NO_OFFSET;
 }
 
-#elif defined(MEMDL_IOS) || defined(MEMDL_MACOS)
+// 字符串表中 off 处是否为完整的字符串
+static int memdl_image_string_ok(const memdl_image_t *img, const uint64_t off) {
+    return img->strtab_off != MEMDL_NO_OFFSET && off < img->strsz && memchr(img->data + img->strtab_off + off, '\0', img->strsz - (size_t) off) != NULL;
+}
 
-memdl_handle_t memdl_open_file(const char *filename, const int flags) {
-    int dl_flags = (flags & MEMDL_NOW) ? RTLD_NOW : RTLD_LAZY;
-    dl_flags |= (flags & MEMDL_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
-    return dlopen(filename, dl_flags);
+static int memdl_format_error(const char *what) {
+    memdl_set_error_code(MEMDL_ERR_FORMAT, 0, "%s", what);
+    return -1;
 }
 
-memdl_handle_t memdl_open(const void *so_data, size_t so_size, int flags) {
-    if (memdl_validate(so_data, so_size) != 0) {
-        return NULL;
+static int memdl_elf_arch(const int machine) {
+    switch (machine) {
+        case 3: return MEMDL_ARCH_X86;        // EM_386
+        case 62: return MEMDL_ARCH_X86_64;    // EM_X86_64
+        case 40: return MEMDL_ARCH_ARM;       // EM_ARM
+        case 183: return MEMDL_ARCH_ARM64;    // EM_AARCH64
+        default: return MEMDL_ARCH_UNKNOWN;
     }
+}
 
+// 只解析文件头：格式、位数、字节序、机器类型
+static int memdl_image_parse_header(memdl_image_t *img, const void *so_data, const size_t so_size) {
+    memset(img, 0, sizeof(*img));
+    if (!so_data || so_size < 4) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid data or size");
+        return -1;
+    }
+    const unsigned char *data = so_data;
+    img->data = data;
+    img->size = so_size;
+
+    // ELF (Linux/Android)
+    if (data[0] == 0x7F && data[1] == 'E' && data[2] == 'L' && data[3] == 'F') {
+        if (so_size < 52 || (data[4] != 1 && data[4] != 2) || (data[5] != 1 && data[5] != 2)) {
+            return memdl_format_error("Invalid ELF identification");
+        }
+        img->format = MEMDL_FORMAT_ELF;
+        img->bits = data[4] == 2 ? 64 : 32;
+        img->big_endian = data[5] == 2;
+        if (img->bits == 64 && so_size < 64) {
+            return memdl_format_error("Truncated ELF header");
+        }
+        img->type = (int) memdl_image_read(img, 16, 2);
+        img->machine = (int) memdl_image_read(img, 18, 2);
+        img->arch = memdl_elf_arch(img->machine);
+        if (img->bits == 64) {
+            img->phoff = (size_t) memdl_image_read(img, 32, 8);
+            img->phentsize = (size_t) memdl_image_read(img, 54, 2);
+            img->phnum = (size_t) memdl_image_read(img, 56, 2);
+        } else {
+            img->phoff = (size_t) memdl_image_read(img, 28, 4);
+            img->phentsize = (size_t) memdl_image_read(img, 42, 2);
+            img->phnum = (size_t) memdl_image_read(img, 44, 2);
+        }
+        return 0;
+    }
+
+    // Mach-O (macOS/iOS)：按小端读出的魔数区分位数与字节序
+    uint32_t magic;
+    memcpy(&magic, data, sizeof(magic));
+    const unsigned char le[4] = {0x01, 0x00, 0x00, 0x00};
+    uint32_t one;
+    memcpy(&one, le, sizeof(one));
+    if (one != 1) {
+        magic = (uint32_t) data[0] | (uint32_t) data[1] << 8 | (uint32_t) data[2] << 16 | (uint32_t) data[3] << 24;
+    }
+    if (magic == 0xFEEDFACE || magic == 0xFEEDFACF || magic == 0xCEFAEDFE || magic == 0xCFFAEDFE) {
+        if (so_size < 28) {
+            return memdl_format_error("Truncated Mach-O header");
+        }
+        img->format = MEMDL_FORMAT_MACHO;
+        img->bits = (magic == 0xFEEDFACF || magic == 0xCFFAEDFE) ? 64 : 32;
+        img->big_endian = magic == 0xCEFAEDFE || magic == 0xCFFAEDFE;
+        img->machine = (int) memdl_image_read(img, 4, 4);
+        img->type = (int) memdl_image_read(img, 12, 4);
+        switch ((uint32_t) img->machine) {
+            case 7: img->arch = MEMDL_ARCH_X86; break;
+            case 0x01000007: img->arch = MEMDL_ARCH_X86_64; break;
+            case 12: img->arch = MEMDL_ARCH_ARM; break;
+            case 0x0100000C: img->arch = MEMDL_ARCH_ARM64; break;
+            default: img->arch = MEMDL_ARCH_UNKNOWN; break;
+        }
+        return 0;
+    }
+
+    // PE (Windows)：DOS 头 e_lfanew 指向 "PE\0\0" 签名和 COFF 头
+    if (data[0] == 'M' && data[1] == 'Z') {
+        if (so_size < 0x40) {
+            return memdl_format_error("Truncated DOS header");
+        }
+        img->format = MEMDL_FORMAT_PE;
+        const size_t lfanew = (size_t) memdl_image_read(img, 0x3C, 4);
+        if (lfanew > so_size || so_size - lfanew < 26 || memcmp(data + lfanew, "PE\0\0", 4) != 0) {
+            return memdl_format_error("Missing PE signature");
+        }
+        img->machine = (int) memdl_image_read(img, lfanew + 4, 2);
+        img->type = (int) memdl_image_read(img, lfanew + 22, 2);
+        img->bits = memdl_image_read(img, lfanew + 24, 2) == 0x20B ? 64 : 32;
+        switch (img->machine) {
+            case 0x14C: img->arch = MEMDL_ARCH_X86; break;
+            case 0x8664: img->arch = MEMDL_ARCH_X86_64; break;
+            case 0x1C0: case 0x1C4: img->arch = MEMDL_ARCH_ARM; break;
+            case 0xAA64: img->arch = MEMDL_ARCH_ARM64; break;
+            default: img->arch = MEMDL_ARCH_UNKNOWN; break;
+        }
+        return 0;
+    }
+
+    return memdl_format_error("Not a valid executable format");
+}
+
+// 完整解析：ELF 还要校验程序头、动态段及其引用的表都在镜像范围内
+static int memdl_image_parse(memdl_image_t *img, const void *so_data, const size_t so_size) {
+    if (memdl_image_parse_header(img, so_data, so_size) != 0) {
+        return -1;
+    }
+    img->dyn_off = img->strtab_off = img->symtab_off = MEMDL_NO_OFFSET;
+    img->hash_off = img->gnu_hash_off = img->versym_off = img->verdef_off = img->soname = MEMDL_NO_OFFSET;
+    if (img->format != MEMDL_FORMAT_ELF) {
+        return 0;
+    }
+
+    if (img->phentsize != (img->bits == 64 ? 56u : 32u) || img->phoff > so_size ||
+        img->phnum * img->phentsize > so_size - img->phoff) {
+        return memdl_format_error("Program headers out of range");
+    }
+    memdl_phdr_t dynamic = {0};
+    for (size_t i = 0; i < img->phnum; i++) {
+        memdl_phdr_t ph;
+        memdl_image_phdr(img, i, &ph);
+        if (ph.type == MEMDL_ELF_PT_LOAD) {
+            if (ph.filesz > ph.memsz || ph.offset > so_size || ph.filesz > so_size - ph.offset) {
+                return memdl_format_error("PT_LOAD segment out of range");
+            }
+            img->segments++;
+        } else if (ph.type == MEMDL_ELF_PT_DYNAMIC) {
+            if (ph.offset > so_size || ph.filesz > so_size - ph.offset) {
+                return memdl_format_error("Dynamic section out of range");
+            }
+            dynamic = ph;
+            img->dyn_off = (size_t) ph.offset;
+        }
+    }
+    if (img->dyn_off == MEMDL_NO_OFFSET) {
+        return 0;
+    }
+
+    // 扫描动态段，记录符号查找和依赖解析需要的表
+    const size_t entsize = 2 * (size_t) (img->bits / 8);
+    const size_t max_count = (size_t) dynamic.filesz / entsize;
+    uint64_t strtab = 0, symtab = 0, hash = 0, gnu_hash = 0, versym = 0, verdef = 0, soname = 0;
+    int has_soname = 0;
+    img->syment = img->bits == 64 ? 24 : 16;
+    while (img->dyn_count < max_count) {
+        uint64_t tag, val;
+        memdl_image_dyn(img, img->dyn_count, &tag, &val);
+        if (tag == MEMDL_ELF_DT_NULL) break;
+        img->dyn_count++;
+        switch (tag) {
+            case MEMDL_ELF_DT_NEEDED: img->needed++; break;
+            case MEMDL_ELF_DT_STRTAB: strtab = val; break;
+            case MEMDL_ELF_DT_STRSZ: img->strsz = (size_t) val; break;
+            case MEMDL_ELF_DT_SYMTAB: symtab = val; break;
+            case MEMDL_ELF_DT_SYMENT: img->syment = (size_t) val; break;
+            case MEMDL_ELF_DT_HASH: hash = val; break;
+            case MEMDL_ELF_DT_GNU_HASH: gnu_hash = val; break;
+            case MEMDL_ELF_DT_VERSYM: versym = val; break;
+            case MEMDL_ELF_DT_VERDEF: verdef = val; break;
+            case MEMDL_ELF_DT_VERDEFNUM: img->verdefnum = (size_t) val; break;
+            case MEMDL_ELF_DT_SONAME: soname = val; has_soname = 1; break;
+            default: break;
+        }
+    }
+    if (strtab) {
+        img->strtab_off = memdl_image_offset(img, strtab, img->strsz);
+        if (img->strtab_off == MEMDL_NO_OFFSET) {
+            return memdl_format_error("Dynamic string table out of range");
+        }
+    }
+    if (symtab) img->symtab_off = memdl_image_offset(img, symtab, img->syment);
+    if (hash) img->hash_off = memdl_image_offset(img, hash, 8);
+    if (gnu_hash) img->gnu_hash_off = memdl_image_offset(img, gnu_hash, 16);
+    if (versym) img->versym_off = memdl_image_offset(img, versym, 2);
+    if (verdef) img->verdef_off = memdl_image_offset(img, verdef, 20);
+
+    // 依赖名和 SONAME 必须是字符串表内完整的字符串
+    if ((img->needed || has_soname) && img->strtab_off == MEMDL_NO_OFFSET) {
+        return memdl_format_error("Dynamic section has no string table");
+    }
+    if (has_soname) {
+        if (!memdl_image_string_ok(img, soname)) {
+            return memdl_format_error("Malformed DT_SONAME entry");
+        }
+        img->soname = (size_t) soname;
+    }
+    for (size_t i = 0; i < img->dyn_count; i++) {
+        uint64_t tag, val;
+        memdl_image_dyn(img, i, &tag, &val);
+        if (tag == MEMDL_ELF_DT_NEEDED && !memdl_image_string_ok(img, val)) {
+            return memdl_format_error("Malformed DT_NEEDED entry");
+        }
+    }
+    return 0;
+}
+
+// 读取动态段中指定标签（DT_NEEDED/DT_SONAME）的字符串，返回总个数，最多写入 max 个；字符串指向镜像内部
+static size_t memdl_image_dyn_strings(const memdl_image_t *img, const uint64_t tag, const char **out,
+                                      const size_t max) {
+    size_t count = 0;
+    for (size_t i = 0; i < img->dyn_count; i++) {
+        uint64_t t, val;
+        memdl_image_dyn(img, i, &t, &val);
+        if (t != tag) continue;
+        if (count < max) out[count] = (const char *) img->data + img->strtab_off + val;
+        count++;
+    }
+    return count;
+}
+
+int memdl_validate(const void *so_data, const size_t so_size) {
+    memdl_image_t img;
+    return memdl_image_parse(&img, so_data, so_size);
+}
+
+int memdl_get_arch(const void *so_data, const size_t so_size) {
+    memdl_image_t img;
+    return memdl_image_parse_header(&img, so_data, so_size) == 0 ? img.arch : MEMDL_ARCH_UNKNOWN;
+}
+
+memdl_image_t *memdl_image_prepare(const void *so_data, const size_t so_size) {
+    memdl_image_t img;
+    if (memdl_image_parse(&img, so_data, so_size) != 0) {
+        return NULL;
+    }
+    memdl_image_t *image = malloc(sizeof(memdl_image_t));
+    if (!image) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return NULL;
+    }
+    *image = img;
+    image->hash = memdl_digest(so_data, so_size);
+    return image;
+}
+
+int memdl_image_get_info(const memdl_image_t *image, memdl_image_info_t *info) {
+    if (!image || !info) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    info->format = image->format;
+    info->arch = image->arch;
+    info->bits = image->bits;
+    info->big_endian = image->big_endian;
+    info->machine = image->machine;
+    info->type = image->type;
+    info->segments = image->segments;
+    info->needed = image->needed;
+    info->soname = image->soname != MEMDL_NO_OFFSET
+                       ? (const char *) image->data + image->strtab_off + image->soname
+                       : NULL;
+    return 0;
+}
+
+void memdl_image_release(memdl_image_t *image) {
+    free(image);
+}
+
+// ---------------------------------------------------------------------------
+// 导出符号内省：直接读取镜像中的 .dynsym/.dynstr，不映射也不执行任何代码
+// ---------------------------------------------------------------------------
+
+#define MEMDL_ELF_STB_GLOBAL      1
+#define MEMDL_ELF_STB_WEAK        2
+#define MEMDL_ELF_STB_GNU_UNIQUE  10
+#define MEMDL_ELF_STV_DEFAULT     0
+#define MEMDL_ELF_STV_PROTECTED   3
+#define MEMDL_ELF_VERSYM_HIDDEN   0x8000
+
+typedef struct {
+    uint32_t name;
+    int info;
+    int other;
+    int shndx;
+    uint64_t value;
+    uint64_t size;
+} memdl_elf_sym_t;
+
+// 带边界检查的读取，越界返回 -1
+static int memdl_image_get(const memdl_image_t *img, const uint64_t off, const size_t width, uint64_t *v) {
+    if (off > img->size || width > img->size - off) {
+        return -1;
+    }
+    *v = memdl_image_read(img, (size_t) off, width);
+    return 0;
+}
+
+static int memdl_image_sym(const memdl_image_t *img, const uint64_t idx, memdl_elf_sym_t *sym) {
+    const size_t min_size = img->bits == 64 ? 24 : 16;
+    if (img->symtab_off == MEMDL_NO_OFFSET || img->syment < min_size) {
+        return -1;
+    }
+    const uint64_t off = img->symtab_off + idx * img->syment;
+    if (off > img->size || min_size > img->size - off) {
+        return -1;
+    }
+    sym->name = (uint32_t) memdl_image_read(img, (size_t) off, 4);
+    if (img->bits == 64) {
+        sym->info = img->data[off + 4];
+        sym->other = img->data[off + 5];
+        sym->shndx = (int) memdl_image_read(img, (size_t) off + 6, 2);
+        sym->value = memdl_image_read(img, (size_t) off + 8, 8);
+        sym->size = memdl_image_read(img, (size_t) off + 16, 8);
+    } else {
+        sym->value = memdl_image_read(img, (size_t) off + 4, 4);
+        sym->size = memdl_image_read(img, (size_t) off + 8, 4);
+        sym->info = img->data[off + 12];
+        sym->other = img->data[off + 13];
+        sym->shndx = (int) memdl_image_read(img, (size_t) off + 14, 2);
+    }
+    return 0;
+}
+
+// 已定义、全局可见且名称有效的符号才算导出
+static int memdl_image_sym_exported(const memdl_image_t *img, const memdl_elf_sym_t *sym) {
+    const int bind = sym->info >> 4;
+    const int vis = sym->other & 3;
+    return sym->shndx != 0 && sym->name != 0 && memdl_image_string_ok(img, sym->name) &&
+           (bind == MEMDL_ELF_STB_GLOBAL || bind == MEMDL_ELF_STB_WEAK || bind == MEMDL_ELF_STB_GNU_UNIQUE) &&
+           (vis == MEMDL_ELF_STV_DEFAULT || vis == MEMDL_ELF_STV_PROTECTED);
+}
+
+// 在 DT_VERDEF 中查找版本号对应的名称
+static const char *memdl_image_verdef(const memdl_image_t *img, const uint64_t ndx) {
+    uint64_t off = img->verdef_off;
+    for (size_t i = 0; i < img->verdefnum && off != MEMDL_NO_OFFSET; i++) {
+        uint64_t vd_ndx, vd_aux, vd_next, vda_name;
+        if (memdl_image_get(img, off + 4, 2, &vd_ndx) != 0 || memdl_image_get(img, off + 12, 4, &vd_aux) != 0 ||
+            memdl_image_get(img, off + 16, 4, &vd_next) != 0) {
+            return NULL;
+        }
+        if (vd_ndx == ndx) {
+            if (memdl_image_get(img, off + vd_aux, 4, &vda_name) != 0 || !memdl_image_string_ok(img, vda_name)) {
+                return NULL;
+            }
+            return (const char *) img->data + img->strtab_off + vda_name;
+        }
+        if (vd_next == 0) break;
+        off += vd_next;
+    }
+    return NULL;
+}
+
+static void memdl_image_export_fill(const memdl_image_t *img, const uint64_t idx, const memdl_elf_sym_t *sym,
+                                    memdl_export_t *out) {
+    out->name = (const char *) img->data + img->strtab_off + sym->name;
+    out->version = NULL;
+    out->value = sym->value;
+    out->size = sym->size;
+    out->type = sym->info & 0xf;
+    out->binding = sym->info >> 4;
+    out->default_version = 1;
+    uint64_t versym;
+    if (img->versym_off != MEMDL_NO_OFFSET && memdl_image_get(img, img->versym_off + idx * 2, 2, &versym) == 0) {
+        // 0/1 为本地与全局基版本，没有版本名
+        const uint64_t ndx = versym & ~(uint64_t) MEMDL_ELF_VERSYM_HIDDEN;
+        out->default_version = !(versym & MEMDL_ELF_VERSYM_HIDDEN);
+        if (ndx > 1) out->version = memdl_image_verdef(img, ndx);
+    }
+}
+
+// 由哈希表推算 .dynsym 中的符号数；没有哈希表时假定 .dynstr 紧跟在 .dynsym 之后
+static uint64_t memdl_image_symcount(const memdl_image_t *img) {
+    uint64_t count = 0;
+    if (img->hash_off != MEMDL_NO_OFFSET) {
+        memdl_image_get(img, img->hash_off + 4, 4, &count);
+    } else if (img->gnu_hash_off != MEMDL_NO_OFFSET) {
+        const uint64_t base = img->gnu_hash_off;
+        uint64_t nbuckets, symoffset, bloom_size;
+        if (memdl_image_get(img, base, 4, &nbuckets) != 0 || memdl_image_get(img, base + 4, 4, &symoffset) != 0 ||
+            memdl_image_get(img, base + 8, 4, &bloom_size) != 0) {
+            return 0;
+        }
+        const uint64_t buckets = base + 16 + bloom_size * (uint64_t) (img->bits / 8);
+        const uint64_t chain = buckets + nbuckets * 4;
+        uint64_t last = 0;
+        for (uint64_t i = 0; i < nbuckets; i++) {
+            uint64_t bucket;
+            if (memdl_image_get(img, buckets + i * 4, 4, &bucket) != 0) return 0;
+            if (bucket > last) last = bucket;
+        }
+        if (last < symoffset) {
+            count = symoffset;
+        } else {
+            uint64_t h2 = 0;
+            while (memdl_image_get(img, chain + (last - symoffset) * 4, 4, &h2) == 0 && !(h2 & 1)) {
+                last++;
+            }
+            count = last + 1;
+        }
+    } else if (img->symtab_off != MEMDL_NO_OFFSET && img->strtab_off != MEMDL_NO_OFFSET &&
+               img->strtab_off > img->symtab_off && img->syment) {
+        count = (img->strtab_off - img->symtab_off) / img->syment;
+    }
+    // 不超过镜像中实际能容纳的符号数
+    if (img->symtab_off == MEMDL_NO_OFFSET || !img->syment) {
+        return 0;
+    }
+    const uint64_t room = (img->size - img->symtab_off) / img->syment;
+    return count < room ? count : room;
+}
+
+static int memdl_image_check_elf(const memdl_image_t *image) {
+    if (!image) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid image");
+        return -1;
+    }
+    if (image->format != MEMDL_FORMAT_ELF) {
+        memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Export introspection requires an ELF image");
+        return -1;
+    }
+    return 0;
+}
+
+size_t memdl_image_exports(const memdl_image_t *image, memdl_export_t *exports, const size_t max) {
+    if (memdl_image_check_elf(image) != 0) {
+        return 0;
+    }
+    const uint64_t count = memdl_image_symcount(image);
+    size_t total = 0;
+    for (uint64_t i = 1; i < count; i++) {
+        memdl_elf_sym_t sym;
+        if (memdl_image_sym(image, i, &sym) != 0) break;
+        if (!memdl_image_sym_exported(image, &sym)) continue;
+        if (exports && total < max) memdl_image_export_fill(image, i, &sym, &exports[total]);
+        total++;
+    }
+    return total;
+}
+
+// 比较符号名；多个版本同名时优先默认版本，记住第一个隐藏版本作为后备
+static int memdl_image_export_match(const memdl_image_t *img, const uint64_t idx, const char *name,
+                                    memdl_export_t *out, int *found) {
+    memdl_elf_sym_t sym;
+    if (memdl_image_sym(img, idx, &sym) != 0 || !memdl_image_sym_exported(img, &sym) ||
+        strcmp((const char *) img->data + img->strtab_off + sym.name, name) != 0) {
+        return 0;
+    }
+    memdl_export_t exp;
+    memdl_image_export_fill(img, idx, &sym, &exp);
+    if (!*found || exp.default_version) {
+        *out = exp;
+        *found = 1;
+    }
+    return exp.default_version;
+}
+
+int memdl_image_find_export(const memdl_image_t *image, const char *name, memdl_export_t *out) {
+    if (memdl_image_check_elf(image) != 0) {
+        return -1;
+    }
+    if (!name) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid symbol name");
+        return -1;
+    }
+    memdl_export_t exp;
+    int found = 0;
+    if (image->gnu_hash_off != MEMDL_NO_OFFSET) {
+        // 先查布隆过滤器，再沿哈希链比较
+        const uint64_t base = image->gnu_hash_off;
+        const uint64_t word_bits = (uint64_t) image->bits;
+        uint64_t nbuckets, symoffset, bloom_size, bloom_shift, word, idx, h2;
+        const uint32_t h = memdl_gnu_hash(name);
+        if (memdl_image_get(image, base, 4, &nbuckets) == 0 && memdl_image_get(image, base + 4, 4, &symoffset) == 0 &&
+            memdl_image_get(image, base + 8, 4, &bloom_size) == 0 &&
+            memdl_image_get(image, base + 12, 4, &bloom_shift) == 0 && nbuckets && bloom_size && bloom_shift < 32 &&
+            memdl_image_get(image, base + 16 + (h / word_bits % bloom_size) * (word_bits / 8), word_bits / 8,
+                            &word) == 0) {
+            const uint64_t mask = ((uint64_t) 1 << (h % word_bits)) | ((uint64_t) 1 << ((h >> bloom_shift) % word_bits));
+            const uint64_t buckets = base + 16 + bloom_size * (word_bits / 8);
+            const uint64_t chain = buckets + nbuckets * 4;
+            if ((word & mask) == mask && memdl_image_get(image, buckets + (h % nbuckets) * 4, 4, &idx) == 0 &&
+                idx >= symoffset) {
+                for (; memdl_image_get(image, chain + (idx - symoffset) * 4, 4, &h2) == 0; idx++) {
+                    if ((h | 1) == (h2 | 1) && memdl_image_export_match(image, idx, name, &exp, &found)) break;
+                    if (h2 & 1) break;
+                }
+            }
+        }
+    } else if (image->hash_off != MEMDL_NO_OFFSET) {
+        const uint64_t base = image->hash_off;
+        uint64_t nbucket, nchain, idx;
+        if (memdl_image_get(image, base, 4, &nbucket) == 0 && memdl_image_get(image, base + 4, 4, &nchain) == 0 &&
+            nbucket && memdl_image_get(image, base + 8 + (memdl_sysv_hash(name) % nbucket) * 4, 4, &idx) == 0) {
+            // 链长不超过 nchain，防止损坏的镜像形成环
+            for (uint64_t steps = 0; idx != 0 && steps < nchain; steps++) {
+                if (memdl_image_export_match(image, idx, name, &exp, &found)) break;
+                if (memdl_image_get(image, base + 8 + (nbucket + idx) * 4, 4, &idx) != 0) break;
+            }
+        }
+    } else {
+        const uint64_t count = memdl_image_symcount(image);
+        for (uint64_t i = 1; i < count; i++) {
+            if (memdl_image_export_match(image, i, name, &exp, &found)) break;
+        }
+    }
+    if (!found) {
+        memdl_set_error_code(MEMDL_ERR_SYMBOL, 0, "Symbol not exported: %s", name);
+        return -1;
+    }
+    if (out) {
+        *out = exp;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 打包格式：多个镜像按页对齐存放在同一个文件中，带名称哈希索引和预计算的导出表。
+// 所有字段为小端；布局为 头部 | 条目 | 索引槽 | 导出表 | 字符串池 | 对齐后的镜像数据
+// ---------------------------------------------------------------------------
+
+#define MEMDL_BUNDLE_MAGIC       "MEMDLBND"
+#define MEMDL_BUNDLE_VERSION     1
+#define MEMDL_BUNDLE_HEADER_SIZE 72
+#define MEMDL_BUNDLE_ENTRY_SIZE  48
+#define MEMDL_BUNDLE_EXPORT_SIZE 32
+#define MEMDL_BUNDLE_NO_STRING   0xFFFFFFFFu
+
+struct memdl_bundle {
+    const unsigned char *data;
+    size_t size;
+    void *map;                  // memdl_bundle_open_file 映射（或读入）的文件内容
+    uint32_t count;
+    uint32_t slots;             // 索引槽数，2 的幂
+    uint32_t export_count;
+    uint64_t entries_off;
+    uint64_t index_off;
+    uint64_t exports_off;
+    uint64_t strings_off;
+    uint64_t strings_size;
+#if defined(MEMDL_LINUX)
+    atomic_uchar *verified;     // 各成员的索引哈希是否已与内容核对过
+#endif
+};
+
+typedef struct {
+    uint32_t name;              // 字符串池偏移
+    uint32_t arch;
+    uint32_t export_first;
+    uint32_t export_count;
+    uint64_t data_off;
+    uint64_t data_size;
+    uint64_t hash;              // 内容哈希，与句柄缓存一致，成员首次加载时核对一次
+    uint64_t name_hash;
+} memdl_bundle_entry_t;
+
+static uint64_t memdl_le_read(const unsigned char *p, const size_t width) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < width; i++) v |= (uint64_t) p[i] << (8 * i);
+    return v;
+}
+
+static void memdl_le_write(unsigned char *p, const uint64_t v, const size_t width) {
+    for (size_t i = 0; i < width; i++) p[i] = (unsigned char) (v >> (8 * i));
+}
+
+static uint64_t memdl_bundle_name_hash(const char *name) {
+    return memdl_hash64(name, strlen(name), 0);
+}
+
+static void memdl_bundle_entry(const memdl_bundle_t *b, const size_t i, memdl_bundle_entry_t *e) {
+    const unsigned char *p = b->data + b->entries_off + i * MEMDL_BUNDLE_ENTRY_SIZE;
+    e->name = (uint32_t) memdl_le_read(p, 4);
+    e->arch = (uint32_t) memdl_le_read(p + 4, 4);
+    e->export_first = (uint32_t) memdl_le_read(p + 8, 4);
+    e->export_count = (uint32_t) memdl_le_read(p + 12, 4);
+    e->data_off = memdl_le_read(p + 16, 8);
+    e->data_size = memdl_le_read(p + 24, 8);
+    e->hash = memdl_le_read(p + 32, 8);
+    e->name_hash = memdl_le_read(p + 40, 8);
+}
+
+static const char *memdl_bundle_string(const memdl_bundle_t *b, const uint32_t off) {
+    return off == MEMDL_BUNDLE_NO_STRING ? NULL : (const char *) b->data + b->strings_off + off;
+}
+
+// 表区域 [off, off + count * size) 是否在文件范围内
+static int memdl_bundle_range_ok(const size_t total, const uint64_t off, const uint64_t count, const uint64_t size) {
+    return off <= total && (size == 0 || count <= (total - off) / size);
+}
+
+// 校验头部和所有条目，之后的按名查找只需检查索引槽的取值
+static int memdl_bundle_parse(memdl_bundle_t *b, const void *data, const size_t size) {
+    const unsigned char *p = data;
+    if (!data || size < MEMDL_BUNDLE_HEADER_SIZE || memcmp(p, MEMDL_BUNDLE_MAGIC, 8) != 0) {
+        return memdl_format_error("Not a memdl bundle");
+    }
+    if (memdl_le_read(p + 8, 4) != MEMDL_BUNDLE_VERSION) {
+        memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Unsupported bundle version %u",
+                             (unsigned) memdl_le_read(p + 8, 4));
+        return -1;
+    }
+    b->data = p;
+    b->size = size;
+    b->count = (uint32_t) memdl_le_read(p + 16, 4);
+    b->slots = (uint32_t) memdl_le_read(p + 20, 4);
+    b->export_count = (uint32_t) memdl_le_read(p + 24, 4);
+    b->entries_off = memdl_le_read(p + 32, 8);
+    b->index_off = memdl_le_read(p + 40, 8);
+    b->exports_off = memdl_le_read(p + 48, 8);
+    b->strings_off = memdl_le_read(p + 56, 8);
+    b->strings_size = memdl_le_read(p + 64, 8);
+    if (b->slots == 0 || (b->slots & (b->slots - 1)) != 0 || b->slots < b->count ||
+        !memdl_bundle_range_ok(size, b->entries_off, b->count, MEMDL_BUNDLE_ENTRY_SIZE) ||
+        !memdl_bundle_range_ok(size, b->index_off, b->slots, 4) ||
+        !memdl_bundle_range_ok(size, b->exports_off, b->export_count, MEMDL_BUNDLE_EXPORT_SIZE) ||
+        !memdl_bundle_range_ok(size, b->strings_off, b->strings_size, 1) ||
+        (b->strings_size > 0 && p[b->strings_off + b->strings_size - 1] != '\0')) {
+        return memdl_format_error("Bundle tables out of range");
+    }
+    // 字符串池以 NUL 结尾，偏移在池内即为完整字符串
+    for (uint32_t i = 0; i < b->count; i++) {
+        memdl_bundle_entry_t e;
+        memdl_bundle_entry(b, i, &e);
+        if (e.name >= b->strings_size || e.data_off > size || e.data_size > size - e.data_off ||
+            e.export_first > b->export_count || e.export_count > b->export_count - e.export_first) {
+            return memdl_format_error("Malformed bundle entry");
+        }
+    }
+    for (uint32_t i = 0; i < b->export_count; i++) {
+        const unsigned char *x = p + b->exports_off + (uint64_t) i * MEMDL_BUNDLE_EXPORT_SIZE;
+        const uint64_t name = memdl_le_read(x, 4), version = memdl_le_read(x + 4, 4);
+        if (name >= b->strings_size || (version != MEMDL_BUNDLE_NO_STRING && version >= b->strings_size)) {
+            return memdl_format_error("Malformed bundle export table");
+        }
+    }
+    return 0;
+}
+
+// 开放寻址查找名称对应的条目，返回条目序号，不存在时返回 -1
+static long memdl_bundle_lookup(const memdl_bundle_t *b, const char *name, memdl_bundle_entry_t *e) {
+    const uint64_t h = memdl_bundle_name_hash(name);
+    for (uint32_t probe = 0; probe < b->slots; probe++) {
+        const uint64_t slot = (h + probe) & (b->slots - 1);
+        const uint32_t v = (uint32_t) memdl_le_read(b->data + b->index_off + slot * 4, 4);
+        if (v == 0) break;
+        if (v > b->count) continue;
+        memdl_bundle_entry(b, v - 1, e);
+        if (e->name_hash == h && strcmp(memdl_bundle_string(b, e->name), name) == 0) {
+            return (long) (v - 1);
+        }
+    }
+    memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Bundle has no member %s", name);
+    return -1;
+}
+
+memdl_bundle_t *memdl_bundle_open(const void *data, const size_t size) {
+    memdl_bundle_t b = {0};
+    if (memdl_bundle_parse(&b, data, size) != 0) {
+        return NULL;
+    }
+    memdl_bundle_t *bundle = malloc(sizeof(memdl_bundle_t));
+#if defined(MEMDL_LINUX)
+    b.verified = calloc(b.count ? b.count : 1, sizeof(atomic_uchar));
+    if (!b.verified) {
+        free(bundle);
+        bundle = NULL;
+    }
+#endif
+    if (!bundle) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return NULL;
+    }
+    *bundle = b;
+    return bundle;
+}
+
+memdl_bundle_t *memdl_bundle_open_file(const char *path) {
+    if (!path) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid path");
+        return NULL;
+    }
+#if !defined(MEMDL_WINDOWS)
+    // 整个文件只映射一次，成员直接作为内存镜像使用
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        memdl_set_sys_error("Failed to open bundle");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        memdl_set_sys_error("Failed to stat bundle");
+        close(fd);
+        return NULL;
+    }
+    if (st.st_size < MEMDL_BUNDLE_HEADER_SIZE) {
+        memdl_set_error_code(MEMDL_ERR_FORMAT, 0, "Not a memdl bundle");
+        close(fd);
+        return NULL;
+    }
+    const size_t size = (size_t) st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        memdl_set_sys_error("Failed to map bundle");
+        return NULL;
+    }
+    memdl_bundle_t *bundle = memdl_bundle_open(map, size);
+    if (!bundle) {
+        munmap(map, size);
+        return NULL;
+    }
+#else
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        memdl_set_error_code(MEMDL_ERR_SYSTEM, errno, "Failed to open bundle");
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    const long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void *map = length > 0 ? malloc((size_t) length) : NULL;
+    const size_t size = (size_t) length;
+    if (!map || fread(map, 1, size, file) != size) {
+        fclose(file);
+        free(map);
+        memdl_set_error_code(MEMDL_ERR_SYSTEM, 0, "Failed to read bundle");
+        return NULL;
+    }
+    fclose(file);
+    memdl_bundle_t *bundle = memdl_bundle_open(map, size);
+    if (!bundle) {
+        free(map);
+        return NULL;
+    }
+#endif
+    bundle->map = map;
+    return bundle;
+}
+
+void memdl_bundle_close(memdl_bundle_t *bundle) {
+    if (!bundle) {
+        return;
+    }
+    if (bundle->map) {
+#if !defined(MEMDL_WINDOWS)
+        munmap(bundle->map, bundle->size);
+#else
+        free(bundle->map);
+#endif
+    }
+#if defined(MEMDL_LINUX)
+    free(bundle->verified);
+#endif
+    free(bundle);
+}
+
+size_t memdl_bundle_count(const memdl_bundle_t *bundle) {
+    return bundle ? bundle->count : 0;
+}
+
+const char *memdl_bundle_name(const memdl_bundle_t *bundle, const size_t index) {
+    if (!bundle || index >= bundle->count) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid bundle index");
+        return NULL;
+    }
+    memdl_bundle_entry_t e;
+    memdl_bundle_entry(bundle, index, &e);
+    return memdl_bundle_string(bundle, e.name);
+}
+
+int memdl_bundle_find(const memdl_bundle_t *bundle, const char *name, memdl_source_t *image) {
+    memdl_bundle_entry_t e;
+    if (!bundle || !name) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    if (memdl_bundle_lookup(bundle, name, &e) < 0) {
+        return -1;
+    }
+    if (image) {
+        image->data = bundle->data + e.data_off;
+        image->size = (size_t) e.data_size;
+    }
+    return 0;
+}
+
+size_t memdl_bundle_exports(const memdl_bundle_t *bundle, const char *name, memdl_export_t *exports,
+                            const size_t max) {
+    memdl_bundle_entry_t e;
+    if (!bundle || !name) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return 0;
+    }
+    if (memdl_bundle_lookup(bundle, name, &e) < 0) {
+        return 0;
+    }
+    for (uint32_t i = 0; exports && i < e.export_count && i < max; i++) {
+        const unsigned char *x = bundle->data + bundle->exports_off +
+                                 (uint64_t) (e.export_first + i) * MEMDL_BUNDLE_EXPORT_SIZE;
+        memdl_export_t *out = &exports[i];
+        out->name = memdl_bundle_string(bundle, (uint32_t) memdl_le_read(x, 4));
+        out->version = memdl_bundle_string(bundle, (uint32_t) memdl_le_read(x + 4, 4));
+        out->type = (int) memdl_le_read(x + 8, 2);
+        out->binding = (int) memdl_le_read(x + 10, 2);
+        out->default_version = (int) memdl_le_read(x + 12, 2);
+        out->value = memdl_le_read(x + 16, 8);
+        out->size = memdl_le_read(x + 24, 8);
+    }
+    return e.export_count;
+}
+
+memdl_handle_t memdl_bundle_load(const memdl_bundle_t *bundle, const char *name, const int flags) {
+    memdl_bundle_entry_t e;
+    if (!bundle || !name) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return NULL;
+    }
+    const long index = memdl_bundle_lookup(bundle, name, &e);
+    if (index < 0) {
+        return NULL;
+    }
+    memdl_image_t img;
+    if (memdl_image_parse(&img, bundle->data + e.data_off, (size_t) e.data_size) != 0) {
+        return NULL;
+    }
+#if defined(MEMDL_LINUX)
+    // 索引哈希会直接作为全进程的缓存键，每个成员首次加载时与内容核对一次，之后不再扫描镜像
+    atomic_uchar *verified = &bundle->verified[index];
+    if (!atomic_load_explicit(verified, memory_order_acquire)) {
+        if (memdl_digest(img.data, img.size) != e.hash) {
+            memdl_set_error_code(MEMDL_ERR_INTEGRITY, 0, "Bundle index hash mismatch for %s", name);
+            return NULL;
+        }
+        atomic_store_explicit(verified, 1, memory_order_release);
+    }
+    img.hash = e.hash;
+#else
+    (void) index;
+#endif
+    return memdl_image_open(&img, flags);
+}
+
+// 打包时的字符串池
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} memdl_strpool_t;
+
+static uint32_t memdl_strpool_add(memdl_strpool_t *pool, const char *str) {
+    if (!str) {
+        return MEMDL_BUNDLE_NO_STRING;
+    }
+    const size_t len = strlen(str) + 1;
+    if (pool->size + len >= MEMDL_BUNDLE_NO_STRING) {
+        return MEMDL_BUNDLE_NO_STRING;
+    }
+    if (pool->size + len > pool->capacity) {
+        size_t capacity = pool->capacity ? pool->capacity : 4096;
+        while (capacity < pool->size + len) capacity *= 2;
+        char *data = realloc(pool->data, capacity);
+        if (!data) {
+            return MEMDL_BUNDLE_NO_STRING;
+        }
+        pool->data = data;
+        pool->capacity = capacity;
+    }
+    memcpy(pool->data + pool->size, str, len);
+    const uint32_t off = (uint32_t) pool->size;
+    pool->size += len;
+    return off;
+}
+
+static int memdl_write_zeros(FILE *file, size_t count) {
+    static const unsigned char zeros[4096];
+    while (count > 0) {
+        const size_t n = count < sizeof(zeros) ? count : sizeof(zeros);
+        if (fwrite(zeros, 1, n, file) != n) return -1;
+        count -= n;
+    }
+    return 0;
+}
+
+// 生成元数据区（头部、条目、索引、导出表、字符串池），返回其长度；镜像数据由调用者按对齐写出
+static unsigned char *memdl_bundle_build(const char *const *names, const memdl_source_t *images, const size_t count,
+                                         const size_t align, size_t *meta_size) {
+    memdl_image_t **parsed = calloc(count, sizeof(memdl_image_t *));
+    size_t *export_counts = calloc(count, sizeof(size_t));
+    memdl_strpool_t pool = {0};
+    memdl_export_t *exports = NULL;
+    unsigned char *meta = NULL;
+    size_t export_total = 0;
+    int ok = parsed && export_counts;
+    if (!ok) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+    }
+    for (size_t i = 0; ok && i < count; i++) {
+        if (!names[i] || !*names[i]) {
+            memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Bundle member %zu has no name", i);
+            ok = 0;
+            break;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (strcmp(names[i], names[j]) == 0) {
+                memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Duplicate bundle member %s", names[i]);
+                ok = 0;
+            }
+        }
+        parsed[i] = ok ? memdl_image_prepare(images[i].data, images[i].size) : NULL;
+        if (!parsed[i]) {
+            if (ok) {
+                const memdl_error_info_t err = memdl_last_error_info;
+                memdl_set_error_code(err.code, err.sys_errno, "Bundle member %s: %s", names[i], err.message);
+            }
+            ok = 0;
+            break;
+        }
+        if (parsed[i]->format == MEMDL_FORMAT_ELF) {
+            export_counts[i] = memdl_image_exports(parsed[i], NULL, 0);
+            export_total += export_counts[i];
+        }
+    }
+    if (ok && (count >= MEMDL_BUNDLE_NO_STRING / 2 || export_total >= MEMDL_BUNDLE_NO_STRING)) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Too many bundle members or exports");
+        ok = 0;
+    }
+
+    // 索引槽数取不小于 2 * count 的 2 的幂，保持装载率不超过一半
+    uint32_t slots = 1;
+    while (ok && slots < 2 * count) slots *= 2;
+    const uint64_t entries_off = MEMDL_BUNDLE_HEADER_SIZE;
+    const uint64_t index_off = entries_off + (uint64_t) count * MEMDL_BUNDLE_ENTRY_SIZE;
+    const uint64_t exports_off = index_off + (uint64_t) slots * 4;
+    const uint64_t strings_off = exports_off + (uint64_t) export_total * MEMDL_BUNDLE_EXPORT_SIZE;
+    if (ok) {
+        exports = export_total ? malloc(export_total * sizeof(memdl_export_t)) : NULL;
+        meta = calloc(1, (size_t) strings_off);
+        if ((export_total && !exports) || !meta) {
+            memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+            ok = 0;
+        }
+    }
+
+    // 逐个成员写入条目、导出记录与索引槽；数据偏移此时相对于元数据末尾
+    uint64_t data_off = 0;
+    size_t export_first = 0;
+    for (size_t i = 0; ok && i < count; i++) {
+        unsigned char *e = meta + entries_off + i * MEMDL_BUNDLE_ENTRY_SIZE;
+        const uint32_t name = memdl_strpool_add(&pool, names[i]);
+        memdl_export_t *member_exports = exports + export_first;
+        if (export_counts[i]) memdl_image_exports(parsed[i], member_exports, export_counts[i]);
+        for (size_t k = 0; k < export_counts[i] && name != MEMDL_BUNDLE_NO_STRING; k++) {
+            unsigned char *x = meta + exports_off + (export_first + k) * MEMDL_BUNDLE_EXPORT_SIZE;
+            const uint32_t sym = memdl_strpool_add(&pool, member_exports[k].name);
+            const uint32_t version = memdl_strpool_add(&pool, member_exports[k].version);
+            if (sym == MEMDL_BUNDLE_NO_STRING || (member_exports[k].version && version == MEMDL_BUNDLE_NO_STRING)) {
+                ok = 0;
+                break;
+            }
+            memdl_le_write(x, sym, 4);
+            memdl_le_write(x + 4, version, 4);
+            memdl_le_write(x + 8, (uint64_t) member_exports[k].type, 2);
+            memdl_le_write(x + 10, (uint64_t) member_exports[k].binding, 2);
+            memdl_le_write(x + 12, (uint64_t) member_exports[k].default_version, 2);
+            memdl_le_write(x + 16, member_exports[k].value, 8);
+            memdl_le_write(x + 24, member_exports[k].size, 8);
+        }
+        if (!ok || name == MEMDL_BUNDLE_NO_STRING) {
+            memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Bundle string pool exhausted");
+            ok = 0;
+            break;
+        }
+        const uint64_t name_hash = memdl_bundle_name_hash(names[i]);
+        memdl_le_write(e, name, 4);
+        memdl_le_write(e + 4, (uint64_t) parsed[i]->arch, 4);
+        memdl_le_write(e + 8, export_first, 4);
+        memdl_le_write(e + 12, export_counts[i], 4);
+        memdl_le_write(e + 16, data_off, 8);
+        memdl_le_write(e + 24, images[i].size, 8);
+        memdl_le_write(e + 32, parsed[i]->hash, 8);
+        memdl_le_write(e + 40, name_hash, 8);
+        for (uint64_t probe = 0;; probe++) {
+            unsigned char *slot = meta + index_off + ((name_hash + probe) & (slots - 1)) * 4;
+            if (memdl_le_read(slot, 4) == 0) {
+                memdl_le_write(slot, i + 1, 4);
+                break;
+            }
+        }
+        data_off += (images[i].size + align - 1) & ~(uint64_t) (align - 1);
+        export_first += export_counts[i];
+    }
+
+    if (ok) {
+        // 字符串池接在表后，镜像数据从下一个对齐边界开始
+        const uint64_t meta_end = strings_off + pool.size;
+        const uint64_t data_start = (meta_end + align - 1) & ~(uint64_t) (align - 1);
+        unsigned char *grown = realloc(meta, (size_t) data_start);
+        if (!grown) {
+            memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+            ok = 0;
+        } else {
+            meta = grown;
+            memcpy(meta + strings_off, pool.data, pool.size);
+            memset(meta + meta_end, 0, (size_t) (data_start - meta_end));
+            memcpy(meta, MEMDL_BUNDLE_MAGIC, 8);
+            memdl_le_write(meta + 8, MEMDL_BUNDLE_VERSION, 4);
+            memdl_le_write(meta + 12, align, 4);
+            memdl_le_write(meta + 16, count, 4);
+            memdl_le_write(meta + 20, slots, 4);
+            memdl_le_write(meta + 24, export_total, 4);
+            memdl_le_write(meta + 28, 0, 4);
+            memdl_le_write(meta + 32, entries_off, 8);
+            memdl_le_write(meta + 40, index_off, 8);
+            memdl_le_write(meta + 48, exports_off, 8);
+            memdl_le_write(meta + 56, strings_off, 8);
+            memdl_le_write(meta + 64, pool.size, 8);
+            for (size_t i = 0; i < count; i++) {
+                unsigned char *e = meta + entries_off + i * MEMDL_BUNDLE_ENTRY_SIZE;
+                memdl_le_write(e + 16, memdl_le_read(e + 16, 8) + data_start, 8);
+            }
+            *meta_size = (size_t) data_start;
+        }
+    }
+
+    for (size_t i = 0; parsed && i < count; i++) {
+        memdl_image_release(parsed[i]);
+    }
+    free(parsed);
+    free(export_counts);
+    free(exports);
+    free(pool.data);
+    if (!ok) {
+        free(meta);
+        return NULL;
+    }
+    return meta;
+}
+
+int memdl_bundle_write(const char *path, const char *const *names, const memdl_source_t *images, const size_t count,
+                       size_t align) {
+    if (align == 0) {
+        align = MEMDL_BUNDLE_ALIGN;
+    }
+    if (!path || !names || !images || count == 0 || align < 8 || align > ((size_t) 1 << 30) ||
+        (align & (align - 1)) != 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    size_t meta_size = 0;
+    unsigned char *meta = memdl_bundle_build(names, images, count, align, &meta_size);
+    if (!meta) {
+        return -1;
+    }
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        memdl_set_error_code(MEMDL_ERR_SYSTEM, errno, "Failed to create %s: %s", path, strerror(errno));
+        free(meta);
+        return -1;
+    }
+    int ok = fwrite(meta, 1, meta_size, file) == meta_size;
+    free(meta);
+    for (size_t i = 0; ok && i < count; i++) {
+        const size_t padded = (images[i].size + align - 1) & ~(align - 1);
+        ok = fwrite(images[i].data, 1, images[i].size, file) == images[i].size &&
+             memdl_write_zeros(file, padded - images[i].size) == 0;
+    }
+    if (fclose(file) != 0) {
+        ok = 0;
+    }
+    if (!ok) {
+        memdl_set_error_code(MEMDL_ERR_SYSTEM, errno, "Failed to write %s", path);
+        remove(path);
+        return -1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// LZ4 帧解码：压缩镜像按块直接解压到加载介质中，不经过中间缓冲区
+// ---------------------------------------------------------------------------
+
+#define MEMDL_LZ4_MAGIC 0x184D2204u
+
+static uint32_t memdl_rotl32(const uint32_t x, const int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+static uint32_t memdl_xxh32_round(uint32_t acc, const uint32_t input) {
+    acc += input * MEMDL_PRIME32_2;
+    acc = memdl_rotl32(acc, 13);
+    return acc * MEMDL_PRIME32_1;
+}
+
+// 32位 XXH32，LZ4 帧的头部、块与内容校验使用
+static uint32_t memdl_hash32(const void *input, const size_t len, const uint32_t seed) {
+    const unsigned char *p = input;
+    const unsigned char *const end = p + len;
+    uint32_t h;
+
+    if (len >= 16) {
+        const unsigned char *const limit = end - 16;
+        uint32_t v1 = seed + MEMDL_PRIME32_1 + MEMDL_PRIME32_2;
+        uint32_t v2 = seed + MEMDL_PRIME32_2;
+        uint32_t v3 = seed;
+        uint32_t v4 = seed - MEMDL_PRIME32_1;
+        do {
+            v1 = memdl_xxh32_round(v1, memdl_read32(p));
+            v2 = memdl_xxh32_round(v2, memdl_read32(p + 4));
+            v3 = memdl_xxh32_round(v3, memdl_read32(p + 8));
+            v4 = memdl_xxh32_round(v4, memdl_read32(p + 12));
+            p += 16;
+        } while (p <= limit);
+        h = memdl_rotl32(v1, 1) + memdl_rotl32(v2, 7) + memdl_rotl32(v3, 12) + memdl_rotl32(v4, 18);
+    } else {
+        h = seed + MEMDL_PRIME32_5;
+    }
+    h += (uint32_t) len;
+
+    while (p + 4 <= end) {
+        h += memdl_read32(p) * MEMDL_PRIME32_3;
+        h = memdl_rotl32(h, 17) * MEMDL_PRIME32_4;
+        p += 4;
+    }
+    while (p < end) {
+        h += (*p) * MEMDL_PRIME32_5;
+        h = memdl_rotl32(h, 11) * MEMDL_PRIME32_1;
+        p++;
+    }
+
+    h ^= h >> 15;
+    h *= MEMDL_PRIME32_2;
+    h ^= h >> 13;
+    h *= MEMDL_PRIME32_3;
+    h ^= h >> 16;
+    return h;
+}
+
+typedef struct {
+    size_t offset;              // 块数据在帧中的偏移
+    size_t size;
+    int raw;                    // 未压缩块
+} memdl_lz4_block_t;
+
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    int independent;            // 块之间没有引用，可并行解码
+    int block_checksum;
+    int content_checksum;
+    int has_content_size;
+    uint64_t content_size;
+    size_t block_max;
+    memdl_lz4_block_t *blocks;
+    size_t count;
+    size_t bound;               // 解压后大小的上界
+    size_t checksum_off;        // 内容校验和的偏移
+} memdl_lz4_frame_t;
+
+static int memdl_lz4_is_frame(const void *data, const size_t size) {
+    return data && size >= 4 && memdl_le_read(data, 4) == MEMDL_LZ4_MAGIC;
+}
+
+static void memdl_lz4_free(memdl_lz4_frame_t *frame) {
+    free(frame->blocks);
+    frame->blocks = NULL;
+}
+
+// 解析帧头并扫描块表（只读块长度，不解码），得到解压后大小的上界
+static int memdl_lz4_parse(memdl_lz4_frame_t *frame, const unsigned char *data, const size_t size) {
+    memset(frame, 0, sizeof(*frame));
+    if (size < 7) {
+        return memdl_format_error("Truncated LZ4 frame");
+    }
+    const unsigned flg = data[4], bd = data[5];
+    if ((flg >> 6) != 1 || (flg & 0x02) || (bd & 0x8F) || ((bd >> 4) & 7) < 4) {
+        return memdl_format_error("Unsupported LZ4 frame descriptor");
+    }
+    if (flg & 0x01) {
+        memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "LZ4 frames with a dictionary are not supported");
+        return -1;
+    }
+    frame->data = data;
+    frame->size = size;
+    frame->independent = (flg >> 5) & 1;
+    frame->block_checksum = (flg >> 4) & 1;
+    frame->has_content_size = (flg >> 3) & 1;
+    frame->content_checksum = (flg >> 2) & 1;
+    frame->block_max = (size_t) 1 << (8 + 2 * ((bd >> 4) & 7));
+    size_t pos = 6;
+    if (frame->has_content_size) {
+        if (size < 15) {
+            return memdl_format_error("Truncated LZ4 frame");
+        }
+        frame->content_size = memdl_le_read(data + 6, 8);
+        pos += 8;
+    }
+    if (((memdl_hash32(data + 4, pos - 4, 0) >> 8) & 0xFF) != data[pos]) {
+        return memdl_format_error("LZ4 frame header checksum mismatch");
+    }
+    pos++;
+
+    size_t capacity = 0;
+    for (;;) {
+        if (size - pos < 4) {
+            memdl_lz4_free(frame);
+            return memdl_format_error("Truncated LZ4 frame");
+        }
+        const uint32_t word = (uint32_t) memdl_le_read(data + pos, 4);
+        pos += 4;
+        if (word == 0) break;
+        const size_t length = word & 0x7FFFFFFFu;
+        const size_t trailer = frame->block_checksum ? 4 : 0;
+        if (length > frame->block_max || length > size - pos || trailer > size - pos - length) {
+            memdl_lz4_free(frame);
+            return memdl_format_error("LZ4 block out of range");
+        }
+        if (frame->count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            memdl_lz4_block_t *blocks = realloc(frame->blocks, capacity * sizeof(memdl_lz4_block_t));
+            if (!blocks) {
+                memdl_lz4_free(frame);
+                memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+                return -1;
+            }
+            frame->blocks = blocks;
+        }
+        memdl_lz4_block_t *block = &frame->blocks[frame->count++];
+        block->offset = pos;
+        block->size = length;
+        block->raw = (word & 0x80000000u) != 0;
+        frame->bound += block->raw ? length : frame->block_max;
+        pos += length + trailer;
+    }
+    if (frame->content_checksum) {
+        if (size - pos < 4) {
+            memdl_lz4_free(frame);
+            return memdl_format_error("Truncated LZ4 frame");
+        }
+        frame->checksum_off = pos;
+    }
+    // 已知内容大小时按实际大小准备输出
+    if (frame->has_content_size) {
+        if (frame->content_size > frame->bound) {
+            memdl_lz4_free(frame);
+            return memdl_format_error("LZ4 content size exceeds its blocks");
+        }
+        frame->bound = (size_t) frame->content_size;
+    }
+    return 0;
+}
+
+// 解码一个 LZ4 块到 out；匹配可回溯到 out 之前 history 字节（相关联的块）。返回解码长度，数据损坏时返回 -1
+static ptrdiff_t memdl_lz4_block(const unsigned char *src, const size_t src_len, unsigned char *out,
+                                 const size_t out_cap, const size_t history) {
+    const unsigned char *ip = src;
+    const unsigned char *const iend = src + src_len;
+    size_t op = 0;
+    for (;;) {
+        if (ip >= iend) return -1;
+        const unsigned token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15) {
+            unsigned b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > (size_t) (iend - ip) || lit > out_cap - op) return -1;
+        memcpy(out + op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == iend) return (ptrdiff_t) op;     // 最后一个序列只有字面量
+
+        if (iend - ip < 2) return -1;
+        const size_t offset = ip[0] | (size_t) ip[1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > op + history) return -1;
+        size_t len = token & 15;
+        if (len == 15) {
+            unsigned b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        len += 4;
+        if (len > out_cap - op) return -1;
+
+        // 重叠的匹配按不超过 offset 的步长复制，每一步的源都已写好
+        unsigned char *d = out + op;
+        const unsigned char *m = d - offset;
+        if (offset >= len) {
+            memcpy(d, m, len);
+        } else if (offset >= 8) {
+            for (size_t i = 0; i < len; i += 8) memcpy(d + i, m + i, len - i < 8 ? len - i : 8);
+        } else {
+            for (size_t i = 0; i < len; i++) d[i] = m[i];
+        }
+        op += len;
+    }
+}
+
+// 校验并解码第 i 块；返回解码长度，失败时设置错误并返回 -1
+static ptrdiff_t memdl_lz4_decode(const memdl_lz4_frame_t *frame, const size_t i, unsigned char *out,
+                                  const size_t out_cap, const size_t history) {
+    const memdl_lz4_block_t *block = &frame->blocks[i];
+    const unsigned char *src = frame->data + block->offset;
+    if (frame->block_checksum &&
+        memdl_hash32(src, block->size, 0) != (uint32_t) memdl_le_read(src + block->size, 4)) {
+        memdl_format_error("LZ4 block checksum mismatch");
+        return -1;
+    }
+    if (block->raw) {
+        if (block->size > out_cap) {
+            memdl_format_error("LZ4 block exceeds content size");
+            return -1;
+        }
+        memcpy(out, src, block->size);
+        return (ptrdiff_t) block->size;
+    }
+    const ptrdiff_t n = memdl_lz4_block(src, block->size, out, out_cap, history);
+    if (n < 0) {
+        memdl_format_error("Corrupted LZ4 block");
+    }
+    return n;
+}
+
+// 顺序解码整个帧到 out（容量 frame->bound），返回内容长度
+static ptrdiff_t memdl_lz4_decode_all(const memdl_lz4_frame_t *frame, unsigned char *out) {
+    size_t op = 0;
+    for (size_t i = 0; i < frame->count; i++) {
+        const size_t room = frame->bound - op;
+        const ptrdiff_t n = memdl_lz4_decode(frame, i, out + op, room < frame->block_max ? room : frame->block_max,
+                                             frame->independent ? 0 : op);
+        if (n < 0) return -1;
+        op += (size_t) n;
+    }
+    return (ptrdiff_t) op;
+}
+
+// 核对解压结果的长度与内容校验和
+static int memdl_lz4_verify(const memdl_lz4_frame_t *frame, const unsigned char *out, const size_t size) {
+    if (frame->has_content_size && size != frame->content_size) {
+        return memdl_format_error("LZ4 content size mismatch");
+    }
+    if (frame->content_checksum &&
+        memdl_hash32(out, size, 0) != (uint32_t) memdl_le_read(frame->data + frame->checksum_off, 4)) {
+        return memdl_format_error("LZ4 content checksum mismatch");
+    }
+    return 0;
+}
+
+// 平台特定实现
+#ifdef MEMDL_WINDOWS
+
+#include <stdio.h>
+
+memdl_handle_t memdl_open_file(const char *filename, const int flags) {
+    return LoadLibraryA(filename);
+}
+
+memdl_handle_t memdl_open(const void *so_data, size_t so_size, int flags) {
+    if (memdl_validate(so_data, so_size) != 0) {
+        return NULL;
+    }
+
+    // Windows内存加载比较复杂，使用临时文件方案
+    char temp_path[MAX_PATH];
+    DWORD ret = GetTempPathA(MAX_PATH, temp_path);
+    if (ret == 0 || ret > MAX_PATH) {
+        memdl_set_error("Failed to get temp path");
+        return NULL;
+    }
+
+    char temp_file[MAX_PATH];
+    if (GetTempFileNameA(temp_path, "memdl", 0, temp_file) == 0) {
+        memdl_set_error("Failed to create temp file");
+        return NULL;
+    }
+
+    // 写入临时文件
+    HANDLE hFile = CreateFileA(temp_file, GENERIC_WRITE, 0, NULL,
+                               CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        memdl_set_error("Failed to create temp file");
+        return NULL;
+    }
+
+    DWORD written;
+    if (!WriteFile(hFile, so_data, (DWORD) so_size, &written, NULL) ||
+        written != so_size) {
+        CloseHandle(hFile);
+        DeleteFileA(temp_file);
+        memdl_set_error("Failed to write temp file");
+        return NULL;
+    }
+    CloseHandle(hFile);
+
+    // 加载DLL
+    HMODULE handle = LoadLibraryA(temp_file);
+
+    // 删除临时文件
+    DeleteFileA(temp_file);
+
+    if (!handle) {
+        memdl_set_error_format("LoadLibrary failed: %lu", GetLastError());
+    }
+
+    return (memdl_handle_t) handle;
+}
+
+void *memdl_sym(memdl_handle_t handle, const char *symbol) {
+    if (!handle) {
+        memdl_set_error("Invalid handle");
+        return NULL;
+    }
+    return (void *) GetProcAddress((HMODULE) handle, symbol);
+}
+
+int memdl_close(memdl_handle_t handle) {
+    if (!handle) {
+        memdl_set_error("Invalid handle");
+        return -1;
+    }
+    return FreeLibrary((HMODULE) handle) ? 0 : -1;
+}
+
+#elif defined(MEMDL_ANDROID)
+
+static bool is_android_7_plus() {
+    char version[PROP_VALUE_MAX] = {0};
+    if (__system_property_get("ro.build.version.sdk", version) <= 0) {
+        return false;
+    }
+    return atoi(version) >= 24; // Android 7.0 = API 24
+}
+
+memdl_handle_t memdl_open_file(const char *filename, const int flags) {
+    int dl_flags = (flags & MEMDL_NOW) ? RTLD_NOW : RTLD_LAZY;
+    dl_flags |= (flags & MEMDL_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
+    return dlopen(filename, dl_flags);
+}
+
+memdl_handle_t memdl_open(const void *so_data, size_t so_size, int flags) {
+    if (memdl_validate(so_data, so_size) != 0) {
+        return NULL;
+    }
+
+    int dl_flags = (flags & MEMDL_NOW) ? RTLD_NOW : RTLD_LAZY;
+    dl_flags |= (flags & MEMDL_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
+
+    // Android 7+ 使用memfd方案
+    if (is_android_7_plus()) {
+// 定义MFD_CLOEXEC常量（如果系统头文件没有定义）
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+int fd = syscall(SYS_memfd_create, "memdl_lib", MFD_CLOEXEC);
+        if (fd>= 0) {
+            ssize_t written = write(fd, so_data, so_size);
+            if (written == (ssize_t)so_size) {
+                lseek(fd, 0, SEEK_SET);
+
+                android_dlextinfo info = {
+                    .flags = ANDROID_DLEXT_USE_LIBRARY_FD,
+                    .library_fd = fd,
+                };
+
+                void* handle = android_dlopen_ext("/memfd", dl_flags, &info);
+                close(fd);
+
+                if (handle) return handle;
+            } else {
+                close(fd);
+            }
+        }
+    }
+
+// 降级方案：临时文件
+char template[] = "/data/local/tmp/memdl_tmp";
+int fd = mkstemp(template);
+    if (fd>= 0) {
+        if (write(fd, so_data, so_size) == (ssize_t)so_size) {
+            void* handle = dlopen(template, dl_flags);
+            unlink(template);
+            close(fd);
+
+            if (!handle) {
+                set_error(dlerror());
+            }
+            return handle;
+        }
+        close(fd);
+        unlink(template);
+    }
+
+set_error("All loading methods failed");
+    return NULL;
+}
+
+void *memdl_sym(memdl_handle_t handle, const char *symbol) {
+    if (!handle) {
+        set_error("Invalid handle");
+        return NULL;
+    }
+    void *sym = dlsym(handle, symbol);
+    if (!sym) {
+        set_error(dlerror());
+    }
+    return sym;
+}
+
+int memdl_close(memdl_handle_t handle) {
+    if (!handle) {
+        set_error("Invalid handle");
+        return -1;
+    }
+    int result = dlclose(handle);
+    if (result != 0) {
+        set_error(dlerror());
+    }
+    return result;
+}
+
+#elif defined(MEMDL_IOS) || defined(MEMDL_MACOS)
+
+memdl_handle_t memdl_open_file(const char *filename, const int flags) {
+    int dl_flags = (flags & MEMDL_NOW) ? RTLD_NOW : RTLD_LAZY;
+    dl_flags |= (flags & MEMDL_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
+    return dlopen(filename, dl_flags);
+}
+
+memdl_handle_t memdl_open(const void *so_data, size_t so_size, int flags) {
+    if (memdl_validate(so_data, so_size) != 0) {
+        return NULL;
+    }
+
+    int dl_flags = (flags & MEMDL_NOW) ? RTLD_NOW : RTLD_LAZY;
+    dl_flags |= (flags & MEMDL_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
+
+    // macOS/iOS 使用临时文件方案
+    char template[] = "/tmp/memdl_tmp";
+    int fd = mkstemp(template);
+    if (fd >= 0) {
+        if (write(fd, so_data, so_size) == (ssize_t) so_size) {
+            void *handle = dlopen(template, dl_flags);
+            unlink(template);
+            close(fd);
+
+            if (!handle) {
+                memdl_set_error(dlerror());
+            }
+            return handle;
+        }
+        close(fd);
+        unlink(template);
+    }
+
+    memdl_set_error("Failed to load library");
+    return NULL;
+}
+
+void *memdl_sym(memdl_handle_t handle, const char *symbol) {
+    if (!handle) {
+        memdl_set_error("Invalid handle");
+        return NULL;
+    }
+    void *sym = dlsym(handle, symbol);
+    if (!sym) {
+        memdl_set_error(dlerror());
+    }
+    return sym;
+}
+
+int memdl_close(memdl_handle_t handle) {
+    if (!handle) {
+        memdl_set_error("Invalid handle");
+        return -1;
+    }
+    int result = dlclose(handle);
+    if (result != 0) {
+        memdl_set_error(dlerror());
+    }
+    return result;
+}
+
+#elif defined(MEMDL_LINUX)
+
+// 原生加载器实例，定义见下方原生 ELF 加载器
+typedef struct memdl_native memdl_native_t;
+
+// 符号索引：导出符号的开放寻址哈希表，构建后只读，查找无需加锁
+typedef struct {
+    const char *name;
+    void *addr;
+    uint32_t hash;
+} memdl_symslot_t;
+
+typedef struct {
+    size_t mask;
+    size_t count;
+    memdl_symslot_t slots[];
+} memdl_symindex_t;
+
+// Linux 句柄：包装 dlopen 句柄或原生加载器实例，按镜像内容哈希缓存并引用计数
+typedef struct memdl_lib {
+    void *dl;                 // dlopen 返回的句柄
+    memdl_native_t *native;   // 原生加载器实例（MEMDL_NATIVE）
+    memdl_symindex_t *index;  // 导出符号索引，构建失败时为 NULL（回退到 dlsym）
+    int fd;                   // 镜像内容（memfd、O_TMPFILE 或已删除的临时文件），卸载前保持打开：/proc/self/fd/N
+                              // 被复用时 dlopen 会按路径误认已加载的库；登记缓存遇到同键条目时据此比对内容
+    int dl_flags;             // 加载时的 RTLD_* 标志，缓存键的一部分
+    struct memdl_lib **deps;  // 从注册表加载的 DT_NEEDED 依赖，各持有一个引用
+    size_t dep_count;
+    struct memdl_namespace *ns; // MEMDL_INSTANCE：所在的链接命名空间
+    struct memdl_instance_src *src; // MEMDL_INSTANCE：共享的已填充 memfd
+    memdl_segment_t *segments; // PT_LOAD 段（huge_bytes 在查询时统计）
+    size_t segment_count;
+    memdl_load_info_t info;   // 加载记录
+    uint64_t hash;            // 镜像内容哈希
+    size_t size;              // 镜像大小
+    atomic_int refcount;      // 引用计数
+    int cached;               // 是否登记在缓存中（创建后不变）
+    struct memdl_lib *next;   // 缓存桶链表
+} memdl_lib_t;
+
+#define MEMDL_CACHE_BUCKETS 64
+
+// 每个桶独立加锁，不同镜像的打开/关闭互不阻塞
+static pthread_mutex_t memdl_cache_locks[MEMDL_CACHE_BUCKETS] = {
+    [0 ... MEMDL_CACHE_BUCKETS - 1] = PTHREAD_MUTEX_INITIALIZER
+};
+static memdl_lib_t *memdl_cache_table[MEMDL_CACHE_BUCKETS];
+static atomic_size_t memdl_cache_entries = 0;
+static atomic_uint_least64_t memdl_cache_hits = 0;
+static atomic_uint_least64_t memdl_cache_misses = 0;
+
+static pthread_mutex_t *memdl_cache_lock(const uint64_t hash) {
+    return &memdl_cache_locks[hash % MEMDL_CACHE_BUCKETS];
+}
+
+static uint64_t memdl_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// 加载统计：计时只在开启统计或设置回调时采集，正在记录的加载通过线程局部变量传给各阶段
+// ---------------------------------------------------------------------------
+
+static atomic_int memdl_instrumented = 0;
+static _Atomic(memdl_trace_fn) memdl_trace_hook = NULL;
+static _Atomic(void *) memdl_trace_user = NULL;
+static atomic_int memdl_timing = 0;          // memdl_instrumented || memdl_trace_hook
+
+static atomic_uint_least64_t memdl_stat_loads = 0;
+static atomic_uint_least64_t memdl_stat_failures = 0;
+static atomic_uint_least64_t memdl_stat_bytes = 0;
+static atomic_uint_least64_t memdl_stat_total_ns = 0;
+static atomic_uint_least64_t memdl_stat_strategy[MEMDL_STRATEGY_COUNT];
+static atomic_uint_least64_t memdl_stat_stage_ns[MEMDL_TRACE_STAGES];
+
+static MEMDL_THREAD_LOCAL memdl_load_info_t *memdl_load_cur = NULL;
+
+// 阶段开始；未开启计时返回 0
+static uint64_t memdl_trace_begin(void) {
+    return atomic_load_explicit(&memdl_timing, memory_order_relaxed) ? memdl_now_ns() : 0;
+}
+
+static void memdl_trace_add(const int event, const uint64_t elapsed) {
+    memdl_load_info_t *info = memdl_load_cur;
+    if (info) {
+        info->stage_ns[event] += elapsed;
+    }
+    const memdl_trace_fn hook = atomic_load_explicit(&memdl_trace_hook, memory_order_acquire);
+    if (hook) {
+        hook(event, elapsed, info, atomic_load_explicit(&memdl_trace_user, memory_order_relaxed));
+    }
+}
+
+static void memdl_trace_end(const int event, const uint64_t start) {
+    if (start) {
+        memdl_trace_add(event, memdl_now_ns() - start);
+    }
+}
+
+// 记录采用的策略（0 表示不变）与复制的字节数
+static void memdl_load_note(const int strategy, const uint64_t bytes) {
+    memdl_load_info_t *info = memdl_load_cur;
+    if (info) {
+        if (strategy) info->strategy = strategy;
+        info->bytes_copied += bytes;
+    }
+}
+
+// 开始记录一次加载，返回外层记录（加载依赖时嵌套）
+static memdl_load_info_t *memdl_load_begin(memdl_load_info_t *info) {
+    memset(info, 0, sizeof(*info));
+    memdl_load_info_t *outer = memdl_load_cur;
+    memdl_load_cur = info;
+    return outer;
+}
+
+// 结束记录：恢复外层记录，写入新句柄并累计统计；计时时调用者先填好 total_ns
+static void memdl_load_end(memdl_lib_t *lib, const memdl_load_info_t *info, memdl_load_info_t *outer) {
+    memdl_load_cur = outer;
+    if (lib) {
+        lib->info = *info;
+        atomic_fetch_add_explicit(&memdl_stat_loads, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&memdl_stat_strategy[info->strategy], 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&memdl_stat_bytes, info->bytes_copied, memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&memdl_stat_failures, 1, memory_order_relaxed);
+    }
+    if (!info->total_ns) {
+        return;
+    }
+    for (int i = 0; i < MEMDL_TRACE_STAGES; i++) {
+        atomic_fetch_add_explicit(&memdl_stat_stage_ns[i], info->stage_ns[i], memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&memdl_stat_total_ns, info->total_ns, memory_order_relaxed);
+    const memdl_trace_fn hook = atomic_load_explicit(&memdl_trace_hook, memory_order_acquire);
+    if (hook) {
+        hook(MEMDL_TRACE_LOAD, info->total_ns, info, atomic_load_explicit(&memdl_trace_user, memory_order_relaxed));
+    }
+}
+
+void memdl_set_instrumentation(const int enabled) {
+    atomic_store(&memdl_instrumented, enabled != 0);
+    atomic_store(&memdl_timing, enabled || atomic_load(&memdl_trace_hook) != NULL);
+}
+
+void memdl_set_trace_hook(const memdl_trace_fn hook, void *user) {
+    atomic_store(&memdl_trace_user, user);
+    atomic_store(&memdl_trace_hook, hook);
+    atomic_store(&memdl_timing, hook != NULL || atomic_load(&memdl_instrumented));
+}
+
+int memdl_get_load_info(memdl_handle_t handle, memdl_load_info_t *info) {
+    if (!handle || !info) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    *info = ((const memdl_lib_t *) handle)->info;
+    return 0;
+}
+
+void memdl_get_stats(memdl_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    stats->loads = atomic_load_explicit(&memdl_stat_loads, memory_order_relaxed);
+    stats->failures = atomic_load_explicit(&memdl_stat_failures, memory_order_relaxed);
+    stats->cache_hits = atomic_load_explicit(&memdl_cache_hits, memory_order_relaxed);
+    stats->bytes_copied = atomic_load_explicit(&memdl_stat_bytes, memory_order_relaxed);
+    for (int i = 0; i < MEMDL_STRATEGY_COUNT; i++) {
+        stats->strategy[i] = atomic_load_explicit(&memdl_stat_strategy[i], memory_order_relaxed);
+    }
+    for (int i = 0; i < MEMDL_TRACE_STAGES; i++) {
+        stats->stage_ns[i] = atomic_load_explicit(&memdl_stat_stage_ns[i], memory_order_relaxed);
+    }
+    stats->total_ns = atomic_load_explicit(&memdl_stat_total_ns, memory_order_relaxed);
+}
+
+static memdl_lib_t *memdl_lib_new(void *dl, const uint64_t hash, const size_t size) {
+    memdl_lib_t *lib = calloc(1, sizeof(memdl_lib_t));
+    if (!lib) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return NULL;
+    }
+    lib->dl = dl;
+    lib->fd = -1;
+    lib->hash = hash;
+    lib->size = size;
+    lib->refcount = 1;
+    return lib;
+}
+
+static int memdl_dl_flags(const int flags) {
+    int dl_flags = (flags & MEMDL_NOW) ? RTLD_NOW : RTLD_LAZY;
+    dl_flags |= (flags & MEMDL_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
+    return dl_flags;
+}
+
+// 描述符中的内容是否与 data 完全相同（长度已由调用者比较）
+static int memdl_fd_equals(const int fd, const void *data, const size_t size) {
+    unsigned char chunk[16384];
+    const unsigned char *p = data;
+    for (size_t off = 0; off < size;) {
+        const size_t want = size - off < sizeof(chunk) ? size - off : sizeof(chunk);
+        const ssize_t n = pread(fd, chunk, want, (off_t) off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0 || memcmp(chunk, p + off, (size_t) n) != 0) {
+            return 0;
+        }
+        off += (size_t) n;
+    }
+    return 1;
+}
+
+// 查找缓存并增加引用计数，调用者需持有对应桶的锁。
+// 键为内容哈希、大小、原生/dlopen 和 RTLD_* 标志，命中不读镜像
+static memdl_lib_t *memdl_cache_find(const memdl_image_t *img, const uint64_t hash, const int flags) {
+    const int native = (flags & MEMDL_NATIVE) != 0;
+    const int dl_flags = memdl_dl_flags(flags);
+    for (memdl_lib_t *lib = memdl_cache_table[hash % MEMDL_CACHE_BUCKETS]; lib; lib = lib->next) {
+        if (lib->hash == hash && lib->size == img->size && (lib->native != NULL) == native &&
+            lib->dl_flags == dl_flags) {
+            atomic_fetch_add_explicit(&lib->refcount, 1, memory_order_relaxed);
+            return lib;
+        }
+    }
+    return NULL;
+}
+
+// 登记到缓存，调用者需持有对应桶的锁
+static void memdl_cache_insert(memdl_lib_t *lib) {
+    memdl_lib_t **bucket = &memdl_cache_table[lib->hash % MEMDL_CACHE_BUCKETS];
+    lib->next = *bucket;
+    lib->cached = 1;
+    *bucket = lib;
+    atomic_fetch_add_explicit(&memdl_cache_entries, 1, memory_order_relaxed);
+}
+
+// 从缓存移除，调用者需持有对应桶的锁
+static void memdl_cache_remove(memdl_lib_t *lib) {
+    memdl_lib_t **pp = &memdl_cache_table[lib->hash % MEMDL_CACHE_BUCKETS];
+    while (*pp && *pp != lib) {
+        pp = &(*pp)->next;
+    }
+    if (*pp) {
+        *pp = lib->next;
+        atomic_fetch_sub_explicit(&memdl_cache_entries, 1, memory_order_relaxed);
+    }
+    lib->next = NULL;
+}
+
+// [addr, addr + len) 是否落在 [lo, hi) 内
+static int memdl_span_contains(const uintptr_t lo, const uintptr_t hi, const uintptr_t addr, const size_t len) {
+    return addr >= lo && addr <= hi && len <= hi - addr;
+}
+
+// 由哈希表推算 .dynsym 中的符号数，与查找一致优先使用 DT_GNU_HASH。哈希表须位于镜像映射 [lo, hi) 内：
+// 桶数或布隆过滤器大小为 0、任一表或链越界时返回 0，调用者据此拒绝镜像或放弃索引
+static size_t memdl_dynsym_count(const uint32_t *sysv_hash, const uint32_t *gnu_hash, const uintptr_t lo,
+                                 const uintptr_t hi) {
+    if (!gnu_hash) {
+        if (!sysv_hash || !memdl_span_contains(lo, hi, (uintptr_t) sysv_hash, 2 * sizeof(uint32_t))) {
+            return 0;
+        }
+        const size_t nbucket = sysv_hash[0], nchain = sysv_hash[1];
+        if (nbucket == 0 ||
+            !memdl_span_contains(lo, hi, (uintptr_t) sysv_hash, (2 + nbucket + nchain) * sizeof(uint32_t))) {
+            return 0;
+        }
+        return nchain;
+    }
+    if (!memdl_span_contains(lo, hi, (uintptr_t) gnu_hash, 4 * sizeof(uint32_t))) {
+        return 0;
+    }
+    const uint32_t nbuckets = gnu_hash[0];
+    const uint32_t symoffset = gnu_hash[1];
+    const uint32_t bloom_size = gnu_hash[2];
+    if (nbuckets == 0 || bloom_size == 0 ||
+        !memdl_span_contains(lo, hi, (uintptr_t) gnu_hash,
+                             4 * sizeof(uint32_t) + bloom_size * sizeof(ElfW(Addr)) + nbuckets * sizeof(uint32_t))) {
+        return 0;
+    }
+    const uint32_t *buckets = (const uint32_t *) ((const ElfW(Addr) *) (gnu_hash + 4) + bloom_size);
+    const uint32_t *chain = buckets + nbuckets;
+    uint32_t last = 0;
+    for (uint32_t i = 0; i < nbuckets; i++) {
+        if (buckets[i] > last) last = buckets[i];
+    }
+    if (last < symoffset) {
+        return symoffset;
+    }
+    // 链以最低位为 1 的项结束，逐项确认仍在映射内
+    for (;; last++) {
+        const uint32_t *entry = chain + ((size_t) last - symoffset);
+        if (!memdl_span_contains(lo, hi, (uintptr_t) entry, sizeof(uint32_t))) {
+            return 0;
+        }
+        if (*entry & 1) {
+            return (size_t) last + 1;
+        }
+    }
+}
+
+// 为 .dynsym 中的导出符号构建索引
+static memdl_symindex_t *memdl_symindex_build(const uintptr_t bias, const ElfW(Sym) *symtab, const char *strtab,
+                                              const size_t strsz, const ElfW(Half) *versym, const size_t nsyms) {
+    size_t capacity = 16;
+    while (capacity < nsyms * 2) {
+        capacity <<= 1;
+    }
+    memdl_symindex_t *index = calloc(1, sizeof(memdl_symindex_t) + capacity * sizeof(memdl_symslot_t));
+    if (!index) {
+        return NULL;
+    }
+    index->mask = capacity - 1;
+
+    for (size_t i = 1; i < nsyms; i++) {
+        const ElfW(Sym) *sym = &symtab[i];
+        const int bind = ELF64_ST_BIND(sym->st_info);
+        const int type = ELF64_ST_TYPE(sym->st_info);
+        const int vis = ELF64_ST_VISIBILITY(sym->st_other);
+        if (sym->st_shndx == SHN_UNDEF || sym->st_name >= strsz || type == STT_TLS ||
+            (bind != STB_GLOBAL && bind != STB_WEAK && bind != STB_GNU_UNIQUE) ||
+            (vis != STV_DEFAULT && vis != STV_PROTECTED)) {
+            continue;
+        }
+        // 跳过非默认版本（隐藏版本）的同名符号
+        if (versym && (versym[i] & 0x8000)) {
+            continue;
+        }
+        if (sym->st_shndx == SHN_ABS && sym->st_value == 0) {
+            continue;
+        }
+        // IFUNC 不进索引：解析函数只在真正查找该符号时由 dlsym 或原生加载器按平台约定调用
+        if (type == STT_GNU_IFUNC) {
+            continue;
+        }
+
+        const char *name = strtab + sym->st_name;
+        const uintptr_t addr = sym->st_shndx == SHN_ABS ? sym->st_value : bias + sym->st_value;
+
+        const uint32_t h = memdl_gnu_hash(name);
+        size_t slot = h & index->mask;
+        while (index->slots[slot].name && strcmp(index->slots[slot].name, name) != 0) {
+            slot = (slot + 1) & index->mask;
+        }
+        if (!index->slots[slot].name) {
+            index->slots[slot].name = name;
+            index->slots[slot].addr = (void *) addr;
+            index->slots[slot].hash = h;
+            index->count++;
+        }
+    }
+    return index;
+}
+
+static void *memdl_symindex_find(const memdl_symindex_t *index, const char *name) {
+    const uint32_t h = memdl_gnu_hash(name);
+    for (size_t slot = h & index->mask;; slot = (slot + 1) & index->mask) {
+        const memdl_symslot_t *entry = &index->slots[slot];
+        if (!entry->name) {
+            return NULL;
+        }
+        if (entry->hash == h && strcmp(entry->name, name) == 0) {
+            return entry->addr;
+        }
+    }
+}
+
+// glibc 加载时把动态段中的地址改写为运行地址；动态段只读的架构（MIPS、RISC-V）和其他 C 库保持链接时的值
+#if defined(__GLIBC__) && !defined(__mips__) && !defined(__riscv)
+#define MEMDL_DYN_BIAS(bias) 0
+#else
+#define MEMDL_DYN_BIAS(bias) (bias)
+#endif
+
+typedef struct {
+    const struct link_map *lm;
+    uintptr_t lo;
+    uintptr_t hi;
+} memdl_dl_span_t;
+
+// 按加载偏移与名称找到 link_map 对应的 dl_iterate_phdr 条目，取其 PT_LOAD 覆盖的地址范围
+static int memdl_dl_span(struct dl_phdr_info *dl_info, size_t size, void *ctx) {
+    (void) size;
+    memdl_dl_span_t *span = ctx;
+    if (dl_info->dlpi_addr != span->lm->l_addr || !dl_info->dlpi_name ||
+        strcmp(dl_info->dlpi_name, span->lm->l_name) != 0) {
+        return 0;
+    }
+    span->lo = UINTPTR_MAX;
+    for (size_t i = 0; i < dl_info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *ph = &dl_info->dlpi_phdr[i];
+        if (ph->p_type == PT_LOAD && ph->p_memsz > 0) {
+            const uintptr_t start = dl_info->dlpi_addr + ph->p_vaddr;
+            if (start < span->lo) span->lo = start;
+            if (start + ph->p_memsz > span->hi) span->hi = start + ph->p_memsz;
+        }
+    }
+    return 1;
+}
+
+// 通过 link_map 读取 dlopen 句柄的动态段并构建索引；哈希表或符号表不在镜像映射内时不建索引（回退到 dlsym）
+static memdl_symindex_t *memdl_symindex_from_dl(void *dl) {
+    struct link_map *lm = NULL;
+    if (dlinfo(dl, RTLD_DI_LINKMAP, &lm) != 0 || !lm || !lm->l_ld || !lm->l_name) {
+        return NULL;
+    }
+    memdl_dl_span_t span = {lm, 0, 0};
+    dl_iterate_phdr(memdl_dl_span, &span);
+    if (span.hi <= span.lo) {
+        return NULL;
+    }
+
+    const uintptr_t bias = lm->l_addr;
+    const ElfW(Sym) *symtab = NULL;
+    const char *strtab = NULL;
+    const ElfW(Half) *versym = NULL;
+    const uint32_t *sysv_hash = NULL, *gnu_hash = NULL;
+    size_t strsz = 0;
+    for (const ElfW(Dyn) *d = lm->l_ld; d->d_tag != DT_NULL; d++) {
+        const uintptr_t ptr = d->d_un.d_ptr + MEMDL_DYN_BIAS(bias);
+        switch (d->d_tag) {
+            case DT_SYMTAB: symtab = (const ElfW(Sym) *) ptr; break;
+            case DT_STRTAB: strtab = (const char *) ptr; break;
+            case DT_STRSZ: strsz = d->d_un.d_val; break;
+            case DT_VERSYM: versym = (const ElfW(Half) *) ptr; break;
+            case DT_HASH: sysv_hash = (const uint32_t *) ptr; break;
+            case DT_GNU_HASH: gnu_hash = (const uint32_t *) ptr; break;
+            default: break;
+        }
+    }
+    const size_t nsyms = memdl_dynsym_count(sysv_hash, gnu_hash, span.lo, span.hi);
+    if (!symtab || !strtab || nsyms == 0 ||
+        !memdl_span_contains(span.lo, span.hi, (uintptr_t) symtab, nsyms * sizeof(ElfW(Sym)))) {
+        return NULL;
+    }
+    return memdl_symindex_build(bias, symtab, strtab, strsz, versym, nsyms);
+}
+
+memdl_handle_t memdl_open_file(const char *filename, const int flags) {
     int dl_flags = (flags & MEMDL_NOW) ? RTLD_NOW : RTLD_LAZY;
     dl_flags |= (flags & MEMDL_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
+    memdl_stage = MEMDL_STAGE_LINK;
+    memdl_load_info_t info;
+    memdl_load_info_t *outer = memdl_load_begin(&info);
+    memdl_load_note(MEMDL_STRATEGY_FILE, 0);
+    const uint64_t start = memdl_trace_begin();
+    void *dl = dlopen(filename, dl_flags);
+    memdl_trace_end(MEMDL_TRACE_LINK, start);
+    memdl_lib_t *lib = NULL;
+    if (!dl) {
+        memdl_set_dl_error();
+    } else if (!(lib = memdl_lib_new(dl, 0, 0))) {
+        dlclose(dl);
+    } else {
+        const uint64_t index_start = memdl_trace_begin();
+        lib->index = memdl_symindex_from_dl(dl);
+        memdl_trace_end(MEMDL_TRACE_INDEX, index_start);
+    }
+    if (start) {
+        info.total_ns = memdl_now_ns() - start;
+    }
+    memdl_load_end(lib, &info, outer);
+    return lib;
+}
+
+// 定义memfd相关常量（如果系统头文件没有定义）
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS (1024 + 9)
+#define F_GET_SEALS (1024 + 10)
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#define F_SEAL_WRITE 0x0008
+#endif
+
+// memdl_buffer_alloc 分配的 memfd 映射缓冲区
+typedef struct memdl_buffer {
+    void *addr;
+    size_t size;
+    int fd;
+    int sealed;                 // 已转为只读并封印
+    struct memdl_buffer *next;
+} memdl_buffer_t;
+
+static pthread_mutex_t memdl_buffer_lock = PTHREAD_MUTEX_INITIALIZER;
+static memdl_buffer_t *memdl_buffers = NULL;
+static atomic_size_t memdl_buffer_count = 0;
+
+// ---------------------------------------------------------------------------
+// 落地方式：首次需要时探测一次各方式是否可用（创建、写入一页并做可执行映射）并计时，
+// 之后每次加载按顺序直接选用，不再为不可用的方式浪费系统调用
+// ---------------------------------------------------------------------------
+
+#ifndef MFD_NOEXEC_SEAL
+#define MFD_NOEXEC_SEAL 0x0008U
+#endif
+#ifndef MFD_EXEC
+#define MFD_EXEC 0x0010U
+#endif
+#define MEMDL_TMPFS_MAGIC 0x01021994
+
+static pthread_once_t memdl_probe_once = PTHREAD_ONCE_INIT;
+static unsigned memdl_caps = 0;
+static uint64_t memdl_probe_ns[MEMDL_BACKING_COUNT];
+static const char *memdl_tmpfs_dir = NULL;     // O_TMPFILE 所在的 tmpfs 目录
+static unsigned memdl_memfd_exec = 0;          // 支持时为 MFD_EXEC
+static unsigned memdl_auto_order = 0;          // 默认顺序，每 4 位一项，低位先试
+static atomic_uint memdl_user_order = 0;       // memdl_set_strategy 指定的顺序，0 表示默认
+
+// 写入一页并尝试可执行映射，noexec 挂载与 vm.memfd_noexec 都在这里暴露；成功返回 0，fd 总会被关闭
+static int memdl_probe_fd(const int fd) {
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    int result = -1;
+    if (fd >= 0 && ftruncate(fd, (off_t) page) == 0) {
+        void *addr = mmap(NULL, page, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            munmap(addr, page);
+            result = 0;
+        }
+    }
+    if (fd >= 0) close(fd);
+    return result;
+}
+
+static int memdl_probe_tmpfs(const char *dir) {
+    struct statfs fs;
+    return statfs(dir, &fs) == 0 && fs.f_type == MEMDL_TMPFS_MAGIC ? 0 : -1;
+}
+
+static int memdl_probe_path(const char *dir) {
+    char path[64];
+    snprintf(path, sizeof(path), "%s/memdl_XXXXXX", dir);
+    const int fd = mkostemp(path, O_CLOEXEC);
+    if (fd >= 0) unlink(path);
+    return memdl_probe_fd(fd);
+}
+
+// 按落地方式完整走一遍创建、写入与可执行映射
+static int memdl_probe_backing(const int backing) {
+    switch (backing) {
+        case MEMDL_BACKING_MEMFD:
+            return memdl_probe_fd((int) syscall(SYS_memfd_create, "memdl_probe",
+                                                MFD_CLOEXEC | MFD_ALLOW_SEALING | memdl_memfd_exec));
+        case MEMDL_BACKING_TMPFILE:
+            return memdl_probe_fd(open(memdl_tmpfs_dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0700));
+        default:
+            return memdl_probe_path("/dev/shm");
+    }
+}
+
+#define MEMDL_PROBE_ROUNDS 4
+
+static void memdl_probe(void) {
+    if (access("/proc/self/fd", R_OK | X_OK) == 0) {
+        memdl_caps |= MEMDL_CAP_PROC_FD;
+    }
+    int fd = (int) syscall(SYS_memfd_create, "memdl_probe", MFD_CLOEXEC | MFD_EXEC);
+    if (fd >= 0) {
+        memdl_caps |= MEMDL_CAP_MEMFD_EXEC;
+        memdl_memfd_exec = MFD_EXEC;
+        close(fd);
+    }
+    if (memdl_probe_backing(MEMDL_BACKING_MEMFD) == 0) {
+        memdl_caps |= MEMDL_CAP_MEMFD;
+    }
+    fd = (int) syscall(SYS_memfd_create, "memdl_probe", MFD_CLOEXEC | MFD_NOEXEC_SEAL);
+    if (fd >= 0) {
+        memdl_caps |= MEMDL_CAP_MEMFD_NOEXEC_SEAL;
+        close(fd);
+    }
+    static const char *const tmpfs_dirs[] = {"/dev/shm", "/tmp"};
+    for (size_t i = 0; i < sizeof(tmpfs_dirs) / sizeof(tmpfs_dirs[0]) && !memdl_tmpfs_dir; i++) {
+        if (memdl_probe_tmpfs(tmpfs_dirs[i]) == 0 &&
+            memdl_probe_fd(open(tmpfs_dirs[i], O_TMPFILE | O_RDWR | O_CLOEXEC, 0700)) == 0) {
+            memdl_caps |= MEMDL_CAP_O_TMPFILE;
+            memdl_tmpfs_dir = tmpfs_dirs[i];
+        }
+    }
+    if (memdl_probe_tmpfs("/dev/shm") == 0 && memdl_probe_path("/dev/shm") == 0) {
+        memdl_caps |= MEMDL_CAP_DEV_SHM;
+    }
+
+    // 可用的方式交替计时多轮取最小值；memfd 与 O_TMPFILE 经 /proc/self/fd 加载，没有 /proc 时不可用
+    int usable[MEMDL_BACKING_COUNT] = {0};
+    usable[MEMDL_BACKING_MEMFD] = (memdl_caps & MEMDL_CAP_MEMFD) && (memdl_caps & MEMDL_CAP_PROC_FD);
+    usable[MEMDL_BACKING_TMPFILE] = (memdl_caps & MEMDL_CAP_O_TMPFILE) && (memdl_caps & MEMDL_CAP_PROC_FD);
+    usable[MEMDL_BACKING_SHM] = (memdl_caps & MEMDL_CAP_DEV_SHM) != 0;
+    for (int round = 0; round < MEMDL_PROBE_ROUNDS; round++) {
+        for (int b = MEMDL_BACKING_MEMFD; b < MEMDL_BACKING_DISK; b++) {
+            if (!usable[b]) continue;
+            const uint64_t start = memdl_now_ns();
+            if (memdl_probe_backing(b) != 0) continue;
+            const uint64_t elapsed = memdl_now_ns() - start + 1;
+            if (!memdl_probe_ns[b] || elapsed < memdl_probe_ns[b]) memdl_probe_ns[b] = elapsed;
+        }
+    }
+
+    // 按耗时插入排序，后面的方式要快出 25% 以上才排到前面（memfd 可封印、带镜像名，相近时优先）；
+    // /tmp 不探测（避免写盘），总是放在最后
+    int order[MEMDL_BACKING_COUNT];
+    size_t count = 0;
+    for (int b = MEMDL_BACKING_MEMFD; b < MEMDL_BACKING_DISK; b++) {
+        if (!memdl_probe_ns[b]) continue;
+        size_t i = count++;
+        while (i > 0 && memdl_probe_ns[order[i - 1]] * 4 > memdl_probe_ns[b] * 5) {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = b;
+    }
+    order[count++] = MEMDL_BACKING_DISK;
+    for (size_t i = 0; i < count; i++) {
+        memdl_auto_order |= (unsigned) order[i] << (4 * i);
+    }
+}
+
+static unsigned memdl_backing_order(void) {
+    pthread_once(&memdl_probe_once, memdl_probe);
+    const unsigned order = atomic_load_explicit(&memdl_user_order, memory_order_acquire);
+    return order ? order : memdl_auto_order;
+}
+
+static int memdl_backing_usable(const int backing) {
+    switch (backing) {
+        case MEMDL_BACKING_DISK: return 1;
+        default: return memdl_probe_ns[backing] != 0;
+    }
+}
+
+int memdl_set_strategy(const int *order, const size_t count) {
+    pthread_once(&memdl_probe_once, memdl_probe);
+    if (!order || count == 0) {
+        atomic_store(&memdl_user_order, 0);
+        return 0;
+    }
+    if (count >= MEMDL_BACKING_COUNT) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Too many strategies");
+        return -1;
+    }
+    unsigned packed = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (order[i] < MEMDL_BACKING_MEMFD || order[i] >= MEMDL_BACKING_COUNT) {
+            memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid strategy %d", order[i]);
+            return -1;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (order[j] == order[i]) {
+                memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Duplicate strategy %d", order[i]);
+                return -1;
+            }
+        }
+        if (!memdl_backing_usable(order[i])) {
+            memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Strategy %d is not available here", order[i]);
+            return -1;
+        }
+        packed |= (unsigned) order[i] << (4 * i);
+    }
+    atomic_store(&memdl_user_order, packed);
+    return 0;
+}
+
+int memdl_get_caps(memdl_caps_t *caps) {
+    if (!caps) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    unsigned order = memdl_backing_order();
+    memset(caps, 0, sizeof(*caps));
+    caps->caps = memdl_caps;
+    memcpy(caps->probe_ns, memdl_probe_ns, sizeof(caps->probe_ns));
+    for (size_t i = 0; order; i++, order >>= 4) {
+        caps->order[i] = (int) (order & 0xf);
+    }
+    return 0;
+}
+
+// 有 DT_SONAME 的镜像以 "memdl:<soname>" 命名，/proc/self/maps 中可区分各插件的映射；img 为 NULL 时用通用名。
+// 探测到 memfd 不可用时直接失败，不再发起系统调用
+static int memdl_memfd_create(const memdl_image_t *img, const unsigned int mfd_flags) {
+    pthread_once(&memdl_probe_once, memdl_probe);
+    if (!(memdl_caps & MEMDL_CAP_MEMFD)) {
+        errno = ENOSYS;
+        return -1;
+    }
+    char name[250] = "memdl_lib";   // memfd 名称上限 249 字节
+    if (img && img->soname != MEMDL_NO_OFFSET) {
+        snprintf(name, sizeof(name), "memdl:%s", (const char *) img->data + img->strtab_off + img->soname);
+    }
+    return (int) syscall(SYS_memfd_create, name, MFD_CLOEXEC | memdl_memfd_exec | mfd_flags);
+}
+
+// 完整写入，处理部分写入和 EINTR
+static int memdl_write_all(const int fd, const void *data, size_t size) {
+    const unsigned char *p = data;
+    while (size > 0) {
+        const ssize_t n = write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        size -= (size_t) n;
+    }
+    return 0;
+}
+
+static void *memdl_dlopen_fd(const int fd, const int dl_flags) {
+    memdl_stage = MEMDL_STAGE_LINK;
+    char fd_path[64];
+    snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", fd);
+    void *handle = dlopen(fd_path, dl_flags);
+    if (!handle) {
+        memdl_set_dl_error();
+    }
+    return handle;
+}
+
+// 查找包含整个镜像的已分配缓冲区，调用者需持有 memdl_buffer_lock
+static memdl_buffer_t *memdl_buffer_find(const void *so_data, const size_t so_size) {
+    for (memdl_buffer_t *buf = memdl_buffers; buf; buf = buf->next) {
+        if (buf->addr == so_data && so_size <= buf->size) {
+            return buf;
+        }
+    }
+    return NULL;
+}
+
+// 缓冲区加载前转为只读私有映射并封印，防止调用者修改已映射的库
+static int memdl_buffer_seal(memdl_buffer_t *buf) {
+    if (buf->sealed) {
+        return 0;
+    }
+    void *addr = mmap(buf->addr, buf->size, PROT_READ, MAP_PRIVATE | MAP_FIXED, buf->fd, 0);
+    if (addr == MAP_FAILED) {
+        memdl_set_sys_error("Failed to remap buffer read-only");
+        return -1;
+    }
+    fcntl(buf->fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW);
+    buf->sealed = 1;
+    return 0;
+}
+
+// 取得 memdl_buffer_alloc 分配的缓冲区对应的已封印 memfd 副本，无需复制；不是此类缓冲区时返回 -2
+static int memdl_buffer_fd(const void *so_data, const size_t so_size) {
+    // 没有分配过缓冲区时不碰全局锁
+    if (atomic_load_explicit(&memdl_buffer_count, memory_order_acquire) == 0) {
+        return -2;
+    }
+    pthread_mutex_lock(&memdl_buffer_lock);
+    memdl_buffer_t *buf = memdl_buffer_find(so_data, so_size);
+    if (!buf) {
+        pthread_mutex_unlock(&memdl_buffer_lock);
+        return -2;
+    }
+    int fd = -1;
+    if (memdl_buffer_seal(buf) == 0) {
+        fd = fcntl(buf->fd, F_DUPFD_CLOEXEC, 0);
+        if (fd < 0) {
+            memdl_set_sys_error("dup failed");
+        }
+    }
+    pthread_mutex_unlock(&memdl_buffer_lock);
+    return fd;
+}
+
+static int memdl_fd_sink(void *ctx, const void *data, const size_t len) {
+    return memdl_write_all(*(const int *) ctx, data, len);
+}
+
+// 准备阶段的产物：写好镜像的描述符；path 非空表示按路径加载的临时文件，链接后删除
+typedef struct {
+    int fd;
+    char path[32];
+} memdl_staged_t;
+
+static void memdl_staged_drop(memdl_staged_t *staged) {
+    if (!staged) {
+        return;
+    }
+    if (staged->fd >= 0) close(staged->fd);
+    if (staged->path[0]) unlink(staged->path);
+    staged->fd = -1;
+    staged->path[0] = '\0';
+}
+
+// 写入镜像；digest 非 NULL 时边写边计算镜像摘要，每段数据趁还在缓存里写出
+static int memdl_stage_copy(const memdl_image_t *img, int fd, uint64_t *digest) {
+    const uint64_t start = memdl_trace_begin();
+    if ((digest ? memdl_digest_copy(img->data, img->size, digest, memdl_fd_sink, &fd)
+                : memdl_write_all(fd, img->data, img->size)) != 0) {
+        return -1;
+    }
+    memdl_trace_end(MEMDL_TRACE_COPY, start);
+    return 0;
+}
+
+// 以描述符方式落地：memfd 写入后封印，O_TMPFILE 为 tmpfs 上没有名字的文件，经 /proc/self/fd 加载；失败返回 -1
+static int memdl_prepare_fd(const memdl_image_t *img, const int backing, uint64_t *digest) {
+    uint64_t start = memdl_trace_begin();
+    const int fd = backing == MEMDL_BACKING_MEMFD ? memdl_memfd_create(img, MFD_ALLOW_SEALING)
+                                                  : open(memdl_tmpfs_dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0700);
+    memdl_trace_end(MEMDL_TRACE_CREATE, start);
+    if (fd < 0) {
+        return -1;
+    }
+    if (memdl_stage_copy(img, fd, digest) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (backing == MEMDL_BACKING_TMPFILE) {
+        memdl_load_note(MEMDL_STRATEGY_TMPFILE, img->size);
+        return fd;
+    }
+    memdl_load_note(MEMDL_STRATEGY_MEMFD, img->size);
+
+    start = memdl_trace_begin();
+    fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW);
+    memdl_trace_end(MEMDL_TRACE_SEAL, start);
+    return fd;
+}
+
+// 以路径方式落地：/dev/shm 或 /tmp 中的临时文件，不需要 /proc；成功时 staged 带上路径
+static int memdl_prepare_path(const memdl_image_t *img, const int backing, memdl_staged_t *staged,
+                              uint64_t *digest) {
+    snprintf(staged->path, sizeof(staged->path), "%s/memdl_XXXXXX",
+             backing == MEMDL_BACKING_SHM ? "/dev/shm" : "/tmp");
+    const uint64_t start = memdl_trace_begin();
+    const int fd = mkostemp(staged->path, O_CLOEXEC);
+    memdl_trace_end(MEMDL_TRACE_CREATE, start);
+    if (fd < 0) {
+        staged->path[0] = '\0';
+        return -1;
+    }
+    staged->fd = fd;
+    if (memdl_stage_copy(img, fd, digest) != 0) {
+        memdl_staged_drop(staged);
+        return -1;
+    }
+    memdl_load_note(MEMDL_STRATEGY_TMPFILE, img->size);
+    return 0;
+}
+
+// 准备阶段（可并行）：按落地顺序逐项尝试，描述符方式与路径方式都在这里落地，创建或写入失败才换下一项；
+// MEMDL_TMPFILE 只用路径方式。digest 非 NULL 时同时给出镜像摘要（复制时顺带计算，无需复制时单独计算）。
+// 成功返回 0，失败返回 -1 并设置错误
+static int memdl_prepare_image(const memdl_image_t *img, const int flags, memdl_staged_t *staged, uint64_t *digest) {
+    staged->fd = -1;
+    staged->path[0] = '\0';
+    if (!(flags & MEMDL_TMPFILE)) {
+        staged->fd = memdl_buffer_fd(img->data, img->size);
+        if (staged->fd >= 0) {
+            memdl_load_note(MEMDL_STRATEGY_BUFFER, 0);
+            if (digest) {
+                const uint64_t start = memdl_trace_begin();
+                *digest = memdl_digest(img->data, img->size);
+                memdl_trace_end(MEMDL_TRACE_HASH, start);
+            }
+            return 0;
+        }
+        staged->fd = -1;
+    }
+    for (unsigned order = memdl_backing_order(); order && staged->fd < 0; order >>= 4) {
+        const int backing = (int) (order & 0xf);
+        const int by_path = backing == MEMDL_BACKING_SHM || backing == MEMDL_BACKING_DISK;
+        if (((flags & MEMDL_TMPFILE) && !by_path) || !memdl_backing_usable(backing)) {
+            continue;
+        }
+        if (by_path) {
+            memdl_prepare_path(img, backing, staged, digest);
+        } else {
+            staged->fd = memdl_prepare_fd(img, backing, digest);
+        }
+    }
+    if (staged->fd < 0) {
+        memdl_set_error_code(MEMDL_ERR_LOADER, errno, "All loading methods failed");
+        return -1;
+    }
+    return 0;
+}
+
+// 链接阶段（dlopen 内部串行）：加载准备好的镜像，成功时 fd 交给 *held 保持打开，失败时关闭。
+// 这里的失败是动态链接器的真实错误，换一种落地方式也不会成功，不再降级
+static void *memdl_link_image(memdl_staged_t *staged, const int dl_flags, int *held) {
+    if (!staged || staged->fd < 0) {
+        memdl_set_error_code(MEMDL_ERR_LOADER, 0, "All loading methods failed");
+        return NULL;
+    }
+    memdl_stage = MEMDL_STAGE_LINK;
+    const uint64_t start = memdl_trace_begin();
+    void *handle = NULL;
+    if (staged->path[0]) {
+        handle = dlopen(staged->path, dl_flags);
+        if (!handle) {
+            memdl_set_dl_error();
+        }
+        unlink(staged->path);
+        staged->path[0] = '\0';
+    } else {
+        handle = memdl_dlopen_fd(staged->fd, dl_flags);
+    }
+    memdl_trace_end(MEMDL_TRACE_LINK, start);
+    if (handle) {
+        *held = staged->fd;
+        staged->fd = -1;
+    }
+    memdl_staged_drop(staged);
+    return handle;
+}
+
+// 在内核中把 src 的内容复制到 dst，避免经过用户态缓冲区
+static int memdl_copy_fd(const int src, const int dst) {
+    struct stat st;
+    if (fstat(src, &st) != 0) {
+        return -1;
+    }
+
+    if (S_ISREG(st.st_mode)) {
+        // 普通文件：copy_file_range，不支持时降级为 sendfile；块设备的 st_size 为 0，走下面的 read 循环
+        loff_t in_off = 0;
+        size_t remaining = (size_t) st.st_size;
+        int use_sendfile = 0;
+        while (remaining > 0) {
+            ssize_t n;
+            if (!use_sendfile) {
+                n = copy_file_range(src, &in_off, dst, NULL, remaining, 0);
+                if (n < 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)) {
+                    use_sendfile = 1;
+                    continue;
+                }
+            } else {
+                off_t off = (off_t) in_off;
+                n = sendfile(dst, src, &off, remaining);
+                in_off = (loff_t) off;
+            }
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+            if (n == 0) {
+                // 文件在复制途中被截短，内容已不完整
+                errno = EIO;
+                return -1;
+            }
+            remaining -= (size_t) n;
+        }
+        return 0;
+    }
+
+    // 管道：splice 直接送入 memfd
+    if (S_ISFIFO(st.st_mode)) {
+        for (;;) {
+            const ssize_t n = splice(src, NULL, dst, NULL, 1 << 20, SPLICE_F_MOVE);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EINVAL) break;  // 不支持时降级为 read/write
+                return -1;
+            }
+            if (n == 0) return 0;
+        }
+    }
+
+    // 其他类型（如套接字）：分块 read/write
+    char chunk[64 * 1024];
+    for (;;) {
+        const ssize_t n = read(src, chunk, sizeof(chunk));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) return 0;
+        if (memdl_write_all(dst, chunk, (size_t) n) != 0) {
+            return -1;
+        }
+    }
+}
+
+// 检查 fd 是否为已封印写入的 memfd，可直接映射而无需复制
+static int memdl_fd_is_sealed(const int fd) {
+    const int seals = fcntl(fd, F_GET_SEALS);
+    return seals >= 0 && (seals & F_SEAL_WRITE) && (seals & F_SEAL_SHRINK);
+}
+
+void *memdl_buffer_alloc(const size_t size) {
+    if (size == 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid size");
+        return NULL;
+    }
+    memdl_buffer_t *buf = calloc(1, sizeof(memdl_buffer_t));
+    if (!buf) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return NULL;
+    }
+
+    buf->fd = memdl_memfd_create(NULL, MFD_ALLOW_SEALING);
+    if (buf->fd < 0) {
+        memdl_set_sys_error("memfd_create failed");
+        free(buf);
+        return NULL;
+    }
+    if (ftruncate(buf->fd, (off_t) size) != 0) {
+        memdl_set_sys_error("ftruncate failed");
+        close(buf->fd);
+        free(buf);
+        return NULL;
+    }
+    buf->addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, buf->fd, 0);
+    if (buf->addr == MAP_FAILED) {
+        memdl_set_sys_error("mmap failed");
+        close(buf->fd);
+        free(buf);
+        return NULL;
+    }
+    buf->size = size;
+
+    pthread_mutex_lock(&memdl_buffer_lock);
+    buf->next = memdl_buffers;
+    memdl_buffers = buf;
+    atomic_fetch_add_explicit(&memdl_buffer_count, 1, memory_order_release);
+    pthread_mutex_unlock(&memdl_buffer_lock);
+    return buf->addr;
+}
+
+void memdl_buffer_free(void *buffer) {
+    if (!buffer) {
+        return;
+    }
+    pthread_mutex_lock(&memdl_buffer_lock);
+    memdl_buffer_t **pp = &memdl_buffers;
+    while (*pp && (*pp)->addr != buffer) {
+        pp = &(*pp)->next;
+    }
+    memdl_buffer_t *buf = *pp;
+    if (buf) {
+        *pp = buf->next;
+        atomic_fetch_sub_explicit(&memdl_buffer_count, 1, memory_order_release);
+    }
+    pthread_mutex_unlock(&memdl_buffer_lock);
+
+    if (!buf) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Unknown buffer");
+        return;
+    }
+    munmap(buf->addr, buf->size);
+    close(buf->fd);
+    free(buf);
+}
+
+// ---------------------------------------------------------------------------
+// 按需调页（MEMDL_ONDEMAND）：映射登记到 userfaultfd，页面首次访问时才由处理线程从源镜像复制或解压
+// ---------------------------------------------------------------------------
+
+#if defined(MEMDL_HAVE_UFFD) && !defined(SYS_userfaultfd)
+#undef MEMDL_HAVE_UFFD
+#endif
+
+// 段映射中的一段文件内容
+typedef struct {
+    uintptr_t addr;             // 运行地址
+    size_t size;                // p_filesz，段的其余部分为 0
+    const unsigned char *src;   // 源镜像中的位置，可能位于解压视图内
+} memdl_lazy_seg_t;
+
+#define MEMDL_LAZY_BLOCKS 4
+
+// 一个登记的地址范围：原生加载器的段映射，或压缩镜像的只读解压视图
+typedef struct memdl_lazy {
+    struct memdl_lazy *next;
+    uintptr_t lo;               // [lo, hi)
+    uintptr_t hi;
+    memdl_lazy_seg_t *segs;
+    size_t seg_count;
+    memdl_lz4_frame_t frame;    // 解压视图的帧，frame.blocks 为 NULL 表示段映射
+    size_t view_size;
+    // 最近解码的块（持有 memdl_lazy_lock 时访问）：代码与数据常位于不同的块，缓存一块会反复解码
+    unsigned char *block[MEMDL_LAZY_BLOCKS];
+    size_t block_index[MEMDL_LAZY_BLOCKS];
+    size_t block_len[MEMDL_LAZY_BLOCKS];
+    size_t block_next;
+    atomic_size_t faulted;
+    _Atomic(uint64_t) fault_ns;
+} memdl_lazy_t;
+
+static pthread_mutex_t memdl_lazy_lock = PTHREAD_MUTEX_INITIALIZER;
+static memdl_lazy_t *memdl_lazy_list = NULL;
+
+static void memdl_lazy_free(memdl_lazy_t *lazy) {
+    if (!lazy) {
+        return;
+    }
+    memdl_lz4_free(&lazy->frame);
+    for (int i = 0; i < MEMDL_LAZY_BLOCKS; i++) {
+        free(lazy->block[i]);
+    }
+    free(lazy->segs);
+    free(lazy);
+}
+
+static void memdl_lazy_unregister(memdl_lazy_t *lazy) {
+    pthread_mutex_lock(&memdl_lazy_lock);
+    memdl_lazy_t **pp = &memdl_lazy_list;
+    while (*pp && *pp != lazy) {
+        pp = &(*pp)->next;
+    }
+    if (*pp) {
+        *pp = lazy->next;
+    }
+    pthread_mutex_unlock(&memdl_lazy_lock);
+}
+
+// 注销并释放解压视图及其映射
+static void memdl_lazy_view_close(memdl_lazy_t *view) {
+    if (!view) {
+        return;
+    }
+    memdl_lazy_unregister(view);
+    munmap((void *) view->lo, view->hi - view->lo);
+    memdl_lazy_free(view);
+}
+
+#ifdef MEMDL_HAVE_UFFD
+#ifndef UFFD_USER_MODE_ONLY
+#define UFFD_USER_MODE_ONLY 1
+#endif
+
+static int memdl_uffd = -1;
+#ifdef UFFDIO_POISON
+static int memdl_uffd_poison = 0;
+#endif
+static size_t memdl_lazy_page_size = 0;
+static unsigned char *memdl_lazy_page = NULL;   // 填充页面的暂存区，持锁使用
+
+static memdl_lazy_t *memdl_lazy_find(const uintptr_t addr) {
+    memdl_lazy_t *lazy = memdl_lazy_list;
+    while (lazy && (addr < lazy->lo || addr >= lazy->hi)) {
+        lazy = lazy->next;
+    }
+    return lazy;
+}
+
+// 取得解码后的第 index 块，未缓存时解码并轮换替换一个缓存槽；返回槽号，失败返回 -1
+static int memdl_lazy_view_block(memdl_lazy_t *view, const size_t index) {
+    for (int i = 0; i < MEMDL_LAZY_BLOCKS; i++) {
+        if (view->block[i] && view->block_index[i] == index) return i;
+    }
+    const memdl_lz4_frame_t *frame = &view->frame;
+    const int slot = (int) (view->block_next++ % MEMDL_LAZY_BLOCKS);
+    if (!view->block[slot] && !(view->block[slot] = malloc(frame->block_max))) return -1;
+    const ptrdiff_t n = memdl_lz4_decode(frame, index, view->block[slot], frame->block_max, 0);
+    // 偏移按整块换算，除最后一块外都必须解出完整的块
+    if (n < 0 || (index + 1 < frame->count && (size_t) n != frame->block_max)) {
+        view->block_index[slot] = SIZE_MAX;
+        return -1;
+    }
+    view->block_index[slot] = index;
+    view->block_len[slot] = (size_t) n;
+    return slot;
+}
+
+// 从解压视图读取 [off, off + len)
+static int memdl_lazy_view_read(memdl_lazy_t *view, size_t off, unsigned char *out, size_t len) {
+    const memdl_lz4_frame_t *frame = &view->frame;
+    while (len > 0) {
+        const size_t index = off / frame->block_max;
+        const int slot = index < frame->count ? memdl_lazy_view_block(view, index) : -1;
+        if (slot < 0) return -1;
+        const size_t at = off - index * frame->block_max;
+        if (at >= view->block_len[slot]) return -1;
+        const size_t chunk = len < view->block_len[slot] - at ? len : view->block_len[slot] - at;
+        memcpy(out, view->block[slot] + at, chunk);
+        off += chunk;
+        out += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+// 生成 addr 处一页的内容。源数据位于解压视图时直接解码，不读视图映射：处理线程不能等待自己处理的缺页
+static int memdl_lazy_fill(memdl_lazy_t *lazy, const uintptr_t addr, unsigned char *out) {
+    const size_t page = memdl_lazy_page_size;
+    memset(out, 0, page);
+    if (lazy->frame.blocks) {
+        const size_t off = addr - lazy->lo;
+        if (off >= lazy->view_size) return 0;
+        return memdl_lazy_view_read(lazy, off, out, lazy->view_size - off < page ? lazy->view_size - off : page);
+    }
+    for (size_t i = 0; i < lazy->seg_count; i++) {
+        const memdl_lazy_seg_t *seg = &lazy->segs[i];
+        const uintptr_t lo = addr > seg->addr ? addr : seg->addr;
+        const uintptr_t hi = addr + page < seg->addr + seg->size ? addr + page : seg->addr + seg->size;
+        if (lo >= hi) continue;
+        const unsigned char *src = seg->src + (lo - seg->addr);
+        memdl_lazy_t *view = memdl_lazy_find((uintptr_t) src);
+        if (view && view->frame.blocks) {
+            if (memdl_lazy_view_read(view, (uintptr_t) src - view->lo, out + (lo - addr), hi - lo) != 0) return -1;
+        } else {
+            memcpy(out + (lo - addr), src, hi - lo);
+        }
+    }
+    return 0;
+}
+
+// 填充并安装一页（持锁调用）；源数据损坏时把页面标记为有毒，访问时触发 SIGBUS，内核不支持时安装零页
+static void memdl_lazy_serve(memdl_lazy_t *lazy, const uintptr_t addr) {
+    const uint64_t start = memdl_now_ns();
+    const size_t page = memdl_lazy_page_size;
+    const int ok = memdl_lazy_fill(lazy, addr, memdl_lazy_page) == 0;
+#ifdef UFFDIO_POISON
+    if (!ok && memdl_uffd_poison) {
+        struct uffdio_poison poison = {.range = {addr, page}, .mode = 0};
+        ioctl(memdl_uffd, UFFDIO_POISON, &poison);
+        return;
+    }
+#endif
+    if (!ok) {
+        memset(memdl_lazy_page, 0, page);
+    }
+    struct uffdio_copy copy = {.dst = addr, .src = (uintptr_t) memdl_lazy_page, .len = page, .mode = 0};
+    if (ioctl(memdl_uffd, UFFDIO_COPY, &copy) == 0) {
+        atomic_fetch_add_explicit(&lazy->faulted, 1, memory_order_relaxed);
+    } else if (errno == EEXIST) {
+        // 页面已由其他路径填充，唤醒可能仍在等待的线程
+        struct uffdio_range range = {addr, page};
+        ioctl(memdl_uffd, UFFDIO_WAKE, &range);
+    }
+    atomic_fetch_add_explicit(&lazy->fault_ns, memdl_now_ns() - start, memory_order_relaxed);
+}
+
+static void *memdl_uffd_handler(void *arg) {
+    const int fd = (int) (intptr_t) arg;
+    for (;;) {
+        struct uffd_msg msg;
+        const ssize_t n = read(fd, &msg, sizeof(msg));
+        if (n < 0 && errno == EINTR) continue;
+        if (n != (ssize_t) sizeof(msg)) break;
+        if (msg.event != UFFD_EVENT_PAGEFAULT) continue;
+        const uintptr_t addr = (uintptr_t) msg.arg.pagefault.address & ~(uintptr_t) (memdl_lazy_page_size - 1);
+        pthread_mutex_lock(&memdl_lazy_lock);
+        memdl_lazy_t *lazy = memdl_lazy_find(addr);
+        if (lazy) {
+            memdl_lazy_serve(lazy, addr);
+        } else {
+            // 范围已注销但尚未解除映射：补零页让访问线程继续
+            struct uffdio_zeropage zero = {.range = {addr, memdl_lazy_page_size}, .mode = 0};
+            ioctl(fd, UFFDIO_ZEROPAGE, &zero);
+        }
+        pthread_mutex_unlock(&memdl_lazy_lock);
+    }
+    return NULL;
+}
+
+// fork 前调入所有未驻留的页面：子进程继承的映射不再关联 userfaultfd，缺失的页面会变成零页
+static void memdl_lazy_atfork_prepare(void) {
+    pthread_mutex_lock(&memdl_lazy_lock);
+    const size_t page = memdl_lazy_page_size;
+    unsigned char vec[64];
+    for (memdl_lazy_t *lazy = memdl_lazy_list; lazy; lazy = lazy->next) {
+        for (uintptr_t addr = lazy->lo; addr < lazy->hi; addr += 64 * page) {
+            const size_t len = lazy->hi - addr < 64 * page ? lazy->hi - addr : 64 * page;
+            const int known = mincore((void *) addr, len, vec) == 0;
+            for (size_t i = 0; i < len / page; i++) {
+                if (!known || !(vec[i] & 1)) memdl_lazy_serve(lazy, addr + i * page);
+            }
+        }
+    }
+}
+
+static void memdl_lazy_atfork_parent(void) {
+    pthread_mutex_unlock(&memdl_lazy_lock);
+}
+
+// 子进程中没有处理线程，继承的 userfaultfd 也属于父进程
+static void memdl_lazy_atfork_child(void) {
+    if (memdl_uffd >= 0) {
+        close(memdl_uffd);
+        memdl_uffd = -1;
+    }
+    pthread_mutex_unlock(&memdl_lazy_lock);
+}
+
+// 先尝试同时处理内核态访问，没有权限时退回 UFFD_USER_MODE_ONLY
+static int memdl_uffd_open(const uint64_t features) {
+    static const int modes[] = {0, UFFD_USER_MODE_ONLY};
+    for (int i = 0; i < 2; i++) {
+        const int fd = (int) syscall(SYS_userfaultfd, O_CLOEXEC | modes[i]);
+        if (fd < 0) continue;
+        struct uffdio_api api = {.api = UFFD_API, .features = features};
+        if (ioctl(fd, UFFDIO_API, &api) == 0) return fd;
+        close(fd);
+    }
+    return -1;
+}
+
+// 创建 userfaultfd 与处理线程（持锁调用）
+static int memdl_uffd_start(void) {
+    static int atfork = 0;
+    if (memdl_uffd >= 0) {
+        return 0;
+    }
+    memdl_lazy_page_size = (size_t) sysconf(_SC_PAGESIZE);
+    if (!memdl_lazy_page) {
+        memdl_lazy_page = malloc(memdl_lazy_page_size);
+        if (!memdl_lazy_page) return -1;
+    }
+#ifdef UFFDIO_POISON
+    int fd = memdl_uffd_open(UFFD_FEATURE_POISON);
+    memdl_uffd_poison = fd >= 0;
+    if (fd < 0) fd = memdl_uffd_open(0);
+#else
+    const int fd = memdl_uffd_open(0);
+#endif
+    if (fd < 0) {
+        return -1;
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, memdl_uffd_handler, (void *) (intptr_t) fd) != 0) {
+        close(fd);
+        return -1;
+    }
+    pthread_detach(thread);
+    if (!atfork) {
+        pthread_atfork(memdl_lazy_atfork_prepare, memdl_lazy_atfork_parent, memdl_lazy_atfork_child);
+        atfork = 1;
+    }
+    memdl_uffd = fd;
+    return 0;
+}
+
+// 登记 [lazy->lo, lazy->hi) 并加入列表；userfaultfd 不可用时返回 -1，由调用者退回立即填充
+static int memdl_lazy_register(memdl_lazy_t *lazy) {
+    pthread_mutex_lock(&memdl_lazy_lock);
+    int ok = memdl_uffd_start() == 0;
+    if (ok) {
+        struct uffdio_register reg = {.range = {lazy->lo, lazy->hi - lazy->lo}, .mode = UFFDIO_REGISTER_MODE_MISSING};
+        ok = ioctl(memdl_uffd, UFFDIO_REGISTER, &reg) == 0;
+    }
+    if (ok) {
+        lazy->next = memdl_lazy_list;
+        memdl_lazy_list = lazy;
+    }
+    pthread_mutex_unlock(&memdl_lazy_lock);
+    return ok ? 0 : -1;
+}
+
+// 原生加载器段映射的按需调页状态；登记失败时返回 NULL，由调用者立即复制段内容
+static memdl_lazy_t *memdl_lazy_segments(const uintptr_t lo, const uintptr_t hi, const uintptr_t bias,
+                                         const unsigned char *data, const Elf64_Phdr *ph, const int phnum) {
+    memdl_lazy_t *lazy = calloc(1, sizeof(memdl_lazy_t));
+    if (!lazy || !(lazy->segs = calloc((size_t) phnum, sizeof(memdl_lazy_seg_t)))) {
+        free(lazy);
+        return NULL;
+    }
+    for (int i = 0; i < phnum; i++) {
+        if (ph[i].p_type == PT_LOAD && ph[i].p_filesz > 0) {
+            lazy->segs[lazy->seg_count++] = (memdl_lazy_seg_t) {bias + ph[i].p_vaddr, ph[i].p_filesz,
+                                                                data + ph[i].p_offset};
+        }
+    }
+    lazy->lo = lo;
+    lazy->hi = hi;
+    if (memdl_lazy_register(lazy) != 0) {
+        memdl_lazy_free(lazy);
+        return NULL;
+    }
+    return lazy;
+}
+
+// 为块独立的 LZ4 帧建立只读的按需解压视图并接管 frame；不适用或 userfaultfd 不可用时返回 NULL，frame 仍归调用者
+static memdl_lazy_t *memdl_lazy_view(memdl_lz4_frame_t *frame) {
+    if (!frame->independent || frame->count == 0) {
+        return NULL;
+    }
+    memdl_lazy_t *view = calloc(1, sizeof(memdl_lazy_t));
+    if (!view) {
+        return NULL;
+    }
+
+    // 镜像大小取内容大小字段，没有时解码最后一块
+    const size_t full = (frame->count - 1) * frame->block_max;
+    size_t size = frame->content_size;
+    if (!frame->has_content_size) {
+        view->frame = *frame;
+        const int slot = memdl_lazy_view_block(view, frame->count - 1);
+        view->frame.blocks = NULL;
+        size = slot >= 0 ? full + view->block_len[slot] : 0;
+    }
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    void *map = size > full && size - full <= frame->block_max
+                    ? mmap(NULL, (size + page - 1) & ~(page - 1), PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0)
+                    : MAP_FAILED;
+    if (map == MAP_FAILED) {
+        memdl_lazy_free(view);
+        return NULL;
+    }
+    view->lo = (uintptr_t) map;
+    view->hi = view->lo + ((size + page - 1) & ~(page - 1));
+    view->view_size = size;
+    view->frame = *frame;
+    if (memdl_lazy_register(view) != 0) {
+        view->frame.blocks = NULL;
+        munmap(map, view->hi - view->lo);
+        memdl_lazy_free(view);
+        return NULL;
+    }
+    return view;
+}
+#else
+static memdl_lazy_t *memdl_lazy_segments(const uintptr_t lo, const uintptr_t hi, const uintptr_t bias,
+                                         const unsigned char *data, const Elf64_Phdr *ph, const int phnum) {
+    (void) lo; (void) hi; (void) bias; (void) data; (void) ph; (void) phnum;
+    return NULL;
+}
+
+static memdl_lazy_t *memdl_lazy_view(memdl_lz4_frame_t *frame) {
+    (void) frame;
+    return NULL;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// 原生 ELF64 加载器：直接从缓冲区映射段、重定位并执行初始化，不经过 memfd/proc/dlopen
+// ---------------------------------------------------------------------------
+
+#if defined(__x86_64__)
+#define MEMDL_NATIVE_MACHINE EM_X86_64
+#define MEMDL_R_NONE      R_X86_64_NONE
+#define MEMDL_R_ABS64     R_X86_64_64
+#define MEMDL_R_GLOB_DAT  R_X86_64_GLOB_DAT
+#define MEMDL_R_JUMP_SLOT R_X86_64_JUMP_SLOT
+#define MEMDL_R_RELATIVE  R_X86_64_RELATIVE
+#define MEMDL_R_IRELATIVE R_X86_64_IRELATIVE
+#elif defined(__aarch64__)
+#define MEMDL_NATIVE_MACHINE EM_AARCH64
+#define MEMDL_R_NONE      R_AARCH64_NONE
+#define MEMDL_R_ABS64     R_AARCH64_ABS64
+#define MEMDL_R_GLOB_DAT  R_AARCH64_GLOB_DAT
+#define MEMDL_R_JUMP_SLOT R_AARCH64_JUMP_SLOT
+#define MEMDL_R_RELATIVE  R_AARCH64_RELATIVE
+#define MEMDL_R_IRELATIVE R_AARCH64_IRELATIVE
+#include <sys/auxv.h>
+
+// glibc 的 __ifunc_arg_t：AArch64 的 IFUNC 解析函数收到 hwcap | _IFUNC_ARG_HWCAP 与指向它的指针
+typedef struct {
+    unsigned long size;
+    unsigned long hwcap;
+    unsigned long hwcap2;
+} memdl_ifunc_arg_t;
+
+#define MEMDL_IFUNC_ARG_HWCAP (1ULL << 62)
+#endif
+
+#ifndef DT_RELR
+#define DT_RELR   36
+#define DT_RELRSZ 35
+#endif
+
+typedef void (*memdl_init_fn)(int, char **, char **);
+typedef void (*memdl_fini_fn)(void);
+
+typedef struct memdl_native {
+    unsigned char *map;         // 预留的整段映射
+    size_t map_size;
+    uintptr_t bias;             // 加载偏移：运行地址 = bias + p_vaddr
+    uintptr_t lo;               // 段覆盖的地址范围 [lo, hi)
+    uintptr_t hi;
+    const Elf64_Sym *symtab;
+    const char *strtab;
+    size_t strsz;
+    const uint32_t *sysv_hash;  // DT_HASH
+    const uint32_t *gnu_hash;   // DT_GNU_HASH
+    size_t nsyms;               // 由哈希表推算的 .dynsym 符号数，加载时已校验各表在映射内
+    const Elf64_Half *versym;   // DT_VERSYM
+    void **needed;              // DT_NEEDED 依赖的 dlopen 句柄
+    size_t needed_count;
+    memdl_lib_t *const *deps;   // 从注册表加载的依赖，仅在链接期间使用
+    const char *const *dep_names;
+    size_t dep_count;
+    memdl_fini_fn *fini_array;
+    size_t fini_count;
+    memdl_fini_fn fini;
+    int initialized;
+    memdl_lazy_t *lazy;         // 按需调页的段映射（MEMDL_ONDEMAND）
+    memdl_lazy_t *view;         // 压缩镜像的按需解压视图，随句柄释放
+} memdl_native_t;
+
+extern char **environ;
+
+static int memdl_native_contains(const memdl_native_t *n, const uintptr_t addr, const size_t len) {
+    return memdl_span_contains(n->lo, n->hi, addr, len);
+}
+
+static int memdl_elf_prot(const Elf64_Word p_flags) {
+    int prot = 0;
+    if (p_flags & PF_R) prot |= PROT_READ;
+    if (p_flags & PF_W) prot |= PROT_WRITE;
+    if (p_flags & PF_X) prot |= PROT_EXEC;
+    return prot;
+}
+
+// 是否为可供外部查找的已定义导出符号
+static int memdl_sym_exported(const Elf64_Sym *sym) {
+    const int bind = ELF64_ST_BIND(sym->st_info);
+    const int vis = ELF64_ST_VISIBILITY(sym->st_other);
+    return sym->st_shndx != SHN_UNDEF &&
+           (bind == STB_GLOBAL || bind == STB_WEAK || bind == STB_GNU_UNIQUE) &&
+           (vis == STV_DEFAULT || vis == STV_PROTECTED);
+}
+
+// 在镜像自身的 .dynsym 中按哈希表查找导出符号
+static const Elf64_Sym *memdl_native_lookup(const memdl_native_t *n, const char *name) {
+    if (n->gnu_hash) {
+        const uint32_t nbuckets = n->gnu_hash[0];
+        const uint32_t symoffset = n->gnu_hash[1];
+        const uint32_t bloom_size = n->gnu_hash[2];
+        const uint32_t bloom_shift = n->gnu_hash[3];
+        const uint64_t *bloom = (const uint64_t *) (n->gnu_hash + 4);
+        const uint32_t *buckets = (const uint32_t *) (bloom + bloom_size);
+        const uint32_t *chain = buckets + nbuckets;
+        const uint32_t h = memdl_gnu_hash(name);
+
+        const uint64_t word = bloom[(h / 64) % bloom_size];
+        const uint64_t mask = ((uint64_t) 1 << (h % 64)) | ((uint64_t) 1 << ((h >> bloom_shift) % 64));
+        if ((word & mask) != mask) {
+            return NULL;
+        }
+        uint32_t idx = buckets[h % nbuckets];
+        if (idx < symoffset) {
+            return NULL;
+        }
+        for (; idx < n->nsyms; idx++) {
+            const uint32_t h2 = chain[idx - symoffset];
+            const Elf64_Sym *sym = &n->symtab[idx];
+            if ((h | 1) == (h2 | 1) && sym->st_name < n->strsz &&
+                strcmp(n->strtab + sym->st_name, name) == 0 && memdl_sym_exported(sym)) {
+                return sym;
+            }
+            if (h2 & 1) break;
+        }
+        return NULL;
+    }
+
+    if (n->sysv_hash) {
+        const uint32_t nbucket = n->sysv_hash[0];
+        const uint32_t *bucket = n->sysv_hash + 2;
+        const uint32_t *chain = bucket + nbucket;
+        // 链长不超过符号数，防止损坏的镜像形成环
+        uint32_t idx = bucket[memdl_sysv_hash(name) % nbucket];
+        for (size_t steps = 0; idx != STN_UNDEF && idx < n->nsyms && steps < n->nsyms; idx = chain[idx], steps++) {
+            const Elf64_Sym *sym = &n->symtab[idx];
+            if (sym->st_name < n->strsz && strcmp(n->strtab + sym->st_name, name) == 0 &&
+                memdl_sym_exported(sym)) {
+                return sym;
+            }
+        }
+    }
+    return NULL;
+}
+
+// 按 glibc 的平台约定调用 IFUNC 解析函数：x86-64 无参数（CPU 特性由解析函数自行查询），AArch64 传入 hwcap
+static uintptr_t memdl_native_ifunc(const uintptr_t resolver) {
+#if defined(__aarch64__)
+    const memdl_ifunc_arg_t arg = {sizeof(memdl_ifunc_arg_t), getauxval(AT_HWCAP), getauxval(AT_HWCAP2)};
+    return ((uintptr_t (*)(uint64_t, const memdl_ifunc_arg_t *)) resolver)(arg.hwcap | MEMDL_IFUNC_ARG_HWCAP, &arg);
+#else
+    return ((uintptr_t (*)(void)) resolver)();
+#endif
+}
+
+static uintptr_t memdl_native_sym_value(const memdl_native_t *n, const Elf64_Sym *sym) {
+    const uintptr_t addr = n->bias + sym->st_value;
+    if (ELF64_ST_TYPE(sym->st_info) == STT_GNU_IFUNC) {
+        return memdl_native_ifunc(addr);
+    }
+    return addr;
+}
+
+// 在已加载句柄中查找符号，不设置错误
+static void *memdl_lib_find(const memdl_lib_t *lib, const char *name) {
+    if (lib->index) {
+        void *addr = memdl_symindex_find(lib->index, name);
+        if (addr) return addr;
+    }
+    if (lib->native) {
+        const Elf64_Sym *sym = memdl_native_lookup(lib->native, name);
+        return sym && ELF64_ST_TYPE(sym->st_info) != STT_TLS ? (void *) memdl_native_sym_value(lib->native, sym) : NULL;
+    }
+    return dlsym(lib->dl, name);
+}
+
+// 解析重定位引用的符号：镜像自身定义的符号直接绑定，未定义的依次在依赖和全局作用域中查找
+static int memdl_native_resolve(const memdl_native_t *n, const uint32_t index, uintptr_t *value) {
+    const Elf64_Sym *sym = &n->symtab[index];
+    if (ELF64_ST_TYPE(sym->st_info) == STT_TLS) {
+        memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "TLS symbols are not supported by the native loader");
+        return -1;
+    }
+    if (sym->st_shndx != SHN_UNDEF) {
+        *value = memdl_native_sym_value(n, sym);
+        return 0;
+    }
+
+    const char *name = sym->st_name < n->strsz ? n->strtab + sym->st_name : "";
+    void *addr = NULL;
+    for (size_t i = 0; i < n->dep_count && !addr; i++) {
+        addr = memdl_lib_find(n->deps[i], name);
+    }
+    for (size_t i = 0; i < n->needed_count && !addr; i++) {
+        addr = dlsym(n->needed[i], name);
+    }
+    if (!addr) {
+        addr = dlsym(RTLD_DEFAULT, name);
+    }
+    if (!addr && ELF64_ST_BIND(sym->st_info) != STB_WEAK) {
+        memdl_set_error_code(MEMDL_ERR_SYMBOL, 0, "Undefined symbol: %s", name);
+        return -1;
+    }
+    *value = (uintptr_t) addr;
+    return 0;
+}
+
+static int memdl_native_relocate(const memdl_native_t *n, const Elf64_Rela *rela, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t type = ELF64_R_TYPE(rela[i].r_info);
+        const uint32_t index = ELF64_R_SYM(rela[i].r_info);
+        const uintptr_t where = n->bias + rela[i].r_offset;
+        if (type == MEMDL_R_NONE) {
+            continue;
+        }
+        if (!memdl_native_contains(n, where, sizeof(uint64_t))) {
+            memdl_set_error_code(MEMDL_ERR_FORMAT, 0, "Relocation offset out of range");
+            return -1;
+        }
+
+        uintptr_t value;
+        switch (type) {
+            case MEMDL_R_RELATIVE:
+                value = n->bias + rela[i].r_addend;
+                break;
+            case MEMDL_R_IRELATIVE:
+                value = memdl_native_ifunc(n->bias + rela[i].r_addend);
+                break;
+            case MEMDL_R_ABS64:
+            case MEMDL_R_GLOB_DAT:
+            case MEMDL_R_JUMP_SLOT:
+                if (memdl_native_resolve(n, index, &value) != 0) {
+                    return -1;
+                }
+                value += rela[i].r_addend;
+                break;
+            default:
+                memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Unsupported relocation type: %u", type);
+                return -1;
+        }
+        memcpy((void *) where, &value, sizeof(value));
+    }
+    return 0;
+}
+
+// DT_RELR 紧凑相对重定位
+static int memdl_native_relocate_relr(const memdl_native_t *n, const uint64_t *relr, const size_t count) {
+    uintptr_t where = 0;
+    for (size_t i = 0; i < count; i++) {
+        const uint64_t entry = relr[i];
+        if ((entry & 1) == 0) {
+            where = n->bias + entry;
+            if (!memdl_native_contains(n, where, sizeof(uint64_t))) {
+                memdl_set_error_code(MEMDL_ERR_FORMAT, 0, "Relocation offset out of range");
+                return -1;
+            }
+            *(uint64_t *) where += n->bias;
+            where += sizeof(uint64_t);
+        } else {
+            uint64_t bits = entry >> 1;
+            for (uintptr_t p = where; bits; bits >>= 1, p += sizeof(uint64_t)) {
+                if (bits & 1) {
+                    if (!memdl_native_contains(n, p, sizeof(uint64_t))) {
+                        memdl_set_error_code(MEMDL_ERR_FORMAT, 0, "Relocation offset out of range");
+                        return -1;
+                    }
+                    *(uint64_t *) p += n->bias;
+                }
+            }
+            where += 63 * sizeof(uint64_t);
+        }
+    }
+    return 0;
+}
+
+static void memdl_native_unload(memdl_native_t *n) {
+    if (n->initialized) {
+        for (size_t i = n->fini_count; i > 0; i--) {
+            const memdl_fini_fn fn = n->fini_array[i - 1];
+            if (fn && fn != (memdl_fini_fn) -1) fn();
+        }
+        if (n->fini) n->fini();
+    }
+    // 析构函数可能仍会触发缺页，之后才注销
+    if (n->lazy) {
+        memdl_lazy_unregister(n->lazy);
+    }
+    if (n->map) {
+        munmap(n->map, n->map_size);
+    }
+    memdl_lazy_free(n->lazy);
+    memdl_lazy_view_close(n->view);
+    for (size_t i = 0; i < n->needed_count; i++) {
+        dlclose(n->needed[i]);
+    }
+    free(n->needed);
+    free(n);
+}
+
+// deps/dep_names 为已从注册表加载的依赖，对应的 DT_NEEDED 不再经过 dlopen；
+// ondemand 时段内容在首次访问时才复制，img->data 在卸载前必须保持有效
+static memdl_native_t *memdl_native_load(const memdl_image_t *img, const int dl_flags,
+                                         memdl_lib_t *const *deps, const char *const *dep_names,
+                                         const size_t dep_count, const int ondemand) {
+#ifndef MEMDL_NATIVE_MACHINE
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Native loader is not supported on this architecture");
+    return NULL;
+#else
+    // 程序头与 PT_LOAD 的文件范围已由 memdl_image_parse 校验
+    if (img->format != MEMDL_FORMAT_ELF || img->bits != 64 || img->big_endian) {
+        memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Native loader requires a little-endian ELF64 image");
+        return NULL;
+    }
+    if (img->type != ET_DYN || img->machine != MEMDL_NATIVE_MACHINE) {
+        memdl_set_error_code(MEMDL_ERR_FORMAT, 0, "Image is not a shared object for this machine");
+        return NULL;
+    }
+    const unsigned char *data = img->data;
+    const Elf64_Phdr *ph = (const Elf64_Phdr *) (data + img->phoff);
+    const int phnum = (int) img->phnum;
+
+    // 计算所有 PT_LOAD 段覆盖的地址范围和最大对齐
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    uintptr_t lo = UINTPTR_MAX, hi = 0;
+    size_t align = page;
+    const Elf64_Phdr *dynamic = NULL, *relro = NULL;
+    for (int i = 0; i < phnum; i++) {
+        if (ph[i].p_type == PT_LOAD) {
+            if (ph[i].p_vaddr + ph[i].p_memsz < ph[i].p_vaddr) {
+                memdl_set_error_code(MEMDL_ERR_FORMAT, 0, "PT_LOAD segment out of range");
+                return NULL;
+            }
+            if (ph[i].p_vaddr < lo) lo = ph[i].p_vaddr;
+            if (ph[i].p_vaddr + ph[i].p_memsz > hi) hi = ph[i].p_vaddr + ph[i].p_memsz;
+            if (ph[i].p_align > align && (ph[i].p_align & (ph[i].p_align - 1)) == 0) align = ph[i].p_align;
+        } else if (ph[i].p_type == PT_DYNAMIC) {
+            dynamic = &ph[i];
+        } else if (ph[i].p_type == PT_GNU_RELRO) {
+            relro = &ph[i];
+        } else if (ph[i].p_type == PT_TLS && ph[i].p_memsz > 0) {
+            memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "TLS segments are not supported by the native loader");
+            return NULL;
+        }
+    }
+    if (lo >= hi || !dynamic) {
+        memdl_set_error_code(MEMDL_ERR_FORMAT, 0, "Image has no loadable segments or dynamic section");
+        return NULL;
+    }
+    lo &= ~(uintptr_t) (page - 1);
+    hi = (hi + page - 1) & ~(uintptr_t) (page - 1);
+
+    memdl_native_t *n = calloc(1, sizeof(memdl_native_t));
+    if (!n) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return NULL;
+    }
+
+    // 预留对齐后的地址空间，多余部分归还
+    const size_t span = hi - lo;
+    n->map_size = span + align;
+    n->map = mmap(NULL, n->map_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (n->map == MAP_FAILED) {
+        n->map = NULL;
+        memdl_set_sys_error("mmap failed");
+        free(n);
+        return NULL;
+    }
+    const uintptr_t start = ((uintptr_t) n->map + align - 1) & ~(uintptr_t) (align - 1);
+    if (start > (uintptr_t) n->map) {
+        munmap(n->map, start - (uintptr_t) n->map);
+    }
+    if ((uintptr_t) n->map + n->map_size > start + span) {
+        munmap((void *) (start + span), (uintptr_t) n->map + n->map_size - (start + span));
+    }
+    n->map = (unsigned char *) start;
+    n->map_size = span;
+    n->bias = start - lo;
+    n->lo = start;
+    n->hi = start + span;
+
+    // 复制段内容（重定位完成前保持可写）
+    if (mprotect(n->map, span, PROT_READ | PROT_WRITE) != 0) {
+        memdl_set_sys_error("mprotect failed");
+        memdl_native_unload(n);
+        return NULL;
+    }
+    if (ondemand) {
+        n->lazy = memdl_lazy_segments(n->lo, n->hi, n->bias, data, ph, phnum);
+    }
+    if (!n->lazy) {
+        const uint64_t copy_start = memdl_trace_begin();
+        for (int i = 0; i < phnum; i++) {
+            if (ph[i].p_type == PT_LOAD && ph[i].p_filesz > 0) {
+                memcpy((void *) (n->bias + ph[i].p_vaddr), data + ph[i].p_offset, ph[i].p_filesz);
+                memdl_load_note(0, ph[i].p_filesz);
+            }
+        }
+        memdl_trace_end(MEMDL_TRACE_COPY, copy_start);
+    }
+
+    // 解析动态段
+    const Elf64_Dyn *dyn = (const Elf64_Dyn *) (n->bias + dynamic->p_vaddr);
+    if (!memdl_native_contains(n, (uintptr_t) dyn, dynamic->p_memsz)) {
+        memdl_set_error_code(MEMDL_ERR_FORMAT, 0, "Dynamic section out of range");
+        memdl_native_unload(n);
+        return NULL;
+    }
+    const size_t dyn_count = dynamic->p_memsz / sizeof(Elf64_Dyn);
+    uintptr_t rela = 0, jmprel = 0, relr = 0, init_array = 0, fini_array = 0, init = 0, fini = 0;
+    size_t rela_size = 0, jmprel_size = 0, relr_size = 0, init_count = 0;
+    for (size_t i = 0; i < dyn_count && dyn[i].d_tag != DT_NULL; i++) {
+        const uintptr_t ptr = n->bias + dyn[i].d_un.d_ptr;
+        switch (dyn[i].d_tag) {
+            case DT_STRTAB: n->strtab = (const char *) ptr; break;
+            case DT_STRSZ: n->strsz = dyn[i].d_un.d_val; break;
+            case DT_SYMTAB: n->symtab = (const Elf64_Sym *) ptr; break;
+            case DT_HASH: n->sysv_hash = (const uint32_t *) ptr; break;
+            case DT_GNU_HASH: n->gnu_hash = (const uint32_t *) ptr; break;
+            case DT_VERSYM: n->versym = (const Elf64_Half *) ptr; break;
+            case DT_RELA: rela = ptr; break;
+            case DT_RELASZ: rela_size = dyn[i].d_un.d_val; break;
+            case DT_JMPREL: jmprel = ptr; break;
+            case DT_PLTRELSZ: jmprel_size = dyn[i].d_un.d_val; break;
+            case DT_RELR: relr = ptr; break;
+            case DT_RELRSZ: relr_size = dyn[i].d_un.d_val; break;
+            case DT_INIT: init = ptr; break;
+            case DT_FINI: fini = ptr; break;
+            case DT_INIT_ARRAY: init_array = ptr; break;
+            case DT_INIT_ARRAYSZ: init_count = dyn[i].d_un.d_val / sizeof(void *); break;
+            case DT_FINI_ARRAY: fini_array = ptr; break;
+            case DT_FINI_ARRAYSZ: n->fini_count = dyn[i].d_un.d_val / sizeof(void *); break;
+            case DT_REL:
+                memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "DT_REL relocations are not supported by the native loader");
+                memdl_native_unload(n);
+                return NULL;
+            default: break;
+        }
+    }
+    // 查找只信任这里校验过的哈希表与符号数
+    n->nsyms = memdl_dynsym_count(n->sysv_hash, n->gnu_hash, n->lo, n->hi);
+    if (!n->strtab || !n->symtab || !memdl_native_contains(n, (uintptr_t) n->strtab, n->strsz) ||
+        ((n->gnu_hash || n->sysv_hash) && n->nsyms == 0) ||
+        !memdl_native_contains(n, (uintptr_t) n->symtab, n->nsyms * sizeof(Elf64_Sym)) ||
+        (rela && !memdl_native_contains(n, rela, rela_size)) ||
+        (jmprel && !memdl_native_contains(n, jmprel, jmprel_size)) ||
+        (relr && !memdl_native_contains(n, relr, relr_size)) ||
+        (init_array && !memdl_native_contains(n, init_array, init_count * sizeof(void *))) ||
+        (fini_array && !memdl_native_contains(n, fini_array, n->fini_count * sizeof(void *)))) {
+        memdl_set_error_code(MEMDL_ERR_FORMAT, 0, "Malformed dynamic section");
+        memdl_native_unload(n);
+        return NULL;
+    }
+    n->fini_array = (memdl_fini_fn *) fini_array;
+    n->fini = (memdl_fini_fn) fini;
+    n->deps = deps;
+    n->dep_names = dep_names;
+    n->dep_count = dep_count;
+
+    // 加载 DT_NEEDED 依赖（名称已由描述符校验）
+    memdl_stage = MEMDL_STAGE_LINK;
+    if (img->needed > 0) {
+        n->needed = calloc(img->needed, sizeof(void *));
+        const char **names = malloc(img->needed * sizeof(char *));
+        if (!n->needed || !names) {
+            free(names);
+            memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+            memdl_native_unload(n);
+            return NULL;
+        }
+        memdl_image_dyn_strings(img, DT_NEEDED, names, img->needed);
+        for (size_t i = 0; i < img->needed; i++) {
+            const char *name = names[i];
+            size_t k = 0;
+            while (k < dep_count && strcmp(dep_names[k], name) != 0) k++;
+            if (k < dep_count) continue;
+            void *dep = dlopen(name, dl_flags);
+            if (!dep) {
+                memdl_set_error_code(MEMDL_ERR_LOADER, 0, "Failed to load dependency %s: %s", name, dlerror());
+                free(names);
+                memdl_native_unload(n);
+                return NULL;
+            }
+            n->needed[n->needed_count++] = dep;
+        }
+        free(names);
+    }
+
+    // 应用重定位
+    if ((relr && memdl_native_relocate_relr(n, (const uint64_t *) relr, relr_size / sizeof(uint64_t)) != 0) ||
+        (rela && memdl_native_relocate(n, (const Elf64_Rela *) rela, rela_size / sizeof(Elf64_Rela)) != 0) ||
+        (jmprel && memdl_native_relocate(n, (const Elf64_Rela *) jmprel, jmprel_size / sizeof(Elf64_Rela)) != 0)) {
+        memdl_native_unload(n);
+        return NULL;
+    }
+
+    // 设置最终的段权限；相邻段共享的边界页取权限并集
+    for (int i = 0; i < phnum; i++) {
+        if (ph[i].p_type != PT_LOAD) continue;
+        const uintptr_t seg_lo = (n->bias + ph[i].p_vaddr) & ~(uintptr_t) (page - 1);
+        const uintptr_t seg_hi = (n->bias + ph[i].p_vaddr + ph[i].p_memsz + page - 1) & ~(uintptr_t) (page - 1);
+        mprotect((void *) seg_lo, seg_hi - seg_lo, memdl_elf_prot(ph[i].p_flags));
+    }
+    for (int i = 0; i < phnum; i++) {
+        if (ph[i].p_type != PT_LOAD) continue;
+        for (int j = i + 1; j < phnum; j++) {
+            if (ph[j].p_type != PT_LOAD) continue;
+            const uintptr_t a_lo = (n->bias + ph[i].p_vaddr) & ~(uintptr_t) (page - 1);
+            const uintptr_t a_hi = (n->bias + ph[i].p_vaddr + ph[i].p_memsz + page - 1) & ~(uintptr_t) (page - 1);
+            const uintptr_t b_lo = (n->bias + ph[j].p_vaddr) & ~(uintptr_t) (page - 1);
+            const uintptr_t b_hi = (n->bias + ph[j].p_vaddr + ph[j].p_memsz + page - 1) & ~(uintptr_t) (page - 1);
+            const uintptr_t shared_lo = a_lo > b_lo ? a_lo : b_lo;
+            const uintptr_t shared_hi = a_hi < b_hi ? a_hi : b_hi;
+            if (shared_lo < shared_hi) {
+                mprotect((void *) shared_lo, shared_hi - shared_lo,
+                         memdl_elf_prot(ph[i].p_flags) | memdl_elf_prot(ph[j].p_flags));
+            }
+        }
+    }
+    if (relro) {
+        const uintptr_t relro_lo = (n->bias + relro->p_vaddr) & ~(uintptr_t) (page - 1);
+        const uintptr_t relro_hi = (n->bias + relro->p_vaddr + relro->p_memsz) & ~(uintptr_t) (page - 1);
+        if (relro_hi > relro_lo) {
+            mprotect((void *) relro_lo, relro_hi - relro_lo, PROT_READ);
+        }
+    }
+
+    // 执行初始化函数
+    const uint64_t init_start = memdl_trace_begin();
+    n->initialized = 1;
+    if (init) {
+        ((memdl_init_fn) init)(0, NULL, environ);
+    }
+    const memdl_init_fn *inits = (const memdl_init_fn *) init_array;
+    for (size_t i = 0; i < init_count; i++) {
+        if (inits[i] && inits[i] != (memdl_init_fn) -1) inits[i](0, NULL, environ);
+    }
+    memdl_trace_end(MEMDL_TRACE_INIT, init_start);
+    n->deps = NULL;
+    n->dep_names = NULL;
+    n->dep_count = 0;
+    return n;
+#endif
+}
+
+static void *memdl_native_sym(const memdl_native_t *n, const char *symbol) {
+    const Elf64_Sym *sym = memdl_native_lookup(n, symbol);
+    if (!sym) {
+        memdl_set_error_code(MEMDL_ERR_SYMBOL, 0, "Symbol not found: %s", symbol);
+        return NULL;
+    }
+    if (ELF64_ST_TYPE(sym->st_info) == STT_TLS) {
+        memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "TLS symbol not supported: %s", symbol);
+        return NULL;
+    }
+    return (void *) memdl_native_sym_value(n, sym);
+}
+
+int memdl_get_page_info(memdl_handle_t handle, memdl_page_info_t *info) {
+    if (!handle || !info) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    const memdl_native_t *n = ((const memdl_lib_t *) handle)->native;
+    if (!n) {
+        memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Page information is only available for native loads");
+        return -1;
+    }
+    memset(info, 0, sizeof(*info));
+    info->pages = n->map_size / (size_t) sysconf(_SC_PAGESIZE);
+    info->faulted = info->pages;
+    if (n->lazy) {
+        info->faulted = atomic_load_explicit(&n->lazy->faulted, memory_order_relaxed);
+        info->fault_ns = atomic_load_explicit(&n->lazy->fault_ns, memory_order_relaxed);
+    }
+    if (n->view) {
+        info->source_pages = atomic_load_explicit(&n->view->faulted, memory_order_relaxed);
+        info->fault_ns += atomic_load_explicit(&n->view->fault_ns, memory_order_relaxed);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 大页代码段：可执行段中 2MB 对齐的部分复制到透明大页并原地替换，降低 iTLB 缺失
+// ---------------------------------------------------------------------------
+
+#define MEMDL_HUGE_PAGE ((size_t) 2 << 20)
+
+typedef struct {
+    const struct link_map *lm;
+    memdl_lib_t *lib;
+} memdl_phdr_match_t;
+
+static void memdl_lib_add_segment(memdl_lib_t *lib, const uintptr_t addr, const uint64_t memsz, const uint32_t flags) {
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    const uintptr_t lo = addr & ~(uintptr_t) (page - 1);
+    const uintptr_t hi = (addr + (uintptr_t) memsz + page - 1) & ~(uintptr_t) (page - 1);
+    memdl_segment_t *seg = &lib->segments[lib->segment_count++];
+    seg->addr = (void *) lo;
+    seg->size = hi - lo;
+    seg->flags = (int) flags;
+}
+
+// dlopen 加载的镜像按 link_map 的加载偏移与名称匹配 dl_iterate_phdr 的条目
+static int memdl_phdr_match(struct dl_phdr_info *dl_info, size_t size, void *ctx) {
+    (void) size;
+    memdl_phdr_match_t *match = ctx;
+    if (dl_info->dlpi_addr != match->lm->l_addr || !dl_info->dlpi_name ||
+        strcmp(dl_info->dlpi_name, match->lm->l_name) != 0) {
+        return 0;
+    }
+    memdl_lib_t *lib = match->lib;
+    lib->segments = calloc(dl_info->dlpi_phnum, sizeof(memdl_segment_t));
+    for (size_t i = 0; lib->segments && i < dl_info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *ph = &dl_info->dlpi_phdr[i];
+        if (ph->p_type == PT_LOAD && ph->p_memsz > 0) {
+            memdl_lib_add_segment(lib, dl_info->dlpi_addr + ph->p_vaddr, ph->p_memsz, ph->p_flags);
+        }
+    }
+    return 1;
+}
+
+// 记录句柄的 PT_LOAD 段，失败时句柄没有段信息。原生加载按描述符（程序头已由 memdl_image_parse 校验）
+static void memdl_lib_segments(memdl_lib_t *lib, const memdl_image_t *img) {
+    if (!lib->native) {
+        memdl_phdr_match_t match = {NULL, lib};
+        struct link_map *lm = NULL;
+        if (dlinfo(lib->dl, RTLD_DI_LINKMAP, &lm) == 0 && lm && lm->l_name) {
+            match.lm = lm;
+            dl_iterate_phdr(memdl_phdr_match, &match);
+        }
+        return;
+    }
+    if (!img || img->segments == 0) {
+        return;
+    }
+    lib->segments = calloc(img->segments, sizeof(memdl_segment_t));
+    for (size_t i = 0; lib->segments && i < img->phnum && lib->segment_count < img->segments; i++) {
+        memdl_phdr_t ph;
+        memdl_image_phdr(img, i, &ph);
+        if (ph.type == MEMDL_ELF_PT_LOAD && ph.memsz > 0) {
+            memdl_lib_add_segment(lib, lib->native->bias + (uintptr_t) ph.vaddr, ph.memsz, ph.flags);
+        }
+    }
+}
+
+// 把 2MB 对齐的 [addr, addr + len) 换成内容相同的透明大页匿名映射
+static int memdl_huge_remap(const uintptr_t addr, const size_t len, const int prot) {
+    unsigned char *raw = mmap(NULL, len + MEMDL_HUGE_PAGE, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (raw == MAP_FAILED) {
+        return -1;
+    }
+    const uintptr_t tmp = ((uintptr_t) raw + MEMDL_HUGE_PAGE - 1) & ~(uintptr_t) (MEMDL_HUGE_PAGE - 1);
+    if (tmp > (uintptr_t) raw) {
+        munmap(raw, tmp - (uintptr_t) raw);
+    }
+    if ((uintptr_t) raw + MEMDL_HUGE_PAGE > tmp) {
+        munmap((void *) (tmp + len), (uintptr_t) raw + MEMDL_HUGE_PAGE - tmp);
+    }
+    // THP 被禁用（never）时 madvise 失败，不必复制
+    if (madvise((void *) tmp, len, MADV_HUGEPAGE) != 0) {
+        munmap((void *) tmp, len);
+        return -1;
+    }
+    memcpy((void *) tmp, (const void *) addr, len);
+#ifdef MADV_COLLAPSE
+    // 缺页时没能直接分配到大页（内存碎片等）则同步合并，失败不影响正确性
+    madvise((void *) tmp, len, MADV_COLLAPSE);
+#endif
+    __builtin___clear_cache((char *) tmp, (char *) tmp + len);
+    if (mprotect((void *) tmp, len, prot) != 0 ||
+        mremap((void *) tmp, len, len, MREMAP_MAYMOVE | MREMAP_FIXED, (void *) addr) == MAP_FAILED) {
+        munmap((void *) tmp, len);
+        return -1;
+    }
+    return 0;
+}
+
+// 替换句柄的可执行段，返回换成大页的字节数；按需调页的段仍登记在 userfaultfd 上，不能替换
+static size_t memdl_lib_hugepages(const memdl_lib_t *lib) {
+    if (lib->native && lib->native->lazy) {
+        return 0;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < lib->segment_count; i++) {
+        const memdl_segment_t *seg = &lib->segments[i];
+        // 只读不可取的代码段（execute-only）无法复制
+        if (!(seg->flags & PF_X) || !(seg->flags & PF_R)) continue;
+        const uintptr_t lo = ((uintptr_t) seg->addr + MEMDL_HUGE_PAGE - 1) & ~(uintptr_t) (MEMDL_HUGE_PAGE - 1);
+        const uintptr_t hi = ((uintptr_t) seg->addr + seg->size) & ~(uintptr_t) (MEMDL_HUGE_PAGE - 1);
+        if (lo < hi && memdl_huge_remap(lo, hi - lo, memdl_elf_prot((Elf64_Word) seg->flags)) == 0) {
+            total += hi - lo;
+        }
+    }
+    return total;
+}
+
+size_t memdl_get_segments(memdl_handle_t handle, memdl_segment_t *segments, const size_t max) {
+    if (!handle || (!segments && max > 0)) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return 0;
+    }
+    const memdl_lib_t *lib = handle;
+    const size_t count = lib->segment_count < max ? lib->segment_count : max;
+    if (count == 0) {
+        return lib->segment_count;
+    }
+    memcpy(segments, lib->segments, count * sizeof(memdl_segment_t));
+
+    // 大页字节数按映射区间统计：与段重叠的区间计入其 AnonHugePages/ShmemPmdMapped/FilePmdMapped
+    FILE *smaps = fopen("/proc/self/smaps", "re");
+    if (!smaps) {
+        return lib->segment_count;
+    }
+    char line[512];
+    uintptr_t vma_lo = 0, vma_hi = 0;
+    while (fgets(line, sizeof(line), smaps)) {
+        unsigned long a, b;
+        size_t kb;
+        char field[32];
+        if (sscanf(line, "%lx-%lx ", &a, &b) == 2 && strchr(line, '-') < strchr(line, ' ')) {
+            vma_lo = a;
+            vma_hi = b;
+            continue;
+        }
+        if (sscanf(line, "%31[A-Za-z]: %zu kB", field, &kb) != 2 || kb == 0 ||
+            (strcmp(field, "AnonHugePages") != 0 && strcmp(field, "ShmemPmdMapped") != 0 &&
+             strcmp(field, "FilePmdMapped") != 0)) {
+            continue;
+        }
+        for (size_t i = 0; i < count; i++) {
+            const uintptr_t lo = (uintptr_t) segments[i].addr;
+            const uintptr_t hi = lo + segments[i].size;
+            const uintptr_t overlap_lo = vma_lo > lo ? vma_lo : lo;
+            const uintptr_t overlap_hi = vma_hi < hi ? vma_hi : hi;
+            if (overlap_lo < overlap_hi) {
+                // 每个区间单独截断到它与段的重叠部分，再累加到段上
+                const size_t bytes = kb * 1024;
+                const size_t overlap = overlap_hi - overlap_lo;
+                segments[i].huge_bytes += bytes < overlap ? bytes : overlap;
+            }
+        }
+    }
+    fclose(smaps);
+    return lib->segment_count;
+}
+
+// ---------------------------------------------------------------------------
+// 预取：交出句柄前让各段页面驻留并建好页表，首次调用不再逐页缺页
+// ---------------------------------------------------------------------------
+
+// 逐页读取一个字节，建立页表项（MADV_POPULATE_READ 不可用时的退路）
+static void memdl_touch_pages(const uintptr_t lo, const uintptr_t hi, const size_t page) {
+    for (uintptr_t p = lo; p < hi; p += page) {
+        (void) *(const volatile unsigned char *) p;
+    }
+}
+
+static void memdl_lib_warm(const memdl_lib_t *lib) {
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < lib->segment_count; i++) {
+        const memdl_segment_t *seg = &lib->segments[i];
+        // 只可执行（execute-only）的段无法读取，留给首次调用
+        if (!(seg->flags & PF_R)) continue;
+#ifdef MADV_POPULATE_READ
+        // 内核早于 5.14 时返回 EINVAL，退回预读加逐页读取；其他错误（如页面无法填充）不再逐页读取
+        if (madvise(seg->addr, seg->size, MADV_POPULATE_READ) == 0 || errno != EINVAL) continue;
+#endif
+        madvise(seg->addr, seg->size, MADV_WILLNEED);
+        memdl_touch_pages((uintptr_t) seg->addr, (uintptr_t) seg->addr + seg->size, page);
+    }
+}
+
+int memdl_warm(memdl_handle_t handle) {
+    if (!handle) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    const memdl_lib_t *lib = handle;
+    if (lib->segment_count == 0) {
+        memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Segment information is not available for this handle");
+        return -1;
+    }
+    memdl_lib_warm(lib);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// perf 符号表：实际加载的镜像把函数符号写入 /tmp/perf-<pid>.map（perf 对 JIT 代码的约定格式），
+// 关闭句柄时从文件中删去自己写入的那一段，其他写入者（例如同进程的 JIT）的条目保持不变
+// ---------------------------------------------------------------------------
+
+#define MEMDL_ELF_SHT_SYMTAB 2
+#define MEMDL_ELF_SHT_DYNSYM 11
+#define MEMDL_ELF_STT_FUNC   2
+
+typedef struct memdl_perf_entry {
+    const memdl_lib_t *lib;
+    char *text;                 // 追加到文件的整段内容
+    size_t len;
+    struct memdl_perf_entry *next;
+} memdl_perf_entry_t;
+
+static pthread_mutex_t memdl_perf_lock = PTHREAD_MUTEX_INITIALIZER;
+static memdl_perf_entry_t *memdl_perf_entries = NULL;
+static atomic_int memdl_perf_enabled = 0;
+static atomic_size_t memdl_perf_count = 0;
+
+void memdl_set_perf_map(const int enabled) {
+    atomic_store(&memdl_perf_enabled, enabled != 0);
+}
+
+// 按节头表把 view 的符号表和字符串表换成 type 类型的节（.symtab 含局部符号），返回符号数；没有时返回 0
+static uint64_t memdl_image_section_symtab(memdl_image_t *view, const uint64_t type) {
+    const int wide = view->bits == 64;
+    const size_t word = wide ? 8 : 4;
+    uint64_t shoff, shentsize, shnum;
+    if (memdl_image_get(view, wide ? 0x28 : 0x20, word, &shoff) != 0 ||
+        memdl_image_get(view, wide ? 0x3a : 0x2e, 2, &shentsize) != 0 ||
+        memdl_image_get(view, wide ? 0x3c : 0x30, 2, &shnum) != 0 || shoff == 0 || shentsize < (wide ? 64 : 40)) {
+        return 0;
+    }
+    for (uint64_t i = 0; i < shnum; i++) {
+        const uint64_t sh = shoff + i * shentsize;
+        uint64_t sh_type, off, size, link, entsize, str_off, str_size;
+        if (memdl_image_get(view, sh + 4, 4, &sh_type) != 0) {
+            return 0;
+        }
+        if (sh_type != type) continue;
+        if (memdl_image_get(view, sh + (wide ? 0x18 : 0x10), word, &off) != 0 ||
+            memdl_image_get(view, sh + (wide ? 0x20 : 0x14), word, &size) != 0 ||
+            memdl_image_get(view, sh + (wide ? 0x28 : 0x18), 4, &link) != 0 ||
+            memdl_image_get(view, sh + (wide ? 0x38 : 0x24), word, &entsize) != 0 || link >= shnum || entsize == 0) {
+            return 0;
+        }
+        const uint64_t str = shoff + link * shentsize;
+        if (memdl_image_get(view, str + (wide ? 0x18 : 0x10), word, &str_off) != 0 ||
+            memdl_image_get(view, str + (wide ? 0x20 : 0x14), word, &str_size) != 0 ||
+            off > view->size || size > view->size - off || str_off > view->size || str_size > view->size - str_off) {
+            return 0;
+        }
+        view->symtab_off = (size_t) off;
+        view->syment = (size_t) entsize;
+        view->strtab_off = (size_t) str_off;
+        view->strsz = (size_t) str_size;
+        return size / entsize;
+    }
+    return 0;
+}
+
+// 把镜像中有大小的函数符号格式化为 perf map 行；优先 .symtab，剥离过的镜像退回 .dynsym
+static char *memdl_perf_format(const memdl_image_t *img, const uintptr_t base, size_t *len) {
+    memdl_image_t view = *img;
+    uint64_t count = memdl_image_section_symtab(&view, MEMDL_ELF_SHT_SYMTAB);
+    if (!count) {
+        view = *img;
+        count = memdl_image_section_symtab(&view, MEMDL_ELF_SHT_DYNSYM);
+    }
+    if (!count) {
+        view = *img;
+        count = memdl_image_symcount(&view);
+    }
+    size_t cap = 4096;
+    char *text = malloc(cap);
+    *len = 0;
+    for (uint64_t i = 1; text && i < count; i++) {
+        memdl_elf_sym_t sym;
+        if (memdl_image_sym(&view, i, &sym) != 0) break;
+        if ((sym.info & 0xf) != MEMDL_ELF_STT_FUNC || sym.shndx == 0 || sym.size == 0 || sym.name == 0 ||
+            !memdl_image_string_ok(&view, sym.name)) {
+            continue;
+        }
+        const char *name = (const char *) view.data + view.strtab_off + sym.name;
+        const size_t need = strlen(name) + 2 * 17 + 3;
+        if (cap - *len < need) {
+            cap = cap * 2 + need;
+            char *grown = realloc(text, cap);
+            if (!grown) {
+                free(text);
+                return NULL;
+            }
+            text = grown;
+        }
+        *len += (size_t) snprintf(text + *len, cap - *len, "%lx %lx %s\n", (unsigned long) (base + sym.value),
+                                  (unsigned long) sym.size, name);
+    }
+    return text;
+}
+
+static void memdl_perf_path(char *path, const size_t size, const char *suffix) {
+    snprintf(path, size, "/tmp/perf-%d.map%s", (int) getpid(), suffix);
+}
+
+// 登记实际加载的镜像；img 为 NULL（从描述符加载）时映射句柄持有的 memfd 读取符号
+static void memdl_perf_add(memdl_lib_t *lib, const memdl_image_t *img) {
+    uintptr_t base = 0;
+    if (lib->native) {
+        base = lib->native->bias;
+    } else {
+        struct link_map *lm = NULL;
+        if (dlinfo(lib->dl, RTLD_DI_LINKMAP, &lm) != 0 || !lm) return;
+        base = lm->l_addr;
+    }
+    memdl_image_t mapped;
+    void *map = NULL;
+    size_t map_size = 0;
+    if (!img && lib->fd >= 0) {
+        struct stat st;
+        if (fstat(lib->fd, &st) == 0 && st.st_size > 0) {
+            map_size = (size_t) st.st_size;
+            map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, lib->fd, 0);
+        }
+        if (map == MAP_FAILED) map = NULL;
+        if (map && memdl_image_parse(&mapped, map, map_size) == 0) img = &mapped;
+    }
+    size_t len = 0;
+    char *text = img ? memdl_perf_format(img, base, &len) : NULL;
+    if (map) munmap(map, map_size);
+    memdl_perf_entry_t *entry = text && len ? calloc(1, sizeof(memdl_perf_entry_t)) : NULL;
+    if (!entry) {
+        free(text);
+        return;
+    }
+    entry->lib = lib;
+    entry->text = text;
+    entry->len = len;
+
+    char path[64];
+    memdl_perf_path(path, sizeof(path), "");
+    pthread_mutex_lock(&memdl_perf_lock);
+    // O_APPEND 的单次写入在普通文件上是原子的，与其他写入者交错时整段仍然连续
+    const int out = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (out >= 0 && memdl_write_all(out, text, len) == 0) {
+        entry->next = memdl_perf_entries;
+        memdl_perf_entries = entry;
+        atomic_fetch_add(&memdl_perf_count, 1);
+        entry = NULL;
+    }
+    if (out >= 0) close(out);
+    pthread_mutex_unlock(&memdl_perf_lock);
+    if (entry) {
+        free(entry->text);
+        free(entry);
+    }
+}
+
+// 从文件中删去句柄写入的段落：写临时文件后 rename 替换，读者不会看到写了一半的文件
+static void memdl_perf_remove(const memdl_lib_t *lib) {
+    if (atomic_load_explicit(&memdl_perf_count, memory_order_acquire) == 0) {
+        return;
+    }
+    pthread_mutex_lock(&memdl_perf_lock);
+    memdl_perf_entry_t **pp = &memdl_perf_entries;
+    while (*pp && (*pp)->lib != lib) pp = &(*pp)->next;
+    memdl_perf_entry_t *entry = *pp;
+    if (!entry) {
+        pthread_mutex_unlock(&memdl_perf_lock);
+        return;
+    }
+    *pp = entry->next;
+    atomic_fetch_sub(&memdl_perf_count, 1);
+
+    char path[64], tmp[64];
+    memdl_perf_path(path, sizeof(path), "");
+    memdl_perf_path(tmp, sizeof(tmp), ".tmp");
+    const int in = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    char *data = NULL;
+    size_t size = 0;
+    if (in >= 0 && fstat(in, &st) == 0 && (data = malloc((size_t) st.st_size + 1)) != NULL) {
+        ssize_t n;
+        while (size < (size_t) st.st_size && (n = read(in, data + size, (size_t) st.st_size - size)) > 0) {
+            size += (size_t) n;
+        }
+    }
+    if (in >= 0) close(in);
+    char *found = data ? memmem(data, size, entry->text, entry->len) : NULL;
+    if (found) {
+        memmove(found, found + entry->len, size - (size_t) (found - data) - entry->len);
+        size -= entry->len;
+        const int out = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        const int ok = out >= 0 && memdl_write_all(out, data, size) == 0;
+        if (out >= 0) close(out);
+        if (!ok || rename(tmp, path) != 0) unlink(tmp);
+    }
+    pthread_mutex_unlock(&memdl_perf_lock);
+    free(data);
+    free(entry->text);
+    free(entry);
+}
+
+static void memdl_lib_place(memdl_lib_t *lib, const memdl_image_t *img, const int flags) {
+    memdl_lib_segments(lib, img);
+    if (flags & MEMDL_HUGEPAGES) {
+        memdl_lib_hugepages(lib);
+    }
+    if (flags & MEMDL_PREFAULT) {
+        memdl_lib_warm(lib);
+    }
+    if (atomic_load_explicit(&memdl_perf_enabled, memory_order_relaxed)) {
+        memdl_perf_add(lib, img);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 内存依赖注册表：DT_NEEDED 按名称从已注册的内存镜像中满足，不访问文件系统
+// ---------------------------------------------------------------------------
+
+typedef struct memdl_module {
+    char *name;
+    memdl_image_t image;        // 注册时解析一次，依赖图遍历直接复用
+    struct memdl_module *next;
+} memdl_module_t;
+
+static pthread_mutex_t memdl_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static memdl_module_t *memdl_registry = NULL;
+static atomic_size_t memdl_registry_count = 0;
+
+int memdl_register(const char *name, const void *so_data, const size_t so_size) {
+    if (!name || !*name) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid module name");
+        return -1;
+    }
+    memdl_stage = MEMDL_STAGE_VALIDATE;
+    memdl_image_t image;
+    if (memdl_image_parse(&image, so_data, so_size) != 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&memdl_registry_lock);
+    memdl_module_t *mod = memdl_registry;
+    while (mod && strcmp(mod->name, name) != 0) mod = mod->next;
+    if (!mod) {
+        mod = calloc(1, sizeof(memdl_module_t));
+        char *copy = strdup(name);
+        if (!mod || !copy) {
+            pthread_mutex_unlock(&memdl_registry_lock);
+            free(mod);
+            free(copy);
+            memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+            return -1;
+        }
+        mod->name = copy;
+        mod->next = memdl_registry;
+        memdl_registry = mod;
+        atomic_fetch_add_explicit(&memdl_registry_count, 1, memory_order_release);
+    }
+    mod->image = image;
+    pthread_mutex_unlock(&memdl_registry_lock);
+    return 0;
+}
+
+int memdl_unregister(const char *name) {
+    if (!name) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid module name");
+        return -1;
+    }
+    pthread_mutex_lock(&memdl_registry_lock);
+    memdl_module_t **pp = &memdl_registry;
+    while (*pp && strcmp((*pp)->name, name) != 0) pp = &(*pp)->next;
+    memdl_module_t *mod = *pp;
+    if (mod) {
+        *pp = mod->next;
+        atomic_fetch_sub_explicit(&memdl_registry_count, 1, memory_order_release);
+    }
+    pthread_mutex_unlock(&memdl_registry_lock);
+    if (!mod) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Module not registered: %s", name);
+        return -1;
+    }
+    free(mod->name);
+    free(mod);
+    return 0;
+}
+
+static int memdl_registry_find(const char *name, memdl_image_t *out) {
+    pthread_mutex_lock(&memdl_registry_lock);
+    const memdl_module_t *mod = memdl_registry;
+    while (mod && strcmp(mod->name, name) != 0) mod = mod->next;
+    if (mod) {
+        *out = mod->image;
+    }
+    pthread_mutex_unlock(&memdl_registry_lock);
+    return mod != NULL;
+}
+
+// 一次依赖加载批次中已链接的镜像；嵌套加载时链到外层批次
+typedef struct memdl_dep_scope {
+    const char *const *names;
+    const memdl_open_result_t *results;
+    size_t count;
+    const struct memdl_dep_scope *parent;
+} memdl_dep_scope_t;
+
+// 链接阶段总在发起加载的线程上执行，依赖批次通过线程局部变量传给内层的 memdl_lib_link
+static MEMDL_THREAD_LOCAL const memdl_dep_scope_t *memdl_dep_scope = NULL;
+
+static const memdl_open_result_t *memdl_dep_scope_find(const memdl_dep_scope_t *scope, const char *name) {
+    for (; scope; scope = scope->parent) {
+        for (size_t i = 0; i < scope->count; i++) {
+            if (strcmp(scope->names[i], name) == 0) return &scope->results[i];
+        }
+    }
+    return NULL;
+}
+
+typedef struct {
+    const char **names;         // 拓扑序（依赖在前）
+    memdl_source_t *images;
+    int *state;                 // 0 访问中，1 已完成
+    size_t count;
+    size_t capacity;
+    int flags;
+} memdl_dep_graph_t;
+
+// 深度优先收集尚未加载的已注册依赖，后序即为拓扑序
+static int memdl_dep_visit(memdl_dep_graph_t *graph, const char *name) {
+    if (memdl_dep_scope_find(memdl_dep_scope, name)) {
+        return 0;
+    }
+    for (size_t i = 0; i < graph->count; i++) {
+        if (strcmp(graph->names[i], name) != 0) continue;
+        if (graph->state[i] == 0) {
+            memdl_set_error_code(MEMDL_ERR_LOADER, 0, "Dependency cycle through %s", name);
+            return -1;
+        }
+        return 0;
+    }
+    memdl_image_t image;
+    if (!memdl_registry_find(name, &image)) {
+        return 0;   // 未注册的依赖交给系统加载器
+    }
+    if (!(graph->flags & MEMDL_NATIVE)) {
+        // dlopen 按 DT_SONAME 识别已加载的依赖，名称不一致时会去文件系统查找
+        const char *soname = NULL;
+        memdl_image_dyn_strings(&image, DT_SONAME, &soname, 1);
+        if (!soname || strcmp(soname, name) != 0) {
+            memdl_set_error_code(MEMDL_ERR_LOADER, 0, "Registered module %s has DT_SONAME %s", name,
+                                 soname ? soname : "(none)");
+            return -1;
+        }
+    }
+
+    if (graph->count == graph->capacity) {
+        const size_t capacity = graph->capacity ? graph->capacity * 2 : 8;
+        const char **names = realloc(graph->names, capacity * sizeof(*names));
+        if (names) graph->names = names;
+        memdl_source_t *images = realloc(graph->images, capacity * sizeof(*images));
+        if (images) graph->images = images;
+        int *state = realloc(graph->state, capacity * sizeof(*state));
+        if (state) graph->state = state;
+        if (!names || !images || !state) {
+            memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+            return -1;
+        }
+        graph->capacity = capacity;
+    }
+    // 先占位标记为访问中，子依赖完成后再移到末尾，保证依赖排在前面
+    const size_t slot = graph->count++;
+    graph->names[slot] = name;
+    graph->images[slot] = (memdl_source_t) {image.data, image.size};
+    graph->state[slot] = 0;
+
+    const size_t needed = image.needed;
+    const char **names = needed ? malloc(needed * sizeof(char *)) : NULL;
+    if (needed && !names) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return -1;
+    }
+    memdl_image_dyn_strings(&image, DT_NEEDED, names, needed);
+    for (size_t i = 0; i < needed; i++) {
+        if (memdl_dep_visit(graph, names[i]) != 0) {
+            free(names);
+            return -1;
+        }
+    }
+    free(names);
+
+    size_t pos = 0;
+    while (strcmp(graph->names[pos], name) != 0) pos++;
+    for (size_t i = pos; i + 1 < graph->count; i++) {
+        graph->names[i] = graph->names[i + 1];
+        graph->images[i] = graph->images[i + 1];
+        graph->state[i] = graph->state[i + 1];
+    }
+    graph->names[graph->count - 1] = name;
+    graph->images[graph->count - 1] = (memdl_source_t) {image.data, image.size};
+    graph->state[graph->count - 1] = 1;
+    return 0;
+}
+
+static void memdl_lib_release_deps(memdl_lib_t *lib) {
+    // 依赖在依赖方卸载后再释放
+    for (size_t i = lib->dep_count; i > 0; i--) {
+        memdl_close(lib->deps[i - 1]);
+    }
+    free(lib->deps);
+    lib->deps = NULL;
+    lib->dep_count = 0;
+}
+
+// 为镜像加载已注册的 DT_NEEDED 依赖并由 lib 持有引用；*dep_names 与 lib->deps 一一对应，由调用者释放。
+// 整个依赖图按拓扑序交给 memdl_open_many：准备阶段并行，链接阶段依赖先于依赖方
+static int memdl_deps_load(const memdl_image_t *img, const int flags, memdl_lib_t *lib, const char ***dep_names) {
+    *dep_names = NULL;
+    const size_t needed = img->needed;
+    if (needed == 0 || atomic_load_explicit(&memdl_registry_count, memory_order_acquire) == 0) {
+        return 0;
+    }
+    const char **names = malloc(needed * sizeof(char *));
+    if (!names) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return -1;
+    }
+    memdl_image_dyn_strings(img, DT_NEEDED, names, needed);
+
+    memdl_dep_graph_t graph = {.flags = flags};
+    int rc = 0;
+    for (size_t i = 0; i < needed && rc == 0; i++) {
+        rc = memdl_dep_visit(&graph, names[i]);
+    }
+
+    memdl_open_result_t *results = NULL;
+    const memdl_dep_scope_t *outer = memdl_dep_scope;
+    memdl_dep_scope_t scope = {graph.names, NULL, 0, outer};
+    if (rc == 0 && graph.count > 0) {
+        results = calloc(graph.count, sizeof(memdl_open_result_t));
+        if (results) {
+            scope.results = results;
+            scope.count = graph.count;
+            memdl_dep_scope = &scope;
+            // 依赖总是进缓存：同一个库在进程中只应有一个实例，因此也不按需调页
+            memdl_open_many(graph.images, graph.count, flags & ~(MEMDL_NOCACHE | MEMDL_ONDEMAND), results, NULL);
+            memdl_dep_scope = outer;
+        } else {
+            memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+            rc = -1;
+        }
+    }
+
+    // 挑出本镜像直接依赖的已注册模块，各自增加一个引用
+    if (rc == 0) {
+        lib->deps = calloc(needed, sizeof(memdl_lib_t *));
+        if (!lib->deps) {
+            memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+            rc = -1;
+        }
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < needed && rc == 0; i++) {
+        const memdl_open_result_t *dep = memdl_dep_scope_find(&scope, names[i]);
+        if (!dep) continue;
+        if (!dep->handle) {
+            memdl_set_error_code(dep->error.code ? dep->error.code : MEMDL_ERR_LOADER, dep->error.sys_errno,
+                                 "Failed to load dependency %s: %s", names[i], dep->error.message);
+            rc = -1;
+            break;
+        }
+        memdl_lib_t *dep_lib = dep->handle;
+        atomic_fetch_add_explicit(&dep_lib->refcount, 1, memory_order_relaxed);
+        lib->deps[lib->dep_count++] = dep_lib;
+        names[kept++] = names[i];
+    }
+
+    // 释放批次自身的引用，只留下依赖方持有的
+    for (size_t i = 0; i < scope.count; i++) {
+        if (results[i].handle) memdl_close(results[i].handle);
+    }
+    free(results);
+    free(graph.names);
+    free(graph.images);
+    free(graph.state);
+    if (rc != 0) {
+        memdl_lib_release_deps(lib);
+        free(names);
+        return -1;
+    }
+    *dep_names = names;
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 实例模式（MEMDL_INSTANCE）：同一镜像的多个实例经 dlmopen 装入不同的链接命名空间，各有独立的全局状态。
+// 相同内容只填充一次 memfd，所有实例映射同一份页缓存；命名空间由池复用，每个命名空间以常驻的 libc 保活
+// （glibc 在命名空间清空后即回收其编号），一个命名空间内同一镜像最多一个实例
+// ---------------------------------------------------------------------------
+
+#define MEMDL_NS_MAX 15   // glibc DL_NNS 为 16，含基础命名空间
+
+typedef struct memdl_instance_src {
+    uint64_t hash;
+    size_t size;
+    int fd;                     // 已封印的 memfd
+    unsigned refs;              // 使用它的实例数
+    struct memdl_instance_src *next;
+} memdl_instance_src_t;
+
+typedef struct memdl_namespace {
+    Lmid_t id;
+    void *anchor;               // 保活用的 libc 句柄
+    const memdl_instance_src_t *loaded[64];   // 本命名空间中已有实例的镜像
+    size_t loaded_count;
+} memdl_namespace_t;
+
+static pthread_mutex_t memdl_ns_lock = PTHREAD_MUTEX_INITIALIZER;
+static memdl_namespace_t memdl_ns_pool[MEMDL_NS_MAX];
+static size_t memdl_ns_count = 0;
+static memdl_instance_src_t *memdl_instance_srcs = NULL;
+
+static int memdl_namespace_has(const memdl_namespace_t *ns, const memdl_instance_src_t *src) {
+    for (size_t i = 0; i < ns->loaded_count; i++) {
+        if (ns->loaded[i] == src) return 1;
+    }
+    return 0;
+}
+
+// 取得（必要时创建）镜像的共享 memfd；staged 为准备阶段写好的镜像（总会被接管），NULL 表示在此准备。
+// 各实例都经 /proc/self/fd 打开，路径方式落地的临时文件立即删除。调用者持有 memdl_ns_lock
+static memdl_instance_src_t *memdl_instance_src_get(const memdl_image_t *img, const uint64_t hash,
+                                                    memdl_staged_t *staged) {
+    for (memdl_instance_src_t *src = memdl_instance_srcs; src; src = src->next) {
+        // 哈希只用于定位，逐字节比对后才复用，碰撞的镜像不会映射到别人的 memfd
+        if (src->hash == hash && src->size == img->size && memdl_fd_equals(src->fd, img->data, img->size)) {
+            memdl_staged_drop(staged);
+            src->refs++;
+            return src;
+        }
+    }
+    memdl_instance_src_t *src = calloc(1, sizeof(memdl_instance_src_t));
+    if (!src) {
+        memdl_staged_drop(staged);
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return NULL;
+    }
+    memdl_staged_t local;
+    if (!staged || staged->fd < 0) {
+        staged = memdl_prepare_image(img, 0, &local, NULL) == 0 ? &local : NULL;
+    }
+    if (!staged) {
+        free(src);
+        return NULL;
+    }
+    if (staged->path[0]) {
+        unlink(staged->path);
+        staged->path[0] = '\0';
+    }
+    src->fd = staged->fd;
+    staged->fd = -1;
+    src->hash = hash;
+    src->size = img->size;
+    src->refs = 1;
+    src->next = memdl_instance_srcs;
+    memdl_instance_srcs = src;
+    return src;
+}
+
+// 调用者持有 memdl_ns_lock
+static void memdl_instance_src_put(memdl_instance_src_t *src) {
+    if (--src->refs > 0) {
+        return;
+    }
+    memdl_instance_src_t **pp = &memdl_instance_srcs;
+    while (*pp != src) pp = &(*pp)->next;
+    *pp = src->next;
+    close(src->fd);
+    free(src);
+}
+
+// 选出还没有该镜像实例的命名空间并预占；池中没有时新建。调用者持有 memdl_ns_lock
+static memdl_namespace_t *memdl_namespace_reserve(const memdl_instance_src_t *src) {
+    memdl_namespace_t *ns = NULL;
+    for (size_t i = 0; i < memdl_ns_count && !ns; i++) {
+        if (memdl_ns_pool[i].loaded_count < 64 && !memdl_namespace_has(&memdl_ns_pool[i], src)) {
+            ns = &memdl_ns_pool[i];
+        }
+    }
+    if (!ns) {
+        if (memdl_ns_count == MEMDL_NS_MAX) {
+            memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "All %d link namespaces already hold an instance of this image",
+                                 MEMDL_NS_MAX);
+            return NULL;
+        }
+        void *anchor = dlmopen(LM_ID_NEWLM, LIBC_SO, RTLD_NOW | RTLD_LOCAL);
+        Lmid_t id;
+        if (!anchor || dlinfo(anchor, RTLD_DI_LMID, &id) != 0) {
+            memdl_set_error_code(MEMDL_ERR_LOADER, 0, "Failed to create link namespace: %s", dlerror());
+            if (anchor) dlclose(anchor);
+            return NULL;
+        }
+        ns = &memdl_ns_pool[memdl_ns_count++];
+        ns->id = id;
+        ns->anchor = anchor;
+        ns->loaded_count = 0;
+    }
+    ns->loaded[ns->loaded_count++] = src;
+    return ns;
+}
+
+static void memdl_namespace_release(memdl_namespace_t *ns, const memdl_instance_src_t *src) {
+    for (size_t i = 0; i < ns->loaded_count; i++) {
+        if (ns->loaded[i] == src) {
+            ns->loaded[i] = ns->loaded[--ns->loaded_count];
+            return;
+        }
+    }
+}
+
+// 在池中的命名空间里装入一个新实例；DT_NEEDED 在该命名空间内按常规路径查找，不经过内存依赖注册表
+static void *memdl_instance_link(const memdl_image_t *img, uint64_t hash, memdl_staged_t *staged, const int dl_flags,
+                                 memdl_lib_t *lib) {
+    if (!hash) hash = img->hash;
+    if (!hash) {
+        const uint64_t start = memdl_trace_begin();
+        hash = memdl_digest(img->data, img->size);
+        memdl_trace_end(MEMDL_TRACE_HASH, start);
+    }
+    memdl_load_note(MEMDL_STRATEGY_MEMFD, 0);
+    pthread_mutex_lock(&memdl_ns_lock);
+    memdl_instance_src_t *src = memdl_instance_src_get(img, hash, staged);
+    memdl_namespace_t *ns = src ? memdl_namespace_reserve(src) : NULL;
+    if (src && !ns) {
+        memdl_instance_src_put(src);
+    }
+    pthread_mutex_unlock(&memdl_ns_lock);
+    if (!ns) {
+        return NULL;
+    }
+
+    // 构造函数可能再次加载实例，dlmopen 不持有 memdl_ns_lock
+    memdl_stage = MEMDL_STAGE_LINK;
+    char fd_path[64];
+    snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", src->fd);
+    const uint64_t start = memdl_trace_begin();
+    void *dl = dlmopen(ns->id, fd_path, dl_flags & ~RTLD_GLOBAL);
+    memdl_trace_end(MEMDL_TRACE_LINK, start);
+    if (!dl) {
+        memdl_set_dl_error();
+        pthread_mutex_lock(&memdl_ns_lock);
+        memdl_namespace_release(ns, src);
+        memdl_instance_src_put(src);
+        pthread_mutex_unlock(&memdl_ns_lock);
+        return NULL;
+    }
+    lib->ns = ns;
+    lib->src = src;
+    return dl;
+}
+
+static void memdl_instance_unlink(memdl_lib_t *lib) {
+    pthread_mutex_lock(&memdl_ns_lock);
+    memdl_namespace_release(lib->ns, lib->src);
+    memdl_instance_src_put(lib->src);
+    pthread_mutex_unlock(&memdl_ns_lock);
+}
+
+// 按 flags 选择加载引擎完成链接，返回尚未登记缓存的新句柄；staged 为准备阶段的结果（原生加载与实例可为 NULL），
+// 总会被接管
+static memdl_lib_t *memdl_lib_link(const memdl_image_t *img, memdl_staged_t *staged, const int flags,
+                                   const uint64_t hash) {
+    memdl_lib_t *lib = memdl_lib_new(NULL, hash, img->size);
+    if (!lib) {
+        memdl_staged_drop(staged);
+        return NULL;
+    }
+    lib->dl_flags = memdl_dl_flags(flags);
+    memdl_stage = MEMDL_STAGE_LINK;
+    const char **dep_names = NULL;
+    uint64_t start = memdl_trace_begin();
+    const int instance = (flags & MEMDL_INSTANCE) && !(flags & MEMDL_NATIVE);
+    if (!instance && memdl_deps_load(img, flags, lib, &dep_names) != 0) {
+        memdl_staged_drop(staged);
+        free(lib);
+        return NULL;
+    }
+    memdl_trace_end(MEMDL_TRACE_DEPS, start);
+    if (flags & MEMDL_NATIVE) {
+        memdl_staged_drop(staged);
+        memdl_load_note(MEMDL_STRATEGY_NATIVE, 0);
+        // 原生加载器内部单独记录复制和构造函数，链接时间只计映射与重定位
+        const memdl_load_info_t *info = memdl_load_cur;
+        const uint64_t inner = info ? info->stage_ns[MEMDL_TRACE_COPY] + info->stage_ns[MEMDL_TRACE_INIT] : 0;
+        start = memdl_trace_begin();
+        lib->native = memdl_native_load(img, memdl_dl_flags(flags), lib->deps, dep_names, lib->dep_count,
+                                        (flags & MEMDL_ONDEMAND) != 0);
+        if (start) {
+            const uint64_t elapsed = memdl_now_ns() - start;
+            const uint64_t nested = info ? info->stage_ns[MEMDL_TRACE_COPY] + info->stage_ns[MEMDL_TRACE_INIT] - inner : 0;
+            memdl_trace_add(MEMDL_TRACE_LINK, elapsed > nested ? elapsed - nested : 0);
+        }
+    } else if (instance) {
+        lib->dl = memdl_instance_link(img, hash, staged, memdl_dl_flags(flags), lib);
+    } else {
+        lib->dl = memdl_link_image(staged, memdl_dl_flags(flags), &lib->fd);
+    }
+    free(dep_names);
+    if (!lib->dl && !lib->native) {
+        memdl_lib_release_deps(lib);
+        free(lib);
+        return NULL;
+    }
+    start = memdl_trace_begin();
+    if (lib->native) {
+#ifdef MEMDL_NATIVE_MACHINE
+        const memdl_native_t *n = lib->native;
+        lib->index = memdl_symindex_build(n->bias, n->symtab, n->strtab, n->strsz, n->versym, n->nsyms);
+#endif
+    } else {
+        lib->index = memdl_symindex_from_dl(lib->dl);
+    }
+    memdl_trace_end(MEMDL_TRACE_INDEX, start);
+    memdl_lib_place(lib, img, flags);
+    return lib;
+}
+
+static memdl_lib_t *memdl_lib_load(const memdl_image_t *img, const int flags, const uint64_t hash) {
+    if (flags & (MEMDL_NATIVE | MEMDL_INSTANCE)) {
+        return memdl_lib_link(img, NULL, flags, hash);
+    }
+    memdl_staged_t staged;
+    if (memdl_prepare_image(img, flags, &staged, NULL) != 0) {
+        return NULL;
+    }
+    return memdl_lib_link(img, &staged, flags, hash);
+}
+
+// 卸载句柄对应的镜像并释放句柄
+static int memdl_lib_unload(memdl_lib_t *lib) {
+    int result = 0;
+    memdl_perf_remove(lib);
+    if (lib->native) {
+        memdl_native_unload(lib->native);
+    } else {
+        result = dlclose(lib->dl);
+        if (result != 0) {
+            memdl_set_dl_error();
+        }
+        if (lib->ns) {
+            memdl_instance_unlink(lib);
+        }
+    }
+    if (lib->fd >= 0) {
+        close(lib->fd);
+    }
+    memdl_lib_release_deps(lib);
+    free(lib->index);
+    free(lib->segments);
+    free(lib);
+    return result;
+}
+
+// 在缓存中查找镜像并统计命中
+static memdl_lib_t *memdl_cache_lookup(const memdl_image_t *img, const uint64_t hash, const int flags) {
+    pthread_mutex_t *lock = memdl_cache_lock(hash);
+    pthread_mutex_lock(lock);
+    memdl_lib_t *lib = memdl_cache_find(img, hash, flags);
+    pthread_mutex_unlock(lock);
+    atomic_fetch_add_explicit(lib ? &memdl_cache_hits : &memdl_cache_misses, 1, memory_order_relaxed);
+    return lib;
+}
+
+// 登记新加载的句柄；其他线程已抢先登记同一镜像时卸载新句柄并返回已有句柄。
+// 首次加载不加锁串行化：并发打开同一镜像的线程各自完整加载一份，落败的一份随即卸载，
+// 其构造和析构函数因此会多运行一次。同键条目保留了镜像内容时在此比对一次，内容不同（哈希碰撞）则新句柄不进缓存
+static memdl_lib_t *memdl_cache_publish(memdl_lib_t *loaded, const memdl_image_t *img, const int flags) {
+    pthread_mutex_t *lock = memdl_cache_lock(loaded->hash);
+    pthread_mutex_lock(lock);
+    memdl_lib_t *lib = memdl_cache_find(img, loaded->hash, flags);
+    if (!lib) {
+        memdl_cache_insert(loaded);
+    } else if (lib->fd >= 0 && !memdl_fd_equals(lib->fd, img->data, img->size)) {
+        // 已有条目另有引用且只能在桶锁内归零，这里直接退回刚取得的引用
+        atomic_fetch_sub_explicit(&lib->refcount, 1, memory_order_relaxed);
+        lib = NULL;
+    }
+    pthread_mutex_unlock(lock);
+    if (lib) {
+        memdl_lib_unload(loaded);
+        return lib;
+    }
+    return loaded;
+}
+
+static memdl_lib_t *memdl_open_lz4(const void *so_data, size_t so_size, int flags, memdl_load_info_t *info,
+                                   memdl_load_info_t *outer, uint64_t start);
+
+// 按需调页基于原生加载器；句柄引用调用者的源数据，不能进缓存被其他调用者复用
+static int memdl_effective_flags(const int flags) {
+    if (flags & MEMDL_ONDEMAND) {
+        return flags | MEMDL_NATIVE | MEMDL_NOCACHE;
+    }
+    // 每次打开都是新实例，不经过句柄缓存
+    return (flags & MEMDL_INSTANCE) ? flags | MEMDL_NOCACHE : flags;
+}
+
+// 打开已解析的镜像；img 为 NULL 表示解析失败，只结束本次加载记录。
+// img->hash 为 0 时按需计算，memdl_image_prepare 的描述符已带有哈希；
+// staged 为已写好的镜像（总会被接管），NULL 表示在此准备
+static memdl_lib_t *memdl_open_image(memdl_image_t *img, memdl_staged_t *staged, const int open_flags,
+                                     memdl_load_info_t *info, memdl_load_info_t *outer, const uint64_t start) {
+    const int flags = memdl_effective_flags(open_flags);
+    memdl_lib_t *lib = NULL;
+    if (img) {
+        memdl_stage = MEMDL_STAGE_PREPARE;
+        if (!(flags & MEMDL_NOCACHE)) {
+            // 相同内容的镜像直接复用已加载的句柄（不计入加载统计）
+            if (!img->hash) {
+                const uint64_t stage_start = memdl_trace_begin();
+                img->hash = memdl_digest(img->data, img->size);
+                memdl_trace_end(MEMDL_TRACE_HASH, stage_start);
+            }
+            lib = memdl_cache_lookup(img, img->hash, flags);
+            if (lib) {
+                memdl_staged_drop(staged);
+                memdl_load_cur = outer;
+                return lib;
+            }
+        }
+        const uint64_t hash = (flags & MEMDL_NOCACHE) ? 0 : img->hash;
+        lib = staged ? memdl_lib_link(img, staged, flags, hash) : memdl_lib_load(img, flags, hash);
+    } else {
+        memdl_staged_drop(staged);
+    }
+
+    if (start) {
+        info->total_ns = memdl_now_ns() - start;
+    }
+    memdl_load_end(lib, info, outer);
+    return lib && !(flags & MEMDL_NOCACHE) ? memdl_cache_publish(lib, img, flags) : lib;
+}
+
+memdl_handle_t memdl_open(const void *so_data, const size_t so_size, const int flags) {
+    memdl_load_info_t info;
+    memdl_load_info_t *outer = memdl_load_begin(&info);
+    const uint64_t start = memdl_trace_begin();
+    if (memdl_lz4_is_frame(so_data, so_size)) {
+        return memdl_open_lz4(so_data, so_size, flags, &info, outer, start);
+    }
+
+    memdl_stage = MEMDL_STAGE_VALIDATE;
+    const uint64_t stage_start = memdl_trace_begin();
+    memdl_image_t img;
+    const int valid = memdl_image_parse(&img, so_data, so_size) == 0;
+    memdl_trace_end(MEMDL_TRACE_VALIDATE, stage_start);
+    return memdl_open_image(valid ? &img : NULL, NULL, flags, &info, outer, start);
+}
+
+// 期望摘要直接作为缓存键（连同大小和加载标志）：命中时不读镜像；未命中时摘要在写入 memfd 的同一遍里算出，不一致则放弃加载
+memdl_handle_t memdl_open_verified(const void *so_data, const size_t so_size, const int flags, const uint64_t digest) {
+    memdl_load_info_t info;
+    memdl_load_info_t *outer = memdl_load_begin(&info);
+    const uint64_t start = memdl_trace_begin();
+    const int effective = memdl_effective_flags(flags);
+    if (memdl_lz4_is_frame(so_data, so_size)) {
+        // 压缩镜像校验的是帧本身，解压后照常加载
+        if (memdl_digest(so_data, so_size) == digest) {
+            return memdl_open_lz4(so_data, so_size, flags, &info, outer, start);
+        }
+        memdl_set_error_code(MEMDL_ERR_INTEGRITY, 0, "Image digest mismatch");
+        memdl_load_end(NULL, &info, outer);
+        return NULL;
+    }
+
+    memdl_stage = MEMDL_STAGE_VALIDATE;
+    uint64_t stage_start = memdl_trace_begin();
+    memdl_image_t img;
+    const int valid = memdl_image_parse(&img, so_data, so_size) == 0;
+    memdl_trace_end(MEMDL_TRACE_VALIDATE, stage_start);
+    if (!valid) {
+        return memdl_open_image(NULL, NULL, flags, &info, outer, start);
+    }
+    img.hash = digest;
+    if (!(effective & MEMDL_NOCACHE)) {
+        memdl_lib_t *lib = memdl_cache_lookup(&img, digest, effective);
+        if (lib) {
+            memdl_load_cur = outer;
+            return lib;
+        }
+    }
+
+    memdl_stage = MEMDL_STAGE_PREPARE;
+    uint64_t actual = 0;
+    memdl_staged_t staged;
+    memdl_staged_t *prepared = NULL;
+    if (effective & (MEMDL_NATIVE | MEMDL_INSTANCE)) {
+        stage_start = memdl_trace_begin();
+        actual = memdl_digest(so_data, so_size);
+        memdl_trace_end(MEMDL_TRACE_HASH, stage_start);
+    } else if (memdl_prepare_image(&img, effective, &staged, &actual) == 0) {
+        prepared = &staged;
+    } else {
+        return memdl_open_image(NULL, NULL, flags, &info, outer, start);
+    }
+    if (actual != digest) {
+        memdl_staged_drop(prepared);
+        memdl_set_error_code(MEMDL_ERR_INTEGRITY, 0, "Image digest mismatch: expected %016llx, got %016llx",
+                             (unsigned long long) digest, (unsigned long long) actual);
+        if (start) {
+            info.total_ns = memdl_now_ns() - start;
+        }
+        memdl_load_end(NULL, &info, outer);
+        return NULL;
+    }
+    return memdl_open_image(&img, prepared, flags, &info, outer, start);
+}
+
+memdl_handle_t memdl_image_open(const memdl_image_t *image, const int flags) {
+    if (!image) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid image");
+        return NULL;
+    }
+    memdl_load_info_t info;
+    memdl_load_info_t *outer = memdl_load_begin(&info);
+    const uint64_t start = memdl_trace_begin();
+    memdl_image_t img = *image;
+    return memdl_open_image(&img, NULL, flags, &info, outer, start);
+}
+
+// 流式接收的镜像：有 memfd 时数据直接读入其共享映射，否则读入堆缓冲区
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+    int fd;
+} memdl_stream_t;
+
+#define MEMDL_STREAM_INITIAL (1u << 20)
+
+static int memdl_stream_grow(memdl_stream_t *st, const size_t capacity) {
+    if (st->fd < 0) {
+        unsigned char *data = realloc(st->data, capacity);
+        if (!data) {
+            memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+            return -1;
+        }
+        st->data = data;
+        st->capacity = capacity;
+        return 0;
+    }
+    if (ftruncate(st->fd, (off_t) capacity) != 0) {
+        memdl_set_sys_error("ftruncate failed");
+        return -1;
+    }
+    void *data = st->data ? mremap(st->data, st->capacity, capacity, MREMAP_MAYMOVE)
+                          : mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, st->fd, 0);
+    if (data == MAP_FAILED) {
+        memdl_set_sys_error("Failed to map stream buffer");
+        return -1;
+    }
+    st->data = data;
+    st->capacity = capacity;
+    return 0;
+}
+
+static void memdl_stream_free(memdl_stream_t *st) {
+    if (st->fd >= 0) {
+        if (st->data) munmap(st->data, st->capacity);
+        close(st->fd);
+    } else {
+        free(st->data);
+    }
+}
+
+// 读取整个流；文件头一到齐就校验，格式错误的输入不必读完
+static int memdl_stream_fill(memdl_stream_t *st, const memdl_read_fn read_fn, void *ctx, const size_t size_hint) {
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t capacity = size_hint ? size_hint : MEMDL_STREAM_INITIAL;
+    capacity = (capacity + page - 1) & ~(page - 1);
+    if (memdl_stream_grow(st, capacity) != 0) {
+        return -1;
+    }
+    int validated = 0;
+    for (;;) {
+        if (st->size == st->capacity && memdl_stream_grow(st, st->capacity * 2) != 0) {
+            return -1;
+        }
+        const ptrdiff_t n = read_fn(ctx, st->data + st->size, st->capacity - st->size);
+        if (n < 0 || (size_t) n > st->capacity - st->size) {
+            memdl_set_error_code(MEMDL_ERR_FAILED, 0, "Stream read failed");
+            return -1;
+        }
+        if (n == 0) break;
+        st->size += (size_t) n;
+        if (!validated && st->size >= 64) {
+            memdl_stage = MEMDL_STAGE_VALIDATE;
+            memdl_image_t header;
+            if (memdl_image_parse_header(&header, st->data, st->size) != 0) {
+                return -1;
+            }
+            memdl_stage = MEMDL_STAGE_PREPARE;
+            validated = 1;
+        }
+    }
+    if (st->size == 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Empty stream");
+        return -1;
+    }
+    return 0;
+}
+
+// 写满后把 memfd 截到实际长度，改为只读私有映射并封印
+static int memdl_stream_seal(memdl_stream_t *st) {
+    if (ftruncate(st->fd, (off_t) st->size) != 0) {
+        memdl_set_sys_error("ftruncate failed");
+        return -1;
+    }
+    munmap(st->data, st->capacity);
+    st->capacity = st->size;
+    st->data = mmap(NULL, st->size, PROT_READ, MAP_PRIVATE, st->fd, 0);
+    if (st->data == MAP_FAILED) {
+        st->data = NULL;
+        memdl_set_sys_error("mmap failed");
+        return -1;
+    }
+    fcntl(st->fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW);
+    return 0;
+}
+
+// 加载已写满的流：封印 memfd、完整解析后交给 memdl_open_image；ok 为 0 时只清理并结束加载记录
+static memdl_lib_t *memdl_stream_open(memdl_stream_t *st, int ok, const int flags, memdl_load_info_t *info,
+                                      memdl_load_info_t *outer, const uint64_t start) {
+    uint64_t stage_start;
+    if (ok && st->fd >= 0) {
+        memdl_load_note(MEMDL_STRATEGY_MEMFD, st->size);
+        stage_start = memdl_trace_begin();
+        ok = memdl_stream_seal(st) == 0;
+        memdl_trace_end(MEMDL_TRACE_SEAL, stage_start);
+    }
+
+    memdl_image_t img;
+    if (ok) {
+        memdl_stage = MEMDL_STAGE_VALIDATE;
+        stage_start = memdl_trace_begin();
+        ok = memdl_image_parse(&img, st->data, st->size) == 0;
+        memdl_trace_end(MEMDL_TRACE_VALIDATE, stage_start);
+    }
+    // memfd 交给加载流程接管，映射在链接完成后即可释放（dlopen 和原生加载器都不再引用它）
+    memdl_staged_t staged = {.fd = ok ? st->fd : -1};
+    if (ok) st->fd = -1;
+    const int handed_over = staged.fd >= 0;
+    // 接收或解压出的数据在加载后释放，不能按需调页，退回立即复制的原生加载
+    memdl_lib_t *lib = memdl_open_image(ok ? &img : NULL, handed_over ? &staged : NULL,
+                                        memdl_effective_flags(flags) & ~MEMDL_ONDEMAND, info, outer, start);
+    if (handed_over) {
+        munmap(st->data, st->capacity);
+    } else {
+        memdl_stream_free(st);
+    }
+    return lib;
+}
+
+memdl_handle_t memdl_open_stream(const memdl_read_fn read_fn, void *ctx, const size_t size_hint, const int flags) {
+    if (!read_fn) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid read callback");
+        return NULL;
+    }
+    memdl_load_info_t info;
+    memdl_load_info_t *outer = memdl_load_begin(&info);
+    const uint64_t start = memdl_trace_begin();
+    memdl_stage = MEMDL_STAGE_PREPARE;
+
+    // 原生加载器和临时文件路径不需要 memfd
+    memdl_stream_t st = {NULL, 0, 0, -1};
+    uint64_t stage_start = memdl_trace_begin();
+    if (!(memdl_effective_flags(flags) & (MEMDL_NATIVE | MEMDL_TMPFILE))) {
+        st.fd = memdl_memfd_create(NULL, MFD_ALLOW_SEALING);
+    }
+    memdl_trace_end(MEMDL_TRACE_CREATE, stage_start);
+
+    stage_start = memdl_trace_begin();
+    const int ok = memdl_stream_fill(&st, read_fn, ctx, size_hint) == 0;
+    memdl_trace_end(MEMDL_TRACE_COPY, stage_start);
+    return memdl_stream_open(&st, ok, flags, &info, outer, start);
+}
+
+// 从描述符读取，供未封印且无法（或无需）复制到 memfd 的来源走流式路径
+static ptrdiff_t memdl_fd_read(void *ctx, void *buf, const size_t size) {
+    for (;;) {
+        const ssize_t n = read(*(const int *) ctx, buf, size);
+        if (n < 0 && errno == EINTR) continue;
+        return n;
+    }
+}
+
+// 已封印的 memfd：映射只用于解析与计算哈希，链接直接使用 memfd（总会被接管）
+static memdl_lib_t *memdl_open_sealed(const int memfd, const int flags, memdl_load_info_t *info,
+                                      memdl_load_info_t *outer, const uint64_t start) {
+    memdl_staged_t staged = {.fd = memfd};
+    struct stat st;
+    void *map = MAP_FAILED;
+    memdl_stage = MEMDL_STAGE_VALIDATE;
+    if (fstat(memfd, &st) != 0) {
+        memdl_set_sys_error("fstat failed");
+    } else if (st.st_size <= 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Empty image descriptor");
+    } else if ((map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, memfd, 0)) == MAP_FAILED) {
+        memdl_set_sys_error("mmap failed");
+    }
+    memdl_image_t img;
+    const uint64_t stage_start = memdl_trace_begin();
+    const int valid = map != MAP_FAILED && memdl_image_parse(&img, map, (size_t) st.st_size) == 0;
+    memdl_trace_end(MEMDL_TRACE_VALIDATE, stage_start);
+    // 映射在链接完成后即可释放，按需调页需要调用者的数据常驻，退回立即复制
+    memdl_lib_t *lib = memdl_open_image(valid ? &img : NULL, &staged, memdl_effective_flags(flags) & ~MEMDL_ONDEMAND,
+                                        info, outer, start);
+    if (map != MAP_FAILED) {
+        munmap(map, (size_t) st.st_size);
+    }
+    return lib;
+}
+
+// 描述符与 memdl_open 的数据一样走完整的加载流程（缓存、内存依赖、原生加载器、实例与落地顺序）：
+// 已封印的 memfd 复制描述符后直接加载；其他来源需要 memfd 时在内核内复制并封印，
+// 否则（原生加载、MEMDL_TMPFILE 或 memfd 不可用）读入缓冲区后照常准备
+memdl_handle_t memdl_open_fd(const int fd, const int flags) {
+    memdl_stage = MEMDL_STAGE_PREPARE;
+    if (fd < 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid file descriptor");
+        return NULL;
+    }
+    memdl_load_info_t info;
+    memdl_load_info_t *outer = memdl_load_begin(&info);
+    const uint64_t start = memdl_trace_begin();
+
+    if (memdl_fd_is_sealed(fd)) {
+        const int memfd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (memfd < 0) {
+            memdl_set_sys_error("dup failed");
+            return memdl_open_image(NULL, NULL, flags, &info, outer, start);
+        }
+        memdl_load_note(MEMDL_STRATEGY_FD, 0);
+        return memdl_open_sealed(memfd, flags, &info, outer, start);
+    }
+
+    uint64_t stage_start = memdl_trace_begin();
+    int memfd = -1;
+    if (!(memdl_effective_flags(flags) & (MEMDL_NATIVE | MEMDL_TMPFILE))) {
+        memfd = memdl_memfd_create(NULL, MFD_ALLOW_SEALING);
+    }
+    memdl_trace_end(MEMDL_TRACE_CREATE, stage_start);
+    if (memfd >= 0) {
+        stage_start = memdl_trace_begin();
+        if (memdl_copy_fd(fd, memfd) != 0) {
+            memdl_set_sys_error("Failed to copy image into memfd");
+            close(memfd);
+            return memdl_open_image(NULL, NULL, flags, &info, outer, start);
+        }
+        memdl_trace_end(MEMDL_TRACE_COPY, stage_start);
+        struct stat st;
+        memdl_load_note(MEMDL_STRATEGY_MEMFD, fstat(memfd, &st) == 0 ? (uint64_t) st.st_size : 0);
+        stage_start = memdl_trace_begin();
+        fcntl(memfd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW);
+        memdl_trace_end(MEMDL_TRACE_SEAL, stage_start);
+        return memdl_open_sealed(memfd, flags, &info, outer, start);
+    }
+
+    struct stat st;
+    const size_t size_hint = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) ? (size_t) st.st_size : 0;
+    memdl_stream_t stream = {NULL, 0, 0, -1};
+    int source = fd;
+    stage_start = memdl_trace_begin();
+    const int ok = memdl_stream_fill(&stream, memdl_fd_read, &source, size_hint) == 0;
+    memdl_trace_end(MEMDL_TRACE_COPY, stage_start);
+    return memdl_stream_open(&stream, ok, flags, &info, outer, start);
+}
+
+void *memdl_sym(memdl_handle_t handle, const char *symbol) {
+    memdl_stage = MEMDL_STAGE_SYMBOL;
+    if (!handle || !symbol) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid handle");
+        return NULL;
+    }
+    const memdl_lib_t *lib = handle;
+    if (lib->index) {
+        void *sym = memdl_symindex_find(lib->index, symbol);
+        if (sym) {
+            return sym;
+        }
+    }
+    if (lib->native) {
+        return memdl_native_sym(lib->native, symbol);
+    }
+    // 索引未命中时交给 dlsym（可查到依赖库中的符号）
+    void *sym = dlsym(lib->dl, symbol);
+    if (!sym) {
+        const char *err = dlerror();
+        memdl_set_error_code(MEMDL_ERR_SYMBOL, 0, "%s", err ? err : "Symbol not found");
+    }
+    return sym;
+}
+
+size_t memdl_sym_many(memdl_handle_t handle, const char *const *symbols, void **addrs, const size_t count) {
+    if (!handle || !symbols || !addrs) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return 0;
+    }
+    size_t resolved = 0;
+    for (size_t i = 0; i < count; i++) {
+        addrs[i] = memdl_sym(handle, symbols[i]);
+        if (addrs[i]) resolved++;
+    }
+    return resolved;
+}
+
+int memdl_close(memdl_handle_t handle) {
+    memdl_stage = MEMDL_STAGE_CLOSE;
+    if (!handle) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid handle");
+        return -1;
+    }
+    memdl_lib_t *lib = handle;
+
+    // 仅在最后一个引用释放时真正卸载；缓存中的句柄需在桶锁内归零并移除，防止被并发查找复活
+    if (!lib->cached) {
+        if (atomic_fetch_sub_explicit(&lib->refcount, 1, memory_order_acq_rel) > 1) {
+            return 0;
+        }
+        return memdl_lib_unload(lib);
+    }
+
+    pthread_mutex_t *lock = memdl_cache_lock(lib->hash);
+    pthread_mutex_lock(lock);
+    if (atomic_fetch_sub_explicit(&lib->refcount, 1, memory_order_acq_rel) > 1) {
+        pthread_mutex_unlock(lock);
+        return 0;
+    }
+    memdl_cache_remove(lib);
+    pthread_mutex_unlock(lock);
+
+    return memdl_lib_unload(lib);
+}
+
+void memdl_cache_stats(memdl_cache_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    stats->hits = atomic_load_explicit(&memdl_cache_hits, memory_order_relaxed);
+    stats->misses = atomic_load_explicit(&memdl_cache_misses, memory_order_relaxed);
+    stats->entries = atomic_load_explicit(&memdl_cache_entries, memory_order_relaxed);
+}
+
+
+// ---------------------------------------------------------------------------
+// 工作线程池：批量/异步加载共用，线程按需启动且常驻
+// ---------------------------------------------------------------------------
+
+typedef struct memdl_task {
+    void (*fn)(void *);
+    void *arg;
+    struct memdl_task *next;
+} memdl_task_t;
+
+static pthread_mutex_t memdl_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t memdl_pool_cond = PTHREAD_COND_INITIALIZER;
+static memdl_task_t *memdl_pool_head = NULL;
+static memdl_task_t *memdl_pool_tail = NULL;
+static unsigned memdl_pool_started = 0;     // 已启动的工作线程数
+static unsigned memdl_pool_target = 0;      // 目标线程数，0 表示按 CPU 核数
+
+static unsigned memdl_pool_size_locked(void) {
+    if (memdl_pool_target == 0) {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        memdl_pool_target = cpus > 0 ? (unsigned) cpus : 1;
+    }
+    return memdl_pool_target;
+}
+
+static void *memdl_pool_main(void *arg) {
+    (void) arg;
+    for (;;) {
+        pthread_mutex_lock(&memdl_pool_lock);
+        while (!memdl_pool_head) {
+            pthread_cond_wait(&memdl_pool_cond, &memdl_pool_lock);
+        }
+        memdl_task_t *task = memdl_pool_head;
+        memdl_pool_head = task->next;
+        if (!memdl_pool_head) memdl_pool_tail = NULL;
+        pthread_mutex_unlock(&memdl_pool_lock);
+
+        task->fn(task->arg);
+        free(task);
+    }
+    return NULL;
+}
+
+// 提交任务；没有可用的工作线程时返回 -1，调用者需自行执行
+static int memdl_pool_submit(void (*fn)(void *), void *arg) {
+    memdl_task_t *task = malloc(sizeof(memdl_task_t));
+    if (!task) {
+        return -1;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->next = NULL;
+
+    pthread_mutex_lock(&memdl_pool_lock);
+    const unsigned size = memdl_pool_size_locked();
+    while (memdl_pool_started < size) {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, memdl_pool_main, NULL) != 0) {
+            break;
+        }
+        pthread_detach(tid);
+        memdl_pool_started++;
+    }
+    if (memdl_pool_started == 0) {
+        pthread_mutex_unlock(&memdl_pool_lock);
+        free(task);
+        return -1;
+    }
+    if (memdl_pool_tail) {
+        memdl_pool_tail->next = task;
+    } else {
+        memdl_pool_head = task;
+    }
+    memdl_pool_tail = task;
+    pthread_cond_signal(&memdl_pool_cond);
+    pthread_mutex_unlock(&memdl_pool_lock);
+    return 0;
+}
+
+void memdl_set_threads(const unsigned threads) {
+    pthread_mutex_lock(&memdl_pool_lock);
+    memdl_pool_target = threads;
+    pthread_mutex_unlock(&memdl_pool_lock);
+}
+
+unsigned memdl_get_threads(void) {
+    pthread_mutex_lock(&memdl_pool_lock);
+    const unsigned size = memdl_pool_size_locked();
+    pthread_mutex_unlock(&memdl_pool_lock);
+    return size;
+}
+
+// ---------------------------------------------------------------------------
+// 压缩镜像：LZ4 帧直接解压进 memfd，独立块在线程池中并行解码
+// ---------------------------------------------------------------------------
+
+// 独立块的并行解码：除最后一块外每块都应解出 block_max 字节，输出位置可预先算出
+typedef struct {
+    const memdl_lz4_frame_t *frame;
+    unsigned char *out;
+    size_t last_size;
+    atomic_size_t next;
+    atomic_size_t done;
+    atomic_int failed;
+    atomic_int refs;
+    memdl_error_info_t error;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} memdl_lz4_job_t;
+
+static void memdl_lz4_job_release(memdl_lz4_job_t *job) {
+    if (atomic_fetch_sub_explicit(&job->refs, 1, memory_order_acq_rel) == 1) {
+        pthread_mutex_destroy(&job->lock);
+        pthread_cond_destroy(&job->cond);
+        free(job);
+    }
+}
+
+static void memdl_lz4_job_run(memdl_lz4_job_t *job) {
+    const memdl_lz4_frame_t *frame = job->frame;
+    for (;;) {
+        const size_t i = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed);
+        if (i >= frame->count) break;
+        const size_t off = i * frame->block_max;
+        const size_t room = off < frame->bound ? frame->bound - off : 0;
+        const ptrdiff_t n = memdl_lz4_decode(frame, i, job->out + off, room < frame->block_max ? room : frame->block_max, 0);
+        const int last = i + 1 == frame->count;
+        if (n < 0 || (!last && (size_t) n != frame->block_max)) {
+            pthread_mutex_lock(&job->lock);
+            if (!atomic_exchange_explicit(&job->failed, n < 0 ? 1 : 2, memory_order_relaxed)) {
+                job->error = memdl_last_error_info;
+            }
+            pthread_mutex_unlock(&job->lock);
+        } else if (last) {
+            job->last_size = (size_t) n;
+        }
+        if (atomic_fetch_add_explicit(&job->done, 1, memory_order_acq_rel) + 1 == frame->count) {
+            pthread_mutex_lock(&job->lock);
+            pthread_cond_broadcast(&job->cond);
+            pthread_mutex_unlock(&job->lock);
+        }
+    }
+}
+
+static void memdl_lz4_worker(void *arg) {
+    memdl_lz4_job_t *job = arg;
+    memdl_lz4_job_run(job);
+    memdl_lz4_job_release(job);
+}
+
+// 解码整个帧；独立块且多于一块时分给线程池，调用者线程同样参与
+static ptrdiff_t memdl_lz4_decode_parallel(const memdl_lz4_frame_t *frame, unsigned char *out) {
+    const unsigned threads = memdl_get_threads();
+    if (!frame->independent || frame->count < 2 || threads < 2) {
+        return memdl_lz4_decode_all(frame, out);
+    }
+    memdl_lz4_job_t *job = calloc(1, sizeof(memdl_lz4_job_t));
+    if (!job) {
+        return memdl_lz4_decode_all(frame, out);
+    }
+    job->frame = frame;
+    job->out = out;
+    atomic_init(&job->refs, 1);
+    pthread_mutex_init(&job->lock, NULL);
+    pthread_cond_init(&job->cond, NULL);
+    const size_t workers = frame->count < threads ? frame->count : threads;
+    for (size_t w = 1; w < workers; w++) {
+        atomic_fetch_add_explicit(&job->refs, 1, memory_order_relaxed);
+        if (memdl_pool_submit(memdl_lz4_worker, job) != 0) {
+            atomic_fetch_sub_explicit(&job->refs, 1, memory_order_relaxed);
+            break;
+        }
+    }
+    memdl_lz4_job_run(job);
+    pthread_mutex_lock(&job->lock);
+    while (atomic_load_explicit(&job->done, memory_order_acquire) < frame->count) {
+        pthread_cond_wait(&job->cond, &job->lock);
+    }
+    pthread_mutex_unlock(&job->lock);
+
+    const int failed = atomic_load_explicit(&job->failed, memory_order_relaxed);
+    const memdl_error_info_t error = job->error;
+    const size_t size = (frame->count - 1) * frame->block_max + job->last_size;
+    memdl_lz4_job_release(job);
+    if (failed == 2) {
+        // 编码器没有填满中间的块，输出位置无法预知，改为顺序解码
+        return memdl_lz4_decode_all(frame, out);
+    }
+    if (failed) {
+        memdl_last_error_info = error;
+        return -1;
+    }
+    return (ptrdiff_t) size;
+}
+
+// LZ4 压缩的镜像：扫描块表得到输出上界，直接解压进 memfd 映射后按流式加载的流程链接
+// 把已解析的帧解压进 st 并释放帧；memfd 为真时数据直接写入 memfd 的共享映射
+static int memdl_lz4_inflate(memdl_lz4_frame_t *frame, memdl_stream_t *st, const int memfd) {
+    if (frame->bound == 0) {
+        memdl_format_error("Empty LZ4 frame");
+        memdl_lz4_free(frame);
+        return -1;
+    }
+    memdl_stage = MEMDL_STAGE_PREPARE;
+    uint64_t stage_start = memdl_trace_begin();
+    if (memfd) {
+        st->fd = memdl_memfd_create(NULL, MFD_ALLOW_SEALING);
+    }
+    int ok = memdl_stream_grow(st, frame->bound) == 0;
+    memdl_trace_end(MEMDL_TRACE_CREATE, stage_start);
+
+    stage_start = memdl_trace_begin();
+    const ptrdiff_t n = ok ? memdl_lz4_decode_parallel(frame, st->data) : -1;
+    ok = n >= 0 && memdl_lz4_verify(frame, st->data, (size_t) n) == 0;
+    memdl_trace_end(MEMDL_TRACE_COPY, stage_start);
+    st->size = ok ? (size_t) n : 0;
+    memdl_lz4_free(frame);
+    return ok && st->size > 0 ? 0 : -1;
+}
+
+// 按需调页：镜像经解压视图解析，段页面在首次访问时才解码对应的块
+static memdl_lib_t *memdl_open_lz4_view(memdl_lazy_t *view, const int flags, memdl_load_info_t *info,
+                                        memdl_load_info_t *outer, const uint64_t start) {
+    memdl_stage = MEMDL_STAGE_VALIDATE;
+    const uint64_t stage_start = memdl_trace_begin();
+    memdl_image_t img;
+    const int valid = memdl_image_parse(&img, (const void *) view->lo, view->view_size) == 0;
+    memdl_trace_end(MEMDL_TRACE_VALIDATE, stage_start);
+    memdl_lib_t *lib = memdl_open_image(valid ? &img : NULL, NULL, flags, info, outer, start);
+    if (lib && lib->native) {
+        lib->native->view = view;
+    } else {
+        memdl_lazy_view_close(view);
+    }
+    return lib;
+}
+
+static memdl_lib_t *memdl_open_lz4(const void *so_data, const size_t so_size, const int open_flags,
+                                   memdl_load_info_t *info, memdl_load_info_t *outer, const uint64_t start) {
+    const int flags = memdl_effective_flags(open_flags);
+    memdl_stage = MEMDL_STAGE_VALIDATE;
+    memdl_lz4_frame_t frame;
+    memdl_stream_t st = {NULL, 0, 0, -1};
+    int ok = memdl_lz4_parse(&frame, so_data, so_size) == 0;
+    if (ok && (flags & MEMDL_ONDEMAND)) {
+        // 块相关联或 userfaultfd 不可用时退回完整解压
+        memdl_lazy_t *view = memdl_lazy_view(&frame);
+        if (view) {
+            return memdl_open_lz4_view(view, flags, info, outer, start);
+        }
+    }
+    if (ok) {
+        ok = memdl_lz4_inflate(&frame, &st, !(flags & (MEMDL_NATIVE | MEMDL_TMPFILE))) == 0;
+    }
+    return memdl_stream_open(&st, ok, flags, info, outer, start);
+}
+
+// ---------------------------------------------------------------------------
+// 跨进程共享：已封印的 memfd 经 fork 或 SCM_RIGHTS 传递，各进程映射同一份页缓存
+// ---------------------------------------------------------------------------
+
+int memdl_export_fd(const void *so_data, const size_t so_size) {
+    if (!so_data || so_size == 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid image");
+        return -1;
+    }
+    memdl_stage = MEMDL_STAGE_VALIDATE;
+    memdl_stream_t st = {NULL, 0, 0, -1};
+    memdl_image_t img;
+    if (memdl_lz4_is_frame(so_data, so_size)) {
+        memdl_lz4_frame_t frame;
+        const int ok = memdl_lz4_parse(&frame, so_data, so_size) == 0 && memdl_lz4_inflate(&frame, &st, 1) == 0 &&
+                       st.fd >= 0 && memdl_stream_seal(&st) == 0 &&
+                       memdl_image_parse(&img, st.data, st.size) == 0;
+        if (!ok) {
+            if (st.fd < 0 && st.data) {
+                memdl_set_error_code(MEMDL_ERR_SYSTEM, 0, "memfd_create failed");
+            }
+            memdl_stream_free(&st);
+            return -1;
+        }
+        munmap(st.data, st.capacity);
+    } else {
+        if (memdl_image_parse(&img, so_data, so_size) != 0) {
+            return -1;
+        }
+        memdl_stage = MEMDL_STAGE_PREPARE;
+        st.fd = memdl_memfd_create(&img, MFD_ALLOW_SEALING);
+        if (st.fd < 0 || memdl_write_all(st.fd, so_data, so_size) != 0) {
+            memdl_set_sys_error("Failed to write image into memfd");
+            if (st.fd >= 0) close(st.fd);
+            return -1;
+        }
+        fcntl(st.fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW);
+    }
+    // 未封印的 fd 会在 memdl_open_fd 中被复制，失去共享的意义
+    if (!memdl_fd_is_sealed(st.fd)) {
+        memdl_set_sys_error("Failed to seal memfd");
+        close(st.fd);
+        return -1;
+    }
+    return st.fd;
+}
+
+int memdl_send_fd(const int socket, const int fd) {
+    if (socket < 0 || fd < 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid file descriptor");
+        return -1;
+    }
+    char byte = 0;
+    struct iovec iov = {&byte, 1};
+    union {
+        struct cmsghdr header;
+        char data[CMSG_SPACE(sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data;
+    msg.msg_controllen = sizeof(control.data);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    ssize_t n;
+    do {
+        n = sendmsg(socket, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n != 1) {
+        memdl_set_sys_error("sendmsg failed");
+        return -1;
+    }
+    return 0;
+}
+
+int memdl_recv_fd(const int socket) {
+    if (socket < 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid socket");
+        return -1;
+    }
+    char byte;
+    struct iovec iov = {&byte, 1};
+    union {
+        struct cmsghdr header;
+        char data[CMSG_SPACE(4 * sizeof(int))];
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data;
+    msg.msg_controllen = sizeof(control.data);
+    ssize_t n;
+    do {
+        n = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        memdl_set_sys_error("recvmsg failed");
+        return -1;
+    }
+    // 只取第一个描述符，多余的关闭
+    int fd = -1;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+        const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; i++) {
+            int received;
+            memcpy(&received, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (fd < 0) {
+                fd = received;
+            } else {
+                close(received);
+            }
+        }
+    }
+    if (fd < 0) {
+        memdl_set_error_code(MEMDL_ERR_FAILED, 0, n == 0 ? "Connection closed" : "No file descriptor received");
+    }
+    return fd;
+}
+
+// ---------------------------------------------------------------------------
+// 批量加载：校验/填充 memfd/封印在线程池中并行，dlopen 按输入顺序串行
+// ---------------------------------------------------------------------------
+
+#define MEMDL_JOB_PENDING 0
+#define MEMDL_JOB_DONE    1
+
+typedef struct {
+    memdl_image_t image;       // 准备阶段解析，链接阶段复用
+    uint64_t hash;
+    memdl_staged_t staged;     // 准备好的镜像，fd 为 -1 表示未准备（命中缓存或原生加载）
+    int failed;
+    memdl_lib_t *hit;          // 准备阶段命中缓存的句柄
+    memdl_load_info_t info;    // 准备阶段在工作线程记录，链接阶段在调用者线程继续
+    atomic_int state;
+} memdl_batch_job_t;
+
+typedef struct {
+    const memdl_source_t *images;
+    memdl_open_result_t *results;
+    memdl_batch_job_t *jobs;
+    size_t count;
+    int flags;
+    atomic_size_t next;        // 下一个待认领的准备任务
+    atomic_int refs;           // 调用者与工作线程共同持有，最后一个释放者负责回收
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} memdl_batch_t;
+
+static void memdl_batch_release(memdl_batch_t *batch) {
+    if (atomic_fetch_sub_explicit(&batch->refs, 1, memory_order_acq_rel) == 1) {
+        pthread_mutex_destroy(&batch->lock);
+        pthread_cond_destroy(&batch->cond);
+        free(batch->jobs);
+        free(batch);
+    }
+}
+
+static void memdl_batch_prepare(memdl_batch_t *batch, const size_t i) {
+    const memdl_source_t *image = &batch->images[i];
+    memdl_batch_job_t *job = &batch->jobs[i];
+    memdl_open_result_t *result = &batch->results[i];
+    const uint64_t start = memdl_now_ns();
+    memdl_load_info_t *outer = memdl_load_begin(&job->info);
+
+    memdl_stage = MEMDL_STAGE_VALIDATE;
+    uint64_t stage_start = memdl_trace_begin();
+    if (memdl_image_parse(&job->image, image->data, image->size) != 0) {
+        job->failed = 1;
+        result->error = memdl_last_error_info;
+    } else {
+        memdl_trace_end(MEMDL_TRACE_VALIDATE, stage_start);
+        memdl_stage = MEMDL_STAGE_PREPARE;
+        if (!(batch->flags & MEMDL_NOCACHE)) {
+            stage_start = memdl_trace_begin();
+            job->hash = memdl_digest(image->data, image->size);
+            memdl_trace_end(MEMDL_TRACE_HASH, stage_start);
+            job->hit = memdl_cache_lookup(&job->image, job->hash, batch->flags);
+        }
+        if (!job->hit && !(batch->flags & MEMDL_NATIVE) &&
+            memdl_prepare_image(&job->image, batch->flags, &job->staged, NULL) != 0) {
+            job->failed = 1;
+            result->error = memdl_last_error_info;
+        }
+    }
+    memdl_load_cur = outer;
+    result->prepare_ns = memdl_now_ns() - start;
+
+    pthread_mutex_lock(&batch->lock);
+    atomic_store_explicit(&job->state, MEMDL_JOB_DONE, memory_order_release);
+    pthread_cond_broadcast(&batch->cond);
+    pthread_mutex_unlock(&batch->lock);
+}
+
+static void memdl_batch_worker(void *arg) {
+    memdl_batch_t *batch = arg;
+    for (;;) {
+        const size_t i = atomic_fetch_add_explicit(&batch->next, 1, memory_order_relaxed);
+        if (i >= batch->count) break;
+        memdl_batch_prepare(batch, i);
+    }
+    memdl_batch_release(batch);
+}
+
+// 等待第 i 个镜像准备完成；期间调用者自己认领尚未开始的准备任务，不依赖线程池一定有空闲线程
+static void memdl_batch_wait(memdl_batch_t *batch, const size_t i) {
+    while (atomic_load_explicit(&batch->jobs[i].state, memory_order_acquire) != MEMDL_JOB_DONE) {
+        const size_t j = atomic_fetch_add_explicit(&batch->next, 1, memory_order_relaxed);
+        if (j < batch->count) {
+            memdl_batch_prepare(batch, j);
+            continue;
+        }
+        pthread_mutex_lock(&batch->lock);
+        while (atomic_load_explicit(&batch->jobs[i].state, memory_order_acquire) != MEMDL_JOB_DONE) {
+            pthread_cond_wait(&batch->cond, &batch->lock);
+        }
+        pthread_mutex_unlock(&batch->lock);
+    }
+}
+
+size_t memdl_open_many(const memdl_source_t *images, const size_t count, const int open_flags,
+                       memdl_open_result_t *results, memdl_batch_info_t *info) {
+    const uint64_t start = memdl_now_ns();
+    const int flags = memdl_effective_flags(open_flags);
+    if (info) {
+        memset(info, 0, sizeof(*info));
+    }
+    if (!images || !results || count == 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return 0;
+    }
+    memset(results, 0, count * sizeof(memdl_open_result_t));
+
+    memdl_batch_t *batch = calloc(1, sizeof(memdl_batch_t));
+    memdl_batch_job_t *jobs = calloc(count, sizeof(memdl_batch_job_t));
+    if (!batch || !jobs) {
+        free(batch);
+        free(jobs);
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        jobs[i].staged.fd = -1;
+    }
+    batch->images = images;
+    batch->results = results;
+    batch->jobs = jobs;
+    batch->count = count;
+    batch->flags = flags;
+    atomic_init(&batch->next, 0);
+    atomic_init(&batch->refs, 1);
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->cond, NULL);
+
+    // 调用者线程也参与准备，因此最多再派发 threads - 1 个工作任务
+    const unsigned threads = memdl_get_threads();
+    const size_t workers = count < threads ? count : threads;
+    for (size_t w = 1; w < workers; w++) {
+        atomic_fetch_add_explicit(&batch->refs, 1, memory_order_relaxed);
+        if (memdl_pool_submit(memdl_batch_worker, batch) != 0) {
+            atomic_fetch_sub_explicit(&batch->refs, 1, memory_order_relaxed);
+            break;
+        }
+    }
+
+    size_t loaded = 0;
+    for (size_t i = 0; i < count; i++) {
+        memdl_batch_wait(batch, i);
+        memdl_batch_job_t *job = &jobs[i];
+        memdl_open_result_t *result = &results[i];
+        if (job->failed) {
+            memdl_load_end(NULL, &job->info, memdl_load_cur);
+            continue;
+        }
+
+        const uint64_t link_start = memdl_now_ns();
+        memdl_lib_t *lib = job->hit;
+        if (!lib && !(flags & MEMDL_NOCACHE)) {
+            // 同一批次中的重复镜像可能已在前面链接完成
+            pthread_mutex_t *lock = memdl_cache_lock(job->hash);
+            pthread_mutex_lock(lock);
+            lib = memdl_cache_find(&job->image, job->hash, flags);
+            pthread_mutex_unlock(lock);
+            if (lib) {
+                memdl_staged_drop(&job->staged);
+            }
+        }
+        if (!lib) {
+            memdl_load_info_t *outer = memdl_load_cur;
+            memdl_load_cur = &job->info;
+            memdl_stage = MEMDL_STAGE_PREPARE;
+            lib = memdl_lib_link(&job->image, job->staged.fd >= 0 ? &job->staged : NULL, flags, job->hash);
+            result->link_ns = memdl_now_ns() - link_start;
+            if (atomic_load_explicit(&memdl_timing, memory_order_relaxed)) {
+                job->info.total_ns = result->prepare_ns + result->link_ns;
+            }
+            memdl_load_end(lib, &job->info, outer);
+            if (lib && !(flags & MEMDL_NOCACHE)) {
+                lib = memdl_cache_publish(lib, &job->image, flags);
+            }
+        }
+        result->link_ns = memdl_now_ns() - link_start;
+        if (lib) {
+            result->handle = lib;
+            loaded++;
+        } else {
+            result->error = memdl_last_error_info;
+        }
+    }
+
+    if (info) {
+        info->loaded = loaded;
+        info->failed = count - loaded;
+        info->threads = (unsigned) workers;
+        info->wall_ns = memdl_now_ns() - start;
+    }
+    memdl_batch_release(batch);
+    return loaded;
+}
+
+// ---------------------------------------------------------------------------
+// 异步加载：票据由调用者与工作线程共同持有
+// ---------------------------------------------------------------------------
+
+struct memdl_ticket {
+    const void *data;
+    size_t size;
+    int flags;
+    int done;
+    int taken;                 // 句柄已被 memdl_ticket_result 取走
+    int refs;
+    memdl_handle_t handle;
+    memdl_error_info_t error;
+    memdl_ticket_callback_t callback;
+    void *user;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static void memdl_ticket_release(memdl_ticket_t *ticket) {
+    pthread_mutex_lock(&ticket->lock);
+    const int refs = --ticket->refs;
+    pthread_mutex_unlock(&ticket->lock);
+    if (refs > 0) {
+        return;
+    }
+    if (ticket->handle && !ticket->taken) {
+        memdl_close(ticket->handle);
+    }
+    pthread_mutex_destroy(&ticket->lock);
+    pthread_cond_destroy(&ticket->cond);
+    free(ticket);
+}
+
+static void memdl_ticket_run(void *arg) {
+    memdl_ticket_t *ticket = arg;
+    memdl_clear_error();
+    memdl_handle_t handle = memdl_open(ticket->data, ticket->size, ticket->flags);
+
+    pthread_mutex_lock(&ticket->lock);
+    ticket->handle = handle;
+    ticket->error = memdl_last_error_info;
+    ticket->done = 1;
+    memdl_ticket_callback_t callback = ticket->callback;
+    pthread_cond_broadcast(&ticket->cond);
+    pthread_mutex_unlock(&ticket->lock);
+
+    if (callback) {
+        callback(ticket, ticket->user);
+    }
+    memdl_ticket_release(ticket);
+}
+
+memdl_ticket_t *memdl_open_async(const void *so_data, const size_t so_size, const int flags) {
+    if (!so_data || so_size == 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return NULL;
+    }
+    memdl_ticket_t *ticket = calloc(1, sizeof(memdl_ticket_t));
+    if (!ticket) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return NULL;
+    }
+    ticket->data = so_data;
+    ticket->size = so_size;
+    ticket->flags = flags;
+    ticket->refs = 2;
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&ticket->lock, NULL);
+    pthread_cond_init(&ticket->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (memdl_pool_submit(memdl_ticket_run, ticket) != 0) {
+        // 无法启动工作线程时同步完成，调用方式保持不变
+        memdl_ticket_run(ticket);
+    }
+    return ticket;
+}
+
+int memdl_ticket_poll(memdl_ticket_t *ticket) {
+    if (!ticket) {
+        return 1;
+    }
+    pthread_mutex_lock(&ticket->lock);
+    const int done = ticket->done;
+    pthread_mutex_unlock(&ticket->lock);
+    return done;
+}
+
+int memdl_ticket_wait(memdl_ticket_t *ticket, const long timeout_ms) {
+    if (!ticket) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    if (timeout_ms > 0) {
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    int rc = 0;
+    pthread_mutex_lock(&ticket->lock);
+    while (!ticket->done && rc == 0) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&ticket->cond, &ticket->lock);
+        } else {
+            rc = pthread_cond_timedwait(&ticket->cond, &ticket->lock, &deadline);
+        }
+    }
+    const int done = ticket->done;
+    pthread_mutex_unlock(&ticket->lock);
+
+    if (!done) {
+        memdl_set_error_code(MEMDL_ERR_TIMEOUT, 0, "Timed out waiting for asynchronous load");
+        return -1;
+    }
+    return 0;
+}
+
+int memdl_ticket_then(memdl_ticket_t *ticket, const memdl_ticket_callback_t callback, void *user) {
+    if (!ticket || !callback) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    pthread_mutex_lock(&ticket->lock);
+    if (ticket->callback) {
+        pthread_mutex_unlock(&ticket->lock);
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Ticket already has a callback");
+        return -1;
+    }
+    ticket->user = user;
+    ticket->callback = callback;
+    const int done = ticket->done;
+    pthread_mutex_unlock(&ticket->lock);
+
+    if (done) {
+        callback(ticket, user);
+    }
+    return 0;
+}
+
+memdl_handle_t memdl_ticket_result(memdl_ticket_t *ticket) {
+    if (memdl_ticket_wait(ticket, -1) != 0) {
+        return NULL;
+    }
+    pthread_mutex_lock(&ticket->lock);
+    ticket->taken = 1;
+    memdl_handle_t handle = ticket->handle;
+    if (!handle) {
+        memdl_last_error_info = ticket->error;
+    }
+    pthread_mutex_unlock(&ticket->lock);
+    return handle;
+}
+
+void memdl_ticket_free(memdl_ticket_t *ticket) {
+    if (ticket) {
+        memdl_ticket_release(ticket);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 热替换：读者经符号表指针间接调用，替换时发布新表，等宽限期内的读者全部离开后再卸载旧镜像。
+// 读侧只有计数器的原子加减：读者登记在当前纪元的计数器上，写者翻转纪元后等待旧纪元计数归零
+// ---------------------------------------------------------------------------
+
+#define MEMDL_SWAP_STRIPES 16
+
+typedef struct {
+    memdl_handle_t handle;
+    uint64_t version;
+    void *syms[];
+} memdl_swap_table_t;
+
+// 每个计数器独占一条缓存行，不同线程的读者互不争用
+typedef struct {
+    atomic_long count;
+    char pad[64 - sizeof(atomic_long)];
+} memdl_swap_counter_t;
+
+struct memdl_swap {
+    memdl_swap_counter_t readers[2][MEMDL_SWAP_STRIPES];
+    _Atomic(memdl_swap_table_t *) table;
+    atomic_uint epoch;
+    pthread_mutex_t lock;       // 串行化替换
+    int flags;
+    size_t count;
+    char **symbols;
+};
+
+static atomic_uint memdl_swap_threads = 0;
+static MEMDL_THREAD_LOCAL unsigned memdl_swap_thread = 0;
+
+static unsigned memdl_swap_stripe(void) {
+    if (!memdl_swap_thread) {
+        memdl_swap_thread = atomic_fetch_add_explicit(&memdl_swap_threads, 1, memory_order_relaxed) + 1;
+    }
+    return (memdl_swap_thread - 1) % MEMDL_SWAP_STRIPES;
+}
+
+// 加载镜像并解析全部符号；缺少任何一个符号都视为失败，旧版本保持不变
+static memdl_swap_table_t *memdl_swap_table_new(const memdl_swap_t *swap, const void *so_data, const size_t so_size,
+                                                const uint64_t version) {
+    memdl_swap_table_t *table = calloc(1, sizeof(memdl_swap_table_t) + swap->count * sizeof(void *));
+    if (!table) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return NULL;
+    }
+    table->handle = memdl_open(so_data, so_size, swap->flags);
+    if (!table->handle) {
+        free(table);
+        return NULL;
+    }
+    table->version = version;
+    for (size_t i = 0; i < swap->count; i++) {
+        table->syms[i] = memdl_sym(table->handle, swap->symbols[i]);
+        if (!table->syms[i]) {
+            memdl_close(table->handle);
+            free(table);
+            return NULL;
+        }
+    }
+    return table;
+}
+
+static void memdl_swap_free(memdl_swap_t *swap) {
+    for (size_t i = 0; i < swap->count; i++) {
+        free(swap->symbols[i]);
+    }
+    free(swap->symbols);
+    pthread_mutex_destroy(&swap->lock);
+    free(swap);
+}
+
+memdl_swap_t *memdl_swap_open(const void *so_data, const size_t so_size, const int flags,
+                              const char *const *symbols, const size_t count) {
+    if (!so_data || so_size == 0 || (!symbols && count > 0)) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return NULL;
+    }
+    void *mem = NULL;
+    if (posix_memalign(&mem, 64, sizeof(memdl_swap_t)) != 0) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return NULL;
+    }
+    memdl_swap_t *swap = memset(mem, 0, sizeof(memdl_swap_t));
+    pthread_mutex_init(&swap->lock, NULL);
+    swap->flags = flags;
+    swap->symbols = calloc(count ? count : 1, sizeof(char *));
+    if (!swap->symbols) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        memdl_swap_free(swap);
+        return NULL;
+    }
+    for (; swap->count < count; swap->count++) {
+        swap->symbols[swap->count] = symbols[swap->count] ? strdup(symbols[swap->count]) : NULL;
+        if (!swap->symbols[swap->count]) {
+            memdl_set_error_code(symbols[swap->count] ? MEMDL_ERR_NOMEM : MEMDL_ERR_INVALID_ARG, 0,
+                                 symbols[swap->count] ? "Out of memory" : "Invalid argument");
+            memdl_swap_free(swap);
+            return NULL;
+        }
+    }
+    memdl_swap_table_t *table = memdl_swap_table_new(swap, so_data, so_size, 1);
+    if (!table) {
+        memdl_swap_free(swap);
+        return NULL;
+    }
+    atomic_init(&swap->table, table);
+    return swap;
+}
+
+void memdl_swap_enter(memdl_swap_t *swap, memdl_swap_view_t *view) {
+    const unsigned stripe = memdl_swap_stripe();
+    for (;;) {
+        // 登记后复核纪元：翻转之后才完成登记的读者改登记到新纪元，写者只需等待旧纪元
+        const unsigned epoch = atomic_load(&swap->epoch);
+        memdl_swap_counter_t *counter = &swap->readers[epoch & 1][stripe];
+        atomic_fetch_add(&counter->count, 1);
+        if (atomic_load(&swap->epoch) == epoch) {
+            const memdl_swap_table_t *table = atomic_load(&swap->table);
+            view->syms = table->syms;
+            view->version = table->version;
+            view->slot = (epoch & 1) * MEMDL_SWAP_STRIPES + stripe;
+            return;
+        }
+        atomic_fetch_sub(&counter->count, 1);
+    }
+}
+
+void memdl_swap_leave(memdl_swap_t *swap, const memdl_swap_view_t *view) {
+    atomic_fetch_sub_explicit(&swap->readers[view->slot / MEMDL_SWAP_STRIPES][view->slot % MEMDL_SWAP_STRIPES].count,
+                              1, memory_order_release);
+}
+
+// 宽限期：翻转纪元，等待在旧纪元登记的读者全部离开（调用者持有 swap->lock）
+static void memdl_swap_synchronize(memdl_swap_t *swap) {
+    const unsigned old = atomic_fetch_add(&swap->epoch, 1) & 1;
+    for (;;) {
+        long active = 0;
+        for (int i = 0; i < MEMDL_SWAP_STRIPES; i++) {
+            active += atomic_load(&swap->readers[old][i].count);
+        }
+        if (active == 0) {
+            return;
+        }
+        sched_yield();
+    }
+}
+
+int memdl_replace(memdl_swap_t *swap, const void *so_data, const size_t so_size) {
+    if (!swap || !so_data || so_size == 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    pthread_mutex_lock(&swap->lock);
+    const memdl_swap_table_t *current = atomic_load(&swap->table);
+    memdl_swap_table_t *table = memdl_swap_table_new(swap, so_data, so_size, current->version + 1);
+    if (!table) {
+        pthread_mutex_unlock(&swap->lock);
+        return -1;
+    }
+    memdl_swap_table_t *old = atomic_exchange(&swap->table, table);
+    memdl_swap_synchronize(swap);
+    pthread_mutex_unlock(&swap->lock);
+    memdl_close(old->handle);
+    free(old);
+    return 0;
+}
 
-    // macOS/iOS 使用临时文件方案
-    char template[] = "/tmp/memdl_tmp";
-    int fd = mkstemp(template);
-    if (fd >= 0) {
-        if (write(fd, so_data, so_size) == (ssize_t) so_size) {
-            void *handle = dlopen(template, dl_flags);
-            unlink(template);
-            close(fd);
+uint64_t memdl_swap_version(memdl_swap_t *swap) {
+    return swap ? atomic_load(&swap->table)->version : 0;
+}
 
-            if (!handle) {
-                memdl_set_error(dlerror());
-            }
-            return handle;
+int memdl_swap_close(memdl_swap_t *swap) {
+    if (!swap) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    memdl_swap_table_t *table = atomic_load(&swap->table);
+    const int result = memdl_close(table->handle);
+    free(table);
+    memdl_swap_free(swap);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// 插件管理器：按名称登记来源，首次 pin 时加载；常驻字节超出预算时按 LRU 关闭未被 pin 的镜像，
+// 下次 pin 再从来源重新加载。未被 pin 的常驻条目挂在 LRU 链表上，头部最近使用
+// ---------------------------------------------------------------------------
+
+typedef struct memdl_plugin {
+    char *name;
+    const void *data;
+    size_t size;
+    memdl_handle_t handle;      // NULL 表示未常驻
+    size_t bytes;               // 常驻时映射的段字节数
+    unsigned pins;
+    int loading;                // 某个线程正在加载，其他线程等待
+    struct memdl_plugin *next;  // 名称哈希桶
+    struct memdl_plugin *lru_prev;
+    struct memdl_plugin *lru_next;
+} memdl_plugin_t;
+
+struct memdl_manager {
+    pthread_mutex_t lock;
+    pthread_cond_t loaded;
+    memdl_plugin_t **buckets;
+    size_t bucket_count;
+    size_t budget;
+    int flags;
+    memdl_plugin_t *lru_head;
+    memdl_plugin_t *lru_tail;
+    memdl_manager_stats_t stats;
+};
+
+static memdl_plugin_t *memdl_manager_find(const memdl_manager_t *mgr, const char *name) {
+    memdl_plugin_t *p = mgr->buckets[memdl_gnu_hash(name) & (mgr->bucket_count - 1)];
+    while (p && strcmp(p->name, name) != 0) p = p->next;
+    return p;
+}
+
+static void memdl_lru_unlink(memdl_manager_t *mgr, memdl_plugin_t *p) {
+    if (p->lru_prev) p->lru_prev->lru_next = p->lru_next;
+    else mgr->lru_head = p->lru_next;
+    if (p->lru_next) p->lru_next->lru_prev = p->lru_prev;
+    else mgr->lru_tail = p->lru_prev;
+    p->lru_prev = p->lru_next = NULL;
+}
+
+static void memdl_lru_push(memdl_manager_t *mgr, memdl_plugin_t *p) {
+    p->lru_prev = NULL;
+    p->lru_next = mgr->lru_head;
+    if (mgr->lru_head) mgr->lru_head->lru_prev = p;
+    else mgr->lru_tail = p;
+    mgr->lru_head = p;
+}
+
+// 从 LRU 尾部摘下超出预算的条目，句柄交给调用者在锁外关闭（持有 mgr->lock）
+static void memdl_manager_trim(memdl_manager_t *mgr, memdl_handle_t *victims, size_t *victim_count,
+                               const size_t max) {
+    while (mgr->stats.resident_bytes > mgr->budget && mgr->lru_tail && *victim_count < max) {
+        memdl_plugin_t *p = mgr->lru_tail;
+        memdl_lru_unlink(mgr, p);
+        victims[(*victim_count)++] = p->handle;
+        p->handle = NULL;
+        mgr->stats.resident_bytes -= p->bytes;
+        mgr->stats.resident--;
+        mgr->stats.evictions++;
+        p->bytes = 0;
+    }
+}
+
+// 淘汰直到满足预算；关闭句柄会执行析构函数，放在锁外
+static void memdl_manager_evict(memdl_manager_t *mgr) {
+    memdl_handle_t victims[64];
+    for (;;) {
+        size_t count = 0;
+        pthread_mutex_lock(&mgr->lock);
+        memdl_manager_trim(mgr, victims, &count, 64);
+        pthread_mutex_unlock(&mgr->lock);
+        for (size_t i = 0; i < count; i++) {
+            memdl_close(victims[i]);
+        }
+        if (count < 64) {
+            return;
         }
-        close(fd);
-        unlink(template);
     }
+}
 
-    memdl_set_error("Failed to load library");
-    return NULL;
+memdl_manager_t *memdl_manager_create(const size_t budget, const int flags) {
+    memdl_manager_t *mgr = calloc(1, sizeof(memdl_manager_t));
+    if (!mgr || !(mgr->buckets = calloc(64, sizeof(memdl_plugin_t *)))) {
+        free(mgr);
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return NULL;
+    }
+    mgr->bucket_count = 64;
+    mgr->budget = budget;
+    // 淘汰必须真正释放镜像，不能被缓存中的其他引用留住
+    mgr->flags = flags | MEMDL_NOCACHE;
+    pthread_mutex_init(&mgr->lock, NULL);
+    pthread_cond_init(&mgr->loaded, NULL);
+    return mgr;
 }
 
-void *memdl_sym(memdl_handle_t handle, const char *symbol) {
-    if (!handle) {
-        memdl_set_error("Invalid handle");
+int memdl_manager_add(memdl_manager_t *mgr, const char *name, const void *so_data, const size_t so_size) {
+    if (!mgr || !name || !*name || !so_data || so_size == 0) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    pthread_mutex_lock(&mgr->lock);
+    if (memdl_manager_find(mgr, name)) {
+        pthread_mutex_unlock(&mgr->lock);
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Plugin already added: %s", name);
+        return -1;
+    }
+    // 条目数超过桶数时加倍重新散列
+    if (mgr->stats.entries >= mgr->bucket_count) {
+        const size_t count = mgr->bucket_count * 2;
+        memdl_plugin_t **buckets = calloc(count, sizeof(memdl_plugin_t *));
+        if (buckets) {
+            for (size_t b = 0; b < mgr->bucket_count; b++) {
+                for (memdl_plugin_t *p = mgr->buckets[b], *next; p; p = next) {
+                    next = p->next;
+                    memdl_plugin_t **slot = &buckets[memdl_gnu_hash(p->name) & (count - 1)];
+                    p->next = *slot;
+                    *slot = p;
+                }
+            }
+            free(mgr->buckets);
+            mgr->buckets = buckets;
+            mgr->bucket_count = count;
+        }
+    }
+    memdl_plugin_t *p = calloc(1, sizeof(memdl_plugin_t));
+    char *copy = strdup(name);
+    if (!p || !copy) {
+        pthread_mutex_unlock(&mgr->lock);
+        free(p);
+        free(copy);
+        memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+        return -1;
+    }
+    p->name = copy;
+    p->data = so_data;
+    p->size = so_size;
+    memdl_plugin_t **slot = &mgr->buckets[memdl_gnu_hash(name) & (mgr->bucket_count - 1)];
+    p->next = *slot;
+    *slot = p;
+    mgr->stats.entries++;
+    pthread_mutex_unlock(&mgr->lock);
+    return 0;
+}
+
+memdl_handle_t memdl_manager_pin(memdl_manager_t *mgr, const char *name) {
+    if (!mgr || !name) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
         return NULL;
     }
-    void *sym = dlsym(handle, symbol);
-    if (!sym) {
-        memdl_set_error(dlerror());
+    pthread_mutex_lock(&mgr->lock);
+    memdl_plugin_t *p = memdl_manager_find(mgr, name);
+    if (!p) {
+        pthread_mutex_unlock(&mgr->lock);
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Plugin not added: %s", name);
+        return NULL;
     }
-    return sym;
+    while (p->loading) {
+        pthread_cond_wait(&mgr->loaded, &mgr->lock);
+    }
+    if (p->handle) {
+        if (p->pins++ == 0) {
+            memdl_lru_unlink(mgr, p);
+        }
+        mgr->stats.hits++;
+        memdl_handle_t handle = p->handle;
+        pthread_mutex_unlock(&mgr->lock);
+        return handle;
+    }
+
+    // 在锁外加载，同名的其他 pin 等待结果
+    mgr->stats.misses++;
+    p->loading = 1;
+    pthread_mutex_unlock(&mgr->lock);
+    memdl_handle_t handle = memdl_open(p->data, p->size, mgr->flags);
+    size_t bytes = 0;
+    if (handle) {
+        // 直接累加记录的段长度，memdl_get_segments 还要读 /proc/self/smaps
+        const memdl_lib_t *lib = handle;
+        for (size_t i = 0; i < lib->segment_count; i++) bytes += lib->segments[i].size;
+        if (bytes == 0) bytes = p->size;
+    }
+
+    pthread_mutex_lock(&mgr->lock);
+    p->loading = 0;
+    if (handle) {
+        p->handle = handle;
+        p->bytes = bytes;
+        p->pins++;
+        mgr->stats.resident_bytes += bytes;
+        mgr->stats.resident++;
+    }
+    pthread_cond_broadcast(&mgr->loaded);
+    pthread_mutex_unlock(&mgr->lock);
+    if (handle) {
+        memdl_manager_evict(mgr);
+    }
+    return handle;
 }
 
-int memdl_close(memdl_handle_t handle) {
-    if (!handle) {
-        memdl_set_error("Invalid handle");
+int memdl_manager_unpin(memdl_manager_t *mgr, const char *name) {
+    if (!mgr || !name) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
         return -1;
     }
-    int result = dlclose(handle);
-    if (result != 0) {
-        memdl_set_error(dlerror());
+    pthread_mutex_lock(&mgr->lock);
+    memdl_plugin_t *p = memdl_manager_find(mgr, name);
+    if (!p || p->pins == 0) {
+        pthread_mutex_unlock(&mgr->lock);
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Plugin is not pinned: %s", name);
+        return -1;
     }
-    return result;
+    if (--p->pins == 0) {
+        memdl_lru_push(mgr, p);
+    }
+    pthread_mutex_unlock(&mgr->lock);
+    memdl_manager_evict(mgr);
+    return 0;
 }
 
-#elif defined(MEMDL_LINUX)
+int memdl_manager_remove(memdl_manager_t *mgr, const char *name) {
+    if (!mgr || !name) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
+        return -1;
+    }
+    pthread_mutex_lock(&mgr->lock);
+    memdl_plugin_t **pp = &mgr->buckets[memdl_gnu_hash(name) & (mgr->bucket_count - 1)];
+    while (*pp && strcmp((*pp)->name, name) != 0) pp = &(*pp)->next;
+    memdl_plugin_t *p = *pp;
+    if (!p || p->pins > 0 || p->loading) {
+        pthread_mutex_unlock(&mgr->lock);
+        memdl_set_error_code(p ? MEMDL_ERR_FAILED : MEMDL_ERR_INVALID_ARG, 0,
+                             p ? "Plugin is in use: %s" : "Plugin not added: %s", name);
+        return -1;
+    }
+    *pp = p->next;
+    if (p->handle) {
+        memdl_lru_unlink(mgr, p);
+        mgr->stats.resident_bytes -= p->bytes;
+        mgr->stats.resident--;
+    }
+    mgr->stats.entries--;
+    pthread_mutex_unlock(&mgr->lock);
+    const int result = p->handle ? memdl_close(p->handle) : 0;
+    free(p->name);
+    free(p);
+    return result;
+}
 
-memdl_handle_t memdl_open_file(const char *filename, const int flags) {
-    int dl_flags = (flags & MEMDL_NOW) ? RTLD_NOW : RTLD_LAZY;
-    dl_flags |= (flags & MEMDL_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
-    return dlopen(filename, dl_flags);
+void memdl_manager_set_budget(memdl_manager_t *mgr, const size_t budget) {
+    if (!mgr) {
+        return;
+    }
+    pthread_mutex_lock(&mgr->lock);
+    mgr->budget = budget;
+    pthread_mutex_unlock(&mgr->lock);
+    memdl_manager_evict(mgr);
 }
 
-memdl_handle_t memdl_open(const void *so_data, const size_t so_size, const int flags) {
-    if (memdl_validate(so_data, so_size) != 0) {
-        return NULL;
+void memdl_manager_stats(memdl_manager_t *mgr, memdl_manager_stats_t *stats) {
+    if (!mgr || !stats) {
+        return;
     }
+    pthread_mutex_lock(&mgr->lock);
+    *stats = mgr->stats;
+    pthread_mutex_unlock(&mgr->lock);
+}
 
-    int dl_flags = (flags & MEMDL_NOW) ? RTLD_NOW : RTLD_LAZY;
-    dl_flags |= (flags & MEMDL_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
+// 调用者保证没有线程仍在使用管理器，仍被 pin 的句柄一并关闭
+void memdl_manager_destroy(memdl_manager_t *mgr) {
+    if (!mgr) {
+        return;
+    }
+    for (size_t b = 0; b < mgr->bucket_count; b++) {
+        for (memdl_plugin_t *p = mgr->buckets[b], *next; p; p = next) {
+            next = p->next;
+            if (p->handle) memdl_close(p->handle);
+            free(p->name);
+            free(p);
+        }
+    }
+    free(mgr->buckets);
+    pthread_cond_destroy(&mgr->loaded);
+    pthread_mutex_destroy(&mgr->lock);
+    free(mgr);
+}
 
-    // Linux 使用memfd方案
-    // 定义MFD_CLOEXEC常量（如果系统头文件没有定义）
-#ifndef MFD_CLOEXEC
-#define MFD_CLOEXEC 0x0001U
 #endif
 
-    int fd = (int) syscall(SYS_memfd_create, "memdl_lib", MFD_CLOEXEC);
-    if (fd >= 0) {
-        const ssize_t written = write(fd, so_data, so_size);
-        if (written == (ssize_t) so_size) {
-            lseek(fd, 0, SEEK_SET);
+// 句柄缓存与零拷贝接口仅在 Linux 上实现
+#if !defined(MEMDL_LINUX)
+void memdl_cache_stats(memdl_cache_stats_t *stats) {
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
 
-            char fd_path[64];
-            snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", fd);
-            void *handle = dlopen(fd_path, dl_flags);
-            close(fd);
+memdl_handle_t memdl_open_fd(int fd, int flags) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return NULL;
+}
 
-            if (handle) return handle;
-        } else {
-            close(fd);
-        }
+int memdl_export_fd(const void *so_data, size_t so_size) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+int memdl_send_fd(int socket, int fd) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+int memdl_recv_fd(int socket) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+void *memdl_buffer_alloc(size_t size) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return NULL;
+}
+
+size_t memdl_sym_many(memdl_handle_t handle, const char *const *symbols, void **addrs, size_t count) {
+    size_t resolved = 0;
+    for (size_t i = 0; i < count; i++) {
+        addrs[i] = memdl_sym(handle, symbols[i]);
+        if (addrs[i]) resolved++;
     }
+    return resolved;
+}
 
-    // 降级方案：临时文件
-    char template[] = "/tmp/memdl_tmp";
-    fd = mkstemp(template);
-    if (fd >= 0) {
-        if (write(fd, so_data, so_size) == (ssize_t) so_size) {
-            void *handle = dlopen(template, dl_flags);
-            unlink(template);
-            close(fd);
+void memdl_buffer_free(void *buffer) {
+}
 
-            if (!handle) {
-                memdl_set_error(dlerror());
+memdl_handle_t memdl_open_verified(const void *so_data, size_t so_size, int flags, uint64_t digest) {
+    if (memdl_digest(so_data, so_size) != digest) {
+        memdl_set_error_code(MEMDL_ERR_INTEGRITY, 0, "Image digest mismatch");
+        return NULL;
+    }
+    return memdl_open(so_data, so_size, flags);
+}
+
+memdl_handle_t memdl_image_open(const memdl_image_t *image, int flags) {
+    if (!image) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid image");
+        return NULL;
+    }
+    return memdl_open(image->data, image->size, flags);
+}
+
+// 没有 memfd 时读入堆缓冲区后加载
+memdl_handle_t memdl_open_stream(memdl_read_fn read_fn, void *ctx, size_t size_hint, int flags) {
+    if (!read_fn) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid read callback");
+        return NULL;
+    }
+    size_t capacity = size_hint ? size_hint : 1u << 20, size = 0;
+    unsigned char *data = malloc(capacity);
+    for (;;) {
+        if (data && size == capacity) {
+            unsigned char *grown = realloc(data, capacity * 2);
+            if (!grown) {
+                free(data);
+                data = NULL;
+            } else {
+                data = grown;
+                capacity *= 2;
             }
-            return handle;
         }
-        close(fd);
-        unlink(template);
+        if (!data) {
+            memdl_set_error_code(MEMDL_ERR_NOMEM, ENOMEM, "Out of memory");
+            return NULL;
+        }
+        const ptrdiff_t n = read_fn(ctx, data + size, capacity - size);
+        if (n < 0 || (size_t) n > capacity - size) {
+            free(data);
+            memdl_set_error_code(MEMDL_ERR_FAILED, 0, "Stream read failed");
+            return NULL;
+        }
+        if (n == 0) break;
+        size += (size_t) n;
     }
+    memdl_handle_t handle = memdl_open(data, size, flags);
+    free(data);
+    return handle;
+}
+
+void memdl_set_threads(unsigned threads) {
+}
+
+void memdl_set_instrumentation(int enabled) {
+}
+
+void memdl_set_perf_map(int enabled) {
+}
+
+int memdl_set_strategy(const int *order, size_t count) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+int memdl_get_caps(memdl_caps_t *caps) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+void memdl_set_trace_hook(memdl_trace_fn hook, void *user) {
+}
+
+int memdl_get_load_info(memdl_handle_t handle, memdl_load_info_t *info) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+int memdl_get_page_info(memdl_handle_t handle, memdl_page_info_t *info) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+size_t memdl_get_segments(memdl_handle_t handle, memdl_segment_t *segments, size_t max) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return 0;
+}
+
+int memdl_warm(memdl_handle_t handle) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
 
-    memdl_set_error("All loading methods failed");
+memdl_swap_t *memdl_swap_open(const void *so_data, size_t so_size, int flags, const char *const *symbols, size_t count) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
     return NULL;
 }
 
-void *memdl_sym(memdl_handle_t handle, const char *symbol) {
-    if (!handle) {
-        memdl_set_error("Invalid handle");
-        return NULL;
+void memdl_swap_enter(memdl_swap_t *swap, memdl_swap_view_t *view) {
+    memset(view, 0, sizeof(*view));
+}
+
+void memdl_swap_leave(memdl_swap_t *swap, const memdl_swap_view_t *view) {
+}
+
+int memdl_replace(memdl_swap_t *swap, const void *so_data, size_t so_size) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+uint64_t memdl_swap_version(memdl_swap_t *swap) {
+    return 0;
+}
+
+int memdl_swap_close(memdl_swap_t *swap) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+memdl_manager_t *memdl_manager_create(size_t budget, int flags) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return NULL;
+}
+
+int memdl_manager_add(memdl_manager_t *mgr, const char *name, const void *so_data, size_t so_size) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+memdl_handle_t memdl_manager_pin(memdl_manager_t *mgr, const char *name) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return NULL;
+}
+
+int memdl_manager_unpin(memdl_manager_t *mgr, const char *name) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+int memdl_manager_remove(memdl_manager_t *mgr, const char *name) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "Not supported on this platform");
+    return -1;
+}
+
+void memdl_manager_set_budget(memdl_manager_t *mgr, size_t budget) {
+}
+
+void memdl_manager_stats(memdl_manager_t *mgr, memdl_manager_stats_t *stats) {
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
     }
-    void *sym = dlsym(handle, symbol);
-    if (!sym) {
-        memdl_set_error(dlerror());
+}
+
+void memdl_manager_destroy(memdl_manager_t *mgr) {
+}
+
+void memdl_get_stats(memdl_stats_t *stats) {
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
     }
-    return sym;
 }
 
-int memdl_close(memdl_handle_t handle) {
-    if (!handle) {
-        memdl_set_error("Invalid handle");
+int memdl_register(const char *name, const void *so_data, size_t so_size) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "In-memory dependencies are not supported on this platform");
+    return -1;
+}
+
+int memdl_unregister(const char *name) {
+    memdl_set_error_code(MEMDL_ERR_UNSUPPORTED, 0, "In-memory dependencies are not supported on this platform");
+    return -1;
+}
+
+unsigned memdl_get_threads(void) {
+    return 1;
+}
+
+size_t memdl_open_many(const memdl_source_t *images, size_t count, int flags,
+                       memdl_open_result_t *results, memdl_batch_info_t *info) {
+    size_t loaded = 0;
+    for (size_t i = 0; i < count; i++) {
+        memset(&results[i], 0, sizeof(results[i]));
+        results[i].handle = memdl_open(images[i].data, images[i].size, flags);
+        if (results[i].handle) {
+            loaded++;
+        } else {
+            memdl_last_error(&results[i].error);
+        }
+    }
+    if (info) {
+        memset(info, 0, sizeof(*info));
+        info->loaded = loaded;
+        info->failed = count - loaded;
+        info->threads = 1;
+    }
+    return loaded;
+}
+
+struct memdl_ticket {
+    memdl_handle_t handle;
+    memdl_error_info_t error;
+    int taken;
+};
+
+memdl_ticket_t *memdl_open_async(const void *so_data, size_t so_size, int flags) {
+    memdl_ticket_t *ticket = calloc(1, sizeof(memdl_ticket_t));
+    if (!ticket) {
+        memdl_set_error_code(MEMDL_ERR_NOMEM, 0, "Out of memory");
+        return NULL;
+    }
+    ticket->handle = memdl_open(so_data, so_size, flags);
+    memdl_last_error(&ticket->error);
+    return ticket;
+}
+
+int memdl_ticket_poll(memdl_ticket_t *ticket) {
+    return 1;
+}
+
+int memdl_ticket_wait(memdl_ticket_t *ticket, long timeout_ms) {
+    return 0;
+}
+
+int memdl_ticket_then(memdl_ticket_t *ticket, memdl_ticket_callback_t callback, void *user) {
+    if (!ticket || !callback) {
+        memdl_set_error_code(MEMDL_ERR_INVALID_ARG, 0, "Invalid argument");
         return -1;
     }
-    const int result = dlclose(handle);
-    if (result != 0) {
-        memdl_set_error(dlerror());
+    callback(ticket, user);
+    return 0;
+}
+
+memdl_handle_t memdl_ticket_result(memdl_ticket_t *ticket) {
+    ticket->taken = 1;
+    if (!ticket->handle) {
+        memdl_last_error_info = ticket->error;
     }
-    return result;
+    return ticket->handle;
 }
 
+void memdl_ticket_free(memdl_ticket_t *ticket) {
+    if (ticket && ticket->handle && !ticket->taken) {
+        memdl_close(ticket->handle);
+    }
+    free(ticket);
+}
 #endif
 
 // 公共API实现
 const char *memdl_error(void) {
-    return memdl_error_msg[0] ? memdl_error_msg : "No error";
+    return memdl_last_error_info.message[0] ? memdl_last_error_info.message : "No error";
+}
+
+int memdl_last_error(memdl_error_info_t *info) {
+    if (info) {
+        *info = memdl_last_error_info;
+    }
+    return memdl_last_error_info.code;
+}
+
+void memdl_clear_error(void) {
+    memset(&memdl_last_error_info, 0, sizeof(memdl_last_error_info));
 }
@@ -32,6 +32,7 @@
 #define MEMDL_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -52,25 +53,385 @@ extern "C" {
 #define MEMDL_ARCH_ARM           3
 #define MEMDL_ARCH_ARM64         4
 
+// 镜像格式
+#define MEMDL_FORMAT_UNKNOWN     0
+#define MEMDL_FORMAT_ELF         1
+#define MEMDL_FORMAT_MACHO       2
+#define MEMDL_FORMAT_PE          3
+
+// 导出符号类型（与 ELF STT_* 取值相同）
+#define MEMDL_SYMBOL_NOTYPE      0
+#define MEMDL_SYMBOL_OBJECT      1
+#define MEMDL_SYMBOL_FUNC        2
+#define MEMDL_SYMBOL_TLS         6
+#define MEMDL_SYMBOL_IFUNC       10
+
 // 标志定义
 #define MEMDL_NOW    0x1     // 立即解析符号
 #define MEMDL_LAZY   0x2     // 延迟解析符号
 #define MEMDL_LOCAL  0x4     // 局部符号
 #define MEMDL_GLOBAL 0x8     // 全局符号
+#define MEMDL_NOCACHE 0x10   // 不使用句柄缓存，总是重新加载
+#define MEMDL_NATIVE 0x20    // 使用内置 ELF 加载器（不依赖 memfd、/proc 和 dlopen，仅 Linux x86_64/aarch64）
+#define MEMDL_TMPFILE 0x40   // 跳过 memfd，直接使用临时文件降级路径（基准测试与排查用）
+#define MEMDL_ONDEMAND 0x80  // 按需调页：隐含 MEMDL_NATIVE 与 MEMDL_NOCACHE，段内容在首次访问时才复制或解压（仅 Linux）
+#define MEMDL_HUGEPAGES 0x100 // 加载后把可执行段中 2MB 对齐的部分换成透明大页，失败时保留原映射（仅 Linux）
+#define MEMDL_PREFAULT 0x200  // 返回句柄前预取所有段的页面（同 memdl_warm，仅 Linux）
+#define MEMDL_INSTANCE 0x400  // 独立实例：隐含 MEMDL_NOCACHE，经 dlmopen 装入池中的其他链接命名空间，全局状态互不影响（仅 Linux）
+
+// 错误码
+#define MEMDL_OK                 0
+#define MEMDL_ERR_FAILED         1   // 一般性失败
+#define MEMDL_ERR_INVALID_ARG    2   // 参数无效
+#define MEMDL_ERR_FORMAT         3   // 镜像格式错误
+#define MEMDL_ERR_NOMEM          4   // 内存不足
+#define MEMDL_ERR_SYSTEM         5   // 系统调用失败（见 sys_errno）
+#define MEMDL_ERR_LOADER         6   // 动态链接器失败（message 为 dlerror 文本）
+#define MEMDL_ERR_SYMBOL         7   // 符号未找到
+#define MEMDL_ERR_UNSUPPORTED    8   // 平台或镜像特性不支持
+#define MEMDL_ERR_TIMEOUT        9   // 等待异步加载超时
+#define MEMDL_ERR_INTEGRITY     10   // 镜像摘要与期望值不一致
+
+// 出错阶段
+#define MEMDL_STAGE_NONE         0
+#define MEMDL_STAGE_VALIDATE     1   // 格式校验
+#define MEMDL_STAGE_PREPARE      2   // 创建 memfd/临时文件并写入镜像
+#define MEMDL_STAGE_LINK         3   // dlopen 或原生加载器的映射与重定位
+#define MEMDL_STAGE_SYMBOL       4   // 符号查找
+#define MEMDL_STAGE_CLOSE        5   // 卸载
 
 typedef void* memdl_handle_t;
 
+// 预解析的镜像描述符（不透明），不复制镜像数据
+typedef struct memdl_image memdl_image_t;
+
+// 镜像描述符信息
+typedef struct {
+    int format;             // MEMDL_FORMAT_*
+    int arch;               // MEMDL_ARCH_*
+    int bits;               // 32 / 64
+    int big_endian;
+    int machine;            // 原始机器码：ELF e_machine / Mach-O cputype / PE Machine
+    int type;               // ELF e_type / Mach-O filetype / PE Characteristics
+    size_t segments;        // ELF PT_LOAD 个数
+    size_t needed;          // ELF DT_NEEDED 个数
+    const char* soname;     // ELF DT_SONAME，指向镜像内部，没有时为 NULL
+} memdl_image_info_t;
+
+// 镜像导出的符号，字符串均指向镜像内部
+typedef struct {
+    const char* name;
+    const char* version;    // DT_VERDEF 中的版本名，没有时为 NULL
+    uint64_t value;         // 相对加载基址的偏移
+    uint64_t size;
+    int type;               // MEMDL_SYMBOL_*
+    int binding;            // ELF STB_*
+    int default_version;    // 默认版本（name@@VER）或无版本时为 1
+} memdl_export_t;
+
+// 结构化错误信息，每个线程独立保存最近一次错误
+typedef struct {
+    int code;           // MEMDL_ERR_*
+    int stage;          // MEMDL_STAGE_*
+    int sys_errno;      // 系统调用失败时的 errno，否则为 0
+    char message[256];  // 可读的错误描述
+} memdl_error_info_t;
+
+// 批量加载的输入镜像
+typedef struct {
+    const void* data;
+    size_t size;
+} memdl_source_t;
+
+// 批量加载中单个镜像的结果
+typedef struct {
+    memdl_handle_t handle;      // 失败时为 NULL
+    memdl_error_info_t error;   // 失败原因
+    uint64_t prepare_ns;        // 校验与填充 memfd 的耗时（并行阶段）
+    uint64_t link_ns;           // 链接耗时（串行阶段）
+} memdl_open_result_t;
+
+// 批量加载汇总
+typedef struct {
+    size_t loaded;
+    size_t failed;
+    unsigned threads;           // 参与准备阶段的线程数
+    uint64_t wall_ns;           // 总耗时
+} memdl_batch_info_t;
+
+// 异步加载票据（不透明）
+typedef struct memdl_ticket memdl_ticket_t;
+// 完成回调，在加载线程上执行（已完成时在注册线程上立即执行）
+typedef void (*memdl_ticket_callback_t)(memdl_ticket_t* ticket, void* user);
+
+// 加载策略
+#define MEMDL_STRATEGY_NONE      0
+#define MEMDL_STRATEGY_MEMFD     1   // 复制到 memfd 后 dlopen
+#define MEMDL_STRATEGY_TMPFILE   2   // 临时文件降级路径
+#define MEMDL_STRATEGY_NATIVE    3   // 内置 ELF 加载器
+#define MEMDL_STRATEGY_BUFFER    4   // memdl_buffer_alloc 零拷贝缓冲区
+#define MEMDL_STRATEGY_FD        5   // 调用者提供的已封印 memfd
+#define MEMDL_STRATEGY_FILE      6   // memdl_open_file
+#define MEMDL_STRATEGY_COUNT     7
+
+// 镜像落地方式（dlopen 路径上镜像写到哪里），memdl_set_strategy 的参数
+#define MEMDL_BACKING_MEMFD      1   // memfd_create
+#define MEMDL_BACKING_TMPFILE    2   // tmpfs 上的 O_TMPFILE 匿名文件，经 /proc/self/fd 加载
+#define MEMDL_BACKING_SHM        3   // /dev/shm 中的临时文件，不需要 /proc
+#define MEMDL_BACKING_DISK       4   // /tmp 中的临时文件，可能落盘，总是最后尝试
+#define MEMDL_BACKING_COUNT      5
+
+// 首次加载时探测一次的运行环境能力
+#define MEMDL_CAP_MEMFD              0x01
+#define MEMDL_CAP_MEMFD_EXEC         0x02   // 支持 MFD_EXEC（vm.memfd_noexec 开启时须显式请求可执行）
+#define MEMDL_CAP_MEMFD_NOEXEC_SEAL  0x04   // 支持 MFD_NOEXEC_SEAL
+#define MEMDL_CAP_O_TMPFILE          0x08   // 某个 tmpfs 目录支持 O_TMPFILE
+#define MEMDL_CAP_DEV_SHM            0x10   // /dev/shm 是允许执行映射的 tmpfs
+#define MEMDL_CAP_PROC_FD            0x20   // 可经 /proc/self/fd 打开描述符
+
+typedef struct {
+    unsigned caps;                           // MEMDL_CAP_*
+    uint64_t probe_ns[MEMDL_BACKING_COUNT];  // 探测时创建、写入并可执行映射一页的耗时，0 表示不可用或未测量
+    int order[MEMDL_BACKING_COUNT];          // 当前的尝试顺序，以 0 结尾
+} memdl_caps_t;
+
+// 加载阶段（stage_ns 的下标，也是跟踪回调的事件类型）
+#define MEMDL_TRACE_VALIDATE     0   // 格式校验
+#define MEMDL_TRACE_HASH         1   // 内容哈希（缓存键）
+#define MEMDL_TRACE_CREATE       2   // memfd_create / mkstemp
+#define MEMDL_TRACE_COPY         3   // 写入 memfd 或临时文件、原生加载器复制段
+#define MEMDL_TRACE_SEAL         4   // 封印 memfd
+#define MEMDL_TRACE_DEPS         5   // 加载注册表中的依赖
+#define MEMDL_TRACE_LINK         6   // dlopen（含符号解析和构造函数）或原生加载器的映射与重定位
+#define MEMDL_TRACE_INIT         7   // 构造函数（仅原生加载器单独计时）
+#define MEMDL_TRACE_INDEX        8   // 构建导出符号索引
+#define MEMDL_TRACE_STAGES       9
+#define MEMDL_TRACE_LOAD         9   // 一次加载结束（仅回调，耗时为总耗时）
+
+// 单次加载的记录；计时仅在开启统计或设置跟踪回调时采集，其余字段总是记录
+typedef struct {
+    int strategy;                           // MEMDL_STRATEGY_*
+    uint64_t stage_ns[MEMDL_TRACE_STAGES];  // 各阶段耗时
+    uint64_t total_ns;
+    uint64_t bytes_copied;                  // 加载过程中复制的字节数
+} memdl_load_info_t;
+
+// 进程级累计统计
+typedef struct {
+    uint64_t loads;                         // 实际加载次数（不含缓存命中）
+    uint64_t failures;
+    uint64_t cache_hits;
+    uint64_t bytes_copied;
+    uint64_t strategy[MEMDL_STRATEGY_COUNT];
+    uint64_t stage_ns[MEMDL_TRACE_STAGES];
+    uint64_t total_ns;
+} memdl_stats_t;
+
+// 跟踪回调：每个阶段结束时调用一次，最后以 MEMDL_TRACE_LOAD 结束；info 为正在记录的加载，可能为 NULL
+typedef void (*memdl_trace_fn)(int event, uint64_t elapsed_ns, const memdl_load_info_t* info, void* user);
+
+// 原生加载镜像的页面驻留情况
+typedef struct {
+    size_t pages;           // 段映射的总页数
+    size_t faulted;         // 已调入的页数；非按需调页的镜像等于 pages
+    size_t source_pages;    // 压缩镜像的按需解压视图中已解码的页数
+    uint64_t fault_ns;      // 处理缺页的累计耗时
+} memdl_page_info_t;
+
+// 已映射的 PT_LOAD 段
+typedef struct {
+    void* addr;             // 段起始地址（页对齐）
+    size_t size;            // 映射长度（页对齐）
+    int flags;              // ELF p_flags：PF_X=1、PF_W=2、PF_R=4
+    size_t huge_bytes;      // 当前由大页支持的字节数
+} memdl_segment_t;
+
+// 句柄缓存统计
+typedef struct {
+    uint64_t hits;      // 命中次数（复用已加载镜像）
+    uint64_t misses;    // 未命中次数（实际加载）
+    size_t entries;     // 当前缓存的镜像数
+} memdl_cache_stats_t;
+
 // 核心API
 memdl_handle_t memdl_open_file(const char* filename, int flags);
 memdl_handle_t memdl_open(const void* so_data, size_t so_size, int flags);
 void* memdl_sym(memdl_handle_t handle, const char* symbol);
 int memdl_close(memdl_handle_t handle);
 const char* memdl_error(void);
+// 获取当前线程最近一次错误，返回错误码
+int memdl_last_error(memdl_error_info_t* info);
+void memdl_clear_error(void);
+// 批量解析符号：addrs[i] 对应 symbols[i]，未找到的置 NULL，返回找到的个数。
+// 函数指针结构体可直接作为 addrs 传入，按成员顺序填充
+size_t memdl_sym_many(memdl_handle_t handle, const char* const* symbols, void** addrs, size_t count);
+
+// 零拷贝加载
+// 从文件描述符加载（内核内复制；已封印的 memfd 直接加载），flags 与 memdl_open 相同
+memdl_handle_t memdl_open_fd(int fd, int flags);
+// 为镜像创建已封印（F_SEAL_WRITE/SHRINK/GROW）的 memfd，LZ4 帧先解压；失败返回 -1，fd 归调用者关闭。
+// fd 经 fork 继承或 memdl_send_fd 传给其他进程后各自 memdl_open_fd，所有进程映射同一份页缓存
+int memdl_export_fd(const void* so_data, size_t so_size);
+// 经 UNIX 域套接字以 SCM_RIGHTS 传递文件描述符；memdl_recv_fd 返回收到的 fd（带 O_CLOEXEC）
+int memdl_send_fd(int socket, int fd);
+int memdl_recv_fd(int socket);
+// 分配 memfd 支持的可写缓冲区，填充后传给 memdl_open 不会再复制；加载后缓冲区变为只读
+void* memdl_buffer_alloc(size_t size);
+void memdl_buffer_free(void* buffer);
+// 流式读取回调：向 buf 写入最多 size 字节，返回写入的字节数，0 表示结束，负数表示失败
+typedef ptrdiff_t (*memdl_read_fn)(void* ctx, void* buf, size_t size);
+// 流式加载：数据块直接读入 memfd，不需要完整的堆缓冲区；文件头到齐即校验，错误输入尽早拒绝。
+// size_hint 为预计大小（0 表示未知），超出时自动扩展
+memdl_handle_t memdl_open_stream(memdl_read_fn read_fn, void* ctx, size_t size_hint, int flags);
+
+// 落地方式
+// 默认顺序由探测结果决定：可用的 tmpfs 方式按测得的耗时排序，/tmp 临时文件最后。
+// memdl_set_strategy 指定尝试顺序（未探测通过的方式返回 MEMDL_ERR_UNSUPPORTED），order 为 NULL 时恢复默认
+int memdl_set_strategy(const int* order, size_t count);
+int memdl_get_caps(memdl_caps_t* caps);
+
+// 并行批量加载
+// 校验、填充 memfd 与封印在线程池中并行执行，dlopen 按输入顺序串行；返回成功加载的个数。
+// results 与 images 一一对应，info 可为 NULL
+size_t memdl_open_many(const memdl_source_t* images, size_t count, int flags,
+                       memdl_open_result_t* results, memdl_batch_info_t* info);
+// 设置工作线程数（0 表示按 CPU 核数），已启动的线程不会退出
+void memdl_set_threads(unsigned threads);
+unsigned memdl_get_threads(void);
+
+// 内存依赖注册表
+// 注册后，被加载镜像中同名的 DT_NEEDED 从注册的镜像满足：依赖图按拓扑序加载，准备阶段并行，不访问文件系统。
+// 镜像不会被复制，注册期间 so_data 必须保持有效；非 MEMDL_NATIVE 加载要求依赖的 DT_SONAME 与注册名一致
+int memdl_register(const char* name, const void* so_data, size_t so_size);
+int memdl_unregister(const char* name);
+
+// 异步加载
+// 在工作线程上执行 memdl_open，完成前 so_data 必须保持有效；返回票据，失败时返回 NULL
+memdl_ticket_t* memdl_open_async(const void* so_data, size_t so_size, int flags);
+// 已完成返回 1，仍在加载返回 0
+int memdl_ticket_poll(memdl_ticket_t* ticket);
+// 等待完成，timeout_ms < 0 表示无限等待；超时返回 -1（MEMDL_ERR_TIMEOUT）
+int memdl_ticket_wait(memdl_ticket_t* ticket, long timeout_ms);
+// 注册完成回调，每个票据一个；回调中可调用 memdl_ticket_result
+int memdl_ticket_then(memdl_ticket_t* ticket, memdl_ticket_callback_t callback, void* user);
+// 等待完成并取得句柄（所有权转移给调用者）；失败时返回 NULL，错误写入当前线程
+memdl_handle_t memdl_ticket_result(memdl_ticket_t* ticket);
+// 释放票据；加载仍在进行时于完成后回收，未取走的句柄会被关闭
+void memdl_ticket_free(memdl_ticket_t* ticket);
+
+// 热替换
+// 可热替换的句柄（不透明）
+typedef struct memdl_swap memdl_swap_t;
+// 读侧视图：memdl_swap_enter 填充，原样交给 memdl_swap_leave
+typedef struct {
+    void* const* syms;      // 当前版本的符号地址，与 memdl_swap_open 的 symbols 一一对应
+    uint64_t version;       // 版本号：首次加载为 1，每次替换加 1
+    unsigned slot;          // 内部使用
+} memdl_swap_view_t;
+// 读者在 memdl_swap_enter/memdl_swap_leave 之间经 view.syms 调用，读侧不加锁，只有两次原子加减；
+// memdl_replace 加载新镜像并解析全部符号（缺少任何一个则失败，旧版本不变），原子发布新符号表，
+// 等所有在发布前进入的读者离开后才关闭旧镜像，因此会阻塞到这些读者离开为止，不能在读侧临界区内调用。
+// 关闭前调用者需保证没有读者
+memdl_swap_t* memdl_swap_open(const void* so_data, size_t so_size, int flags, const char* const* symbols, size_t count);
+void memdl_swap_enter(memdl_swap_t* swap, memdl_swap_view_t* view);
+void memdl_swap_leave(memdl_swap_t* swap, const memdl_swap_view_t* view);
+int memdl_replace(memdl_swap_t* swap, const void* so_data, size_t so_size);
+uint64_t memdl_swap_version(memdl_swap_t* swap);
+int memdl_swap_close(memdl_swap_t* swap);
+
+// 插件管理器
+// 管理器句柄（不透明）
+typedef struct memdl_manager memdl_manager_t;
+// memdl_manager_stats 的输出
+typedef struct {
+    size_t entries;         // 已登记的插件数
+    size_t resident;        // 当前常驻的插件数
+    size_t resident_bytes;  // 常驻插件映射的段字节数之和
+    uint64_t hits;          // pin 时已常驻
+    uint64_t misses;        // pin 时需要（重新）加载
+    uint64_t evictions;     // 因超出预算被关闭的次数
+} memdl_manager_stats_t;
+// memdl_manager_add 登记来源（不复制，登记期间 so_data 必须保持有效）；memdl_manager_pin 在需要时加载并返回句柄，
+// 句柄在对应的 memdl_manager_unpin 之前保持有效。常驻字节超过 budget 时按最近最少使用关闭未被 pin 的插件，
+// 下次 pin 时从来源重新加载；被 pin 的插件不会淘汰，因此常驻字节可能暂时超出预算。加载总是附加 MEMDL_NOCACHE
+memdl_manager_t* memdl_manager_create(size_t budget, int flags);
+int memdl_manager_add(memdl_manager_t* mgr, const char* name, const void* so_data, size_t so_size);
+memdl_handle_t memdl_manager_pin(memdl_manager_t* mgr, const char* name);
+int memdl_manager_unpin(memdl_manager_t* mgr, const char* name);
+// 移除未被 pin 的插件，常驻时一并关闭
+int memdl_manager_remove(memdl_manager_t* mgr, const char* name);
+void memdl_manager_set_budget(memdl_manager_t* mgr, size_t budget);
+void memdl_manager_stats(memdl_manager_t* mgr, memdl_manager_stats_t* stats);
+void memdl_manager_destroy(memdl_manager_t* mgr);
+
+// 加载统计与跟踪
+// 开启后记录各阶段耗时；关闭时只多一次原子读
+void memdl_set_instrumentation(int enabled);
+// 设置跟踪回调（NULL 取消），设置后同样采集计时；回调在加载线程上执行
+void memdl_set_trace_hook(memdl_trace_fn hook, void* user);
+// perf 符号表：开启后，之后实际加载的镜像把函数符号（有 .symtab 时含局部符号，否则为 .dynsym）追加到
+// /tmp/perf-<pid>.map，关闭句柄时删去对应条目，perf 据此解析内存加载代码中的采样地址（仅 Linux）
+void memdl_set_perf_map(int enabled);
+int memdl_get_load_info(memdl_handle_t handle, memdl_load_info_t* info);
+// 按需调页（MEMDL_ONDEMAND）：段映射登记到 userfaultfd，由后台线程在首次访问时填充页面；
+// LZ4 帧同样按块解压，只解码被访问到的块。源数据（memdl_open 的缓冲区、描述符或打包文件）在句柄关闭前必须保持有效。
+// 内核不支持 userfaultfd 时退回立即复制。只对原生加载的句柄可用
+int memdl_get_page_info(memdl_handle_t handle, memdl_page_info_t* info);
+// 列出句柄的 PT_LOAD 段，返回段总数，最多写入 max 个；huge_bytes 读自 /proc/self/smaps。
+// MEMDL_HUGEPAGES 只作用于实际加载（缓存命中沿用已有映射），按需调页的段不会被替换
+size_t memdl_get_segments(memdl_handle_t handle, memdl_segment_t* segments, size_t max);
+// 让句柄的所有可读段驻留内存并建好页表（MADV_POPULATE_READ，旧内核逐页读取），消除首次调用的缺页；
+// 按需调页的段会在此时全部填充。可在页面被回收后重复调用
+int memdl_warm(memdl_handle_t handle);
+void memdl_get_stats(memdl_stats_t* stats);
+
+// 预解析镜像
+// 一次解析并校验文件头、程序头和动态段，并计算内容哈希；之后可多次 memdl_image_open 而不再重复解析。
+// 描述符引用 so_data，释放描述符前数据必须保持有效
+memdl_image_t* memdl_image_prepare(const void* so_data, size_t so_size);
+int memdl_image_get_info(const memdl_image_t* image, memdl_image_info_t* info);
+memdl_handle_t memdl_image_open(const memdl_image_t* image, int flags);
+void memdl_image_release(memdl_image_t* image);
+
+// 完整性校验
+// 镜像的 XXH3-64 摘要，也是句柄缓存的键；长输入按 CPU 选用 AVX2/SSE2/NEON
+uint64_t memdl_digest(const void* so_data, size_t so_size);
+// 摘要等于 digest 时才加载，否则返回 NULL（MEMDL_ERR_INTEGRITY）。digest 通常来自已签名的清单；
+// 缓存中已有摘要、大小和加载标志都相同的镜像时直接复用，不再读取数据，否则在写入 memfd 的同一遍里计算摘要。
+// XXH3 不是密码学哈希，只能发现损坏或误替换，防篡改需由调用者校验清单签名
+memdl_handle_t memdl_open_verified(const void* so_data, size_t so_size, int flags, uint64_t digest);
+
+// 导出符号内省：直接读取镜像的 .dynsym，不映射也不执行镜像中的代码
+// memdl_image_exports 返回导出符号总数，最多写入 max 个；
+// memdl_image_find_export 经 DT_GNU_HASH/DT_HASH 查找，未导出时返回 -1
+size_t memdl_image_exports(const memdl_image_t* image, memdl_export_t* exports, size_t max);
+int memdl_image_find_export(const memdl_image_t* image, const char* name, memdl_export_t* out);
+
+// 打包文件
+// 打包文件（不透明）：多个镜像按页对齐存放，带名称索引与预计算的导出表
+typedef struct memdl_bundle memdl_bundle_t;
+// memdl_bundle_write 把镜像按 align（0 取 MEMDL_BUNDLE_ALIGN）对齐写入一个文件；
+// memdl_bundle_open 使用调用者提供的内存，memdl_bundle_open_file 整体映射文件。
+// 按名查找为 O(1)，成员数据直接指向打包内容，导出表无需解析镜像即可读取
+// memdl_bundle_load 首次加载某成员时核对索引中的内容哈希，不符返回 NULL（MEMDL_ERR_INTEGRITY）
+#define MEMDL_BUNDLE_ALIGN 65536
+int memdl_bundle_write(const char* path, const char* const* names, const memdl_source_t* images, size_t count,
+                       size_t align);
+memdl_bundle_t* memdl_bundle_open(const void* data, size_t size);
+memdl_bundle_t* memdl_bundle_open_file(const char* path);
+size_t memdl_bundle_count(const memdl_bundle_t* bundle);
+const char* memdl_bundle_name(const memdl_bundle_t* bundle, size_t index);
+int memdl_bundle_find(const memdl_bundle_t* bundle, const char* name, memdl_source_t* image);
+size_t memdl_bundle_exports(const memdl_bundle_t* bundle, const char* name, memdl_export_t* exports, size_t max);
+memdl_handle_t memdl_bundle_load(const memdl_bundle_t* bundle, const char* name, int flags);
+void memdl_bundle_close(memdl_bundle_t* bundle);
 
 // 高级功能
+// 按文件头中的机器类型识别架构（ELF e_machine、Mach-O cputype、PE Machine）
 int memdl_get_arch(const void* so_data, size_t so_size);
 int memdl_validate(const void* so_data, size_t so_size);
 int memdl_get_platform(void);
+void memdl_cache_stats(memdl_cache_stats_t* stats);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,1223 @@
+/*******************************************************************************
+ * File: memdl_bench.c
+ * Project: memdl
+ * Created: 2025/11/7
+ * Author: eternalfuture-e38299
+ * Github: https://github.com/eternalfuture-e38299
+ *
+ * MIT License
+ *
+ * Copyright (c) 2025 EternalFuture
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include "memdl.h"
+
+#ifdef __linux__
+#include <sys/wait.h>
+#endif
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#include <elf.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#define BENCH_SYNTHETIC 1
+#endif
+
+// libtest.c 导出的符号
+static const char* bench_names[] = {
+    "native_test", "calculate_sum", "get_message", "format_message", "calculate_area",
+    "create_point", "print_point", "test_callback", "process_array", "reverse_string",
+    "library_init", "library_cleanup", "get_version", "complex_calculation",
+    "global_counter", "increment_counter", "get_counter", "increment_thread_safe",
+};
+#define BENCH_NAME_COUNT (sizeof(bench_names) / sizeof(bench_names[0]))
+
+typedef struct {
+    int use_dlsym;
+    void* handle;
+    size_t lookups;
+    size_t found;
+    uint64_t elapsed_ns;
+    pthread_barrier_t* barrier;
+} sym_job_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    const uint64_t x = *(const uint64_t*) a, y = *(const uint64_t*) b;
+    return x < y ? -1 : x > y;
+}
+
+static void* sym_worker(void* arg) {
+    sym_job_t* job = arg;
+    size_t found = 0;
+    pthread_barrier_wait(job->barrier);
+    const uint64_t start = now_ns();
+    for (size_t i = 0; i < job->lookups; i++) {
+        const char* name = bench_names[i % BENCH_NAME_COUNT];
+        void* addr = job->use_dlsym ? dlsym(job->handle, name) : memdl_sym(job->handle, name);
+        found += addr != NULL;
+    }
+    job->elapsed_ns = now_ns() - start;
+    job->found = found;
+    return NULL;
+}
+
+// 多线程并发查找，返回每次查找的平均耗时（纳秒）
+static double run_sym(void* handle, const int use_dlsym, const int threads, const size_t lookups) {
+    pthread_t tids[64];
+    sym_job_t jobs[64];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, (unsigned) threads);
+    for (int t = 0; t < threads; t++) {
+        jobs[t] = (sym_job_t) {use_dlsym, handle, lookups, 0, 0, &barrier};
+        pthread_create(&tids[t], NULL, sym_worker, &jobs[t]);
+    }
+    uint64_t total_ns = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+        total_ns += jobs[t].elapsed_ns;
+        if (jobs[t].found != lookups) {
+            fprintf(stderr, "warning: %zu of %zu lookups failed\n", lookups - jobs[t].found, lookups);
+        }
+    }
+    pthread_barrier_destroy(&barrier);
+    return (double) total_ns / (double) (lookups * (size_t) threads);
+}
+
+static void* read_image(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = (size_t) ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void* data = malloc(*size);
+    if (!data || fread(data, 1, *size, file) != *size) {
+        free(data);
+        data = NULL;
+        fprintf(stderr, "Cannot read %s\n", path);
+    }
+    fclose(file);
+    return data;
+}
+
+static int bench_sym(const char* path, int max_threads) {
+    size_t size;
+    void* data = read_image(path, &size);
+    if (!data) {
+        return 1;
+    }
+
+    memdl_handle_t handle = memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL);
+    void* raw = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle || !raw) {
+        fprintf(stderr, "Load failed: %s\n", handle ? dlerror() : memdl_error());
+        free(data);
+        return 1;
+    }
+
+    if (max_threads > 64) max_threads = 64;
+    static const size_t counts[] = {1000, 10000};
+    printf("%-8s %-8s %-14s %-14s %s\n", "threads", "lookups", "memdl_sym(ns)", "dlsym(ns)", "speedup");
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            const double indexed = run_sym(handle, 0, threads, counts[c]);
+            const double plain = run_sym(raw, 1, threads, counts[c]);
+            printf("%-8d %-8zu %-14.1f %-14.1f %.2fx\n", threads, counts[c], indexed, plain, plain / indexed);
+        }
+    }
+
+    dlclose(raw);
+    memdl_close(handle);
+    free(data);
+    return 0;
+}
+
+#ifdef __linux__
+// ---------------------------------------------------------------------------
+// 多进程共享基准：N 个预先 fork 的工作进程加载同一镜像，比较各自 memfd 与共享 memfd 的 PSS/RSS
+// ---------------------------------------------------------------------------
+
+// 触碰 memdl memfd 映射的每一页，再从 smaps 汇总这些映射的 Pss/Rss（KB）
+static void share_measure(size_t* pss_kb, size_t* rss_kb) {
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    char line[512];
+    FILE* maps = fopen("/proc/self/maps", "r");
+    while (maps && fgets(line, sizeof(line), maps)) {
+        unsigned long lo, hi;
+        char perms[8];
+        if (sscanf(line, "%lx-%lx %7s", &lo, &hi, perms) == 3 && perms[0] == 'r' && strstr(line, "memfd:memdl")) {
+            for (unsigned long addr = lo; addr < hi; addr += page) {
+                (void) *(volatile const char*) addr;
+            }
+        }
+    }
+    if (maps) fclose(maps);
+
+    *pss_kb = *rss_kb = 0;
+    FILE* smaps = fopen("/proc/self/smaps", "r");
+    int current = 0;
+    while (smaps && fgets(line, sizeof(line), smaps)) {
+        unsigned long lo, hi;
+        size_t kb;
+        if (sscanf(line, "%lx-%lx ", &lo, &hi) == 2) {
+            current = strstr(line, "memfd:memdl") != NULL;
+        } else if (current && sscanf(line, "Pss: %zu kB", &kb) == 1) {
+            *pss_kb += kb;
+        } else if (current && sscanf(line, "Rss: %zu kB", &kb) == 1) {
+            *rss_kb += kb;
+        }
+    }
+    if (smaps) fclose(smaps);
+}
+
+static size_t meminfo_shmem_kb(void) {
+    char line[256];
+    size_t kb = 0;
+    FILE* file = fopen("/proc/meminfo", "r");
+    while (file && fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "Shmem: %zu kB", &kb) == 1) break;
+    }
+    if (file) fclose(file);
+    return kb;
+}
+
+// 工作进程：加载后报告就绪，等所有进程都加载完再测量，测量后等父进程关闭 done 再退出，保证测量时所有映射都在
+static void share_worker(const void* data, const size_t size, const int shared_fd, const int* pipes) {
+    memdl_handle_t handle = shared_fd >= 0 ? memdl_open_fd(shared_fd, MEMDL_NOW | MEMDL_LOCAL)
+                                           : memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL);
+    size_t values[2] = {0, 0};
+    char c = handle ? 1 : 0;
+    if (write(pipes[1], &c, 1) != 1 || read(pipes[2], &c, 1) != 1) _exit(1);
+    if (handle) share_measure(&values[0], &values[1]);
+    if (write(pipes[5], values, sizeof(values)) != (ssize_t) sizeof(values)) _exit(1);
+    while (read(pipes[6], &c, 1) > 0) {
+    }
+    _exit(handle ? 0 : 1);
+}
+
+// pipes: ready[0..1] go[2..3] result[4..5] done[6..7]
+static void share_case(const void* data, const size_t size, const int shared, const int workers, int* first) {
+    int pipes[8];
+    for (int i = 0; i < 8; i += 2) {
+        if (pipe(pipes + i) != 0) return;
+    }
+    const size_t shmem_before = meminfo_shmem_kb();
+    const int shared_fd = shared ? memdl_export_fd(data, size) : -1;
+    if (shared && shared_fd < 0) {
+        fprintf(stderr, "memdl_export_fd failed: %s\n", memdl_error());
+        return;
+    }
+    pid_t pids[256];
+    int started = 0;
+    for (; started < workers; started++) {
+        pids[started] = fork();
+        if (pids[started] == 0) {
+            close(pipes[0]);
+            close(pipes[3]);
+            close(pipes[4]);
+            close(pipes[7]);
+            share_worker(data, size, shared_fd, pipes);
+        }
+        if (pids[started] < 0) break;
+    }
+    close(pipes[1]);
+    close(pipes[2]);
+    close(pipes[5]);
+    close(pipes[6]);
+
+    int loaded = 0;
+    char c;
+    for (int i = 0; i < started && read(pipes[0], &c, 1) == 1; i++) loaded += c;
+    const size_t shmem_after = meminfo_shmem_kb();
+    for (int i = 0; i < started; i++) {
+        if (write(pipes[3], "g", 1) != 1) break;
+    }
+    size_t pss = 0, rss = 0, values[2];
+    for (int i = 0; i < started && read(pipes[4], values, sizeof(values)) == (ssize_t) sizeof(values); i++) {
+        pss += values[0];
+        rss += values[1];
+    }
+    close(pipes[7]);
+    for (int i = 0; i < started; i++) waitpid(pids[i], NULL, 0);
+    close(pipes[0]);
+    close(pipes[3]);
+    close(pipes[4]);
+    if (shared_fd >= 0) close(shared_fd);
+
+    printf("%s    {\"mode\": \"%s\", \"workers\": %d, \"loaded\": %d, \"pss_kb\": %zu, \"rss_kb\": %zu, "
+           "\"pss_kb_per_worker\": %.1f, \"shmem_kb\": %lld}",
+           *first ? "" : ",\n", shared ? "shared" : "private", started, loaded, pss, rss,
+           started ? (double) pss / started : 0.0, (long long) shmem_after - (long long) shmem_before);
+    fflush(stdout);
+    *first = 0;
+}
+
+static int bench_share(const char* path, const char* list) {
+    size_t size;
+    void* data = read_image(path, &size);
+    if (!data) {
+        return 1;
+    }
+    int first = 1;
+    printf("[\n");
+    for (const char* p = list; *p;) {
+        char* end;
+        long workers = strtol(p, &end, 10);
+        if (end == p) break;
+        if (workers > 256) workers = 256;
+        if (workers > 0) {
+            share_case(data, size, 0, (int) workers, &first);
+            share_case(data, size, 1, (int) workers, &first);
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    printf("\n]\n");
+    free(data);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 多实例基准：同一进程内装入 N 份互相独立的库，比较创建耗时和每个实例新增的内存
+// ---------------------------------------------------------------------------
+
+static void rollup_measure(size_t* pss_kb, size_t* rss_kb) {
+    char line[256];
+    size_t kb;
+    *pss_kb = *rss_kb = 0;
+    FILE* file = fopen("/proc/self/smaps_rollup", "r");
+    while (file && fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "Pss: %zu kB", &kb) == 1) {
+            *pss_kb = kb;
+        } else if (sscanf(line, "Rss: %zu kB", &kb) == 1) {
+            *rss_kb = kb;
+        }
+    }
+    if (file) fclose(file);
+}
+
+static void instances_case(const void* data, const size_t size, const char* name, const int flags, const int count,
+                           int* first) {
+    memdl_handle_t handles[64];
+    uint64_t times[64];
+    size_t pss_before, rss_before, pss_after, rss_after;
+    rollup_measure(&pss_before, &rss_before);
+    const size_t shmem_before = meminfo_shmem_kb();
+    int opened = 0;
+    for (; opened < count; opened++) {
+        const uint64_t start = now_ns();
+        handles[opened] = memdl_open(data, size, flags);
+        times[opened] = now_ns() - start;
+        if (!handles[opened]) {
+            fprintf(stderr, "%s: instance %d: %s\n", name, opened, memdl_error());
+            break;
+        }
+    }
+    rollup_measure(&pss_after, &rss_after);
+    const size_t shmem_after = meminfo_shmem_kb();
+    for (int i = 0; i < opened; i++) {
+        memdl_close(handles[i]);
+    }
+
+    const uint64_t first_ns = opened ? times[0] : 0;
+    uint64_t total = 0;
+    for (int i = 0; i < opened; i++) total += times[i];
+    qsort(times, (size_t) opened, sizeof(uint64_t), compare_u64);
+    printf("%s    {\"mode\": \"%s\", \"instances\": %d, \"first_open_ns\": %llu, \"median_open_ns\": %llu, "
+           "\"mean_open_ns\": %.0f, \"rss_kb_per_instance\": %.1f, \"pss_kb_per_instance\": %.1f, \"shmem_kb\": %lld}",
+           *first ? "" : ",\n", name, opened, (unsigned long long) first_ns,
+           (unsigned long long) (opened ? times[opened / 2] : 0), opened ? (double) total / opened : 0.0,
+           opened ? ((double) rss_after - (double) rss_before) / opened : 0.0,
+           opened ? ((double) pss_after - (double) pss_before) / opened : 0.0,
+           (long long) shmem_after - (long long) shmem_before);
+    fflush(stdout);
+    *first = 0;
+}
+
+static int bench_instances(const char* path, int count) {
+    size_t size;
+    void* data = read_image(path, &size);
+    if (!data) {
+        return 1;
+    }
+    if (count < 1) count = 1;
+    if (count > 64) count = 64;
+    static const struct {
+        const char* name;
+        int flags;
+    } modes[] = {
+        {"instance", MEMDL_NOW | MEMDL_LOCAL | MEMDL_INSTANCE},
+        {"instance-pooled", MEMDL_NOW | MEMDL_LOCAL | MEMDL_INSTANCE},   // 复用上一轮留在池中的命名空间
+        {"memfd-copy", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE},
+        {"native", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE | MEMDL_NATIVE},
+    };
+    int first = 1;
+    printf("{\n  \"image_size\": %zu,\n  \"results\": [\n", size);
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        instances_case(data, size, modes[m].name, modes[m].flags, count, &first);
+    }
+    printf("\n  ]\n}\n");
+    free(data);
+    return 0;
+}
+#endif
+
+#ifdef BENCH_SYNTHETIC
+// ---------------------------------------------------------------------------
+// 合成共享库：每个导出符号是一个返回自身编号的函数，其余空间用低熵伪随机数据填充到目标大小。
+// 布局：[ELF 头 | 程序头 | .gnu.hash | .dynsym | .dynstr | .text | 填充] RX，[.dynamic] RW
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    void* data;
+    size_t size;
+    size_t exports;
+    char** names;
+} bench_lib_t;
+
+static uint32_t gnu_hash(const char* name) {
+    uint32_t h = 5381;
+    for (const unsigned char* p = (const unsigned char*) name; *p; p++) {
+        h = h * 33 + *p;
+    }
+    return h;
+}
+
+static size_t align_up(const size_t value, const size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+static uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static void bench_lib_free(bench_lib_t* lib) {
+    for (size_t i = 0; i < lib->exports; i++) {
+        free(lib->names[i]);
+    }
+    free(lib->names);
+    free(lib->data);
+}
+
+// 第 i 个导出函数的返回值：AArch64 的 8 字节桩只放得下 mov w0, #imm16，只保留低 16 位
+#if defined(__x86_64__)
+#define BENCH_FN_VALUE(i) ((int) (i))
+#else
+#define BENCH_FN_VALUE(i) ((int) ((i) & 0xFFFF))
+#endif
+
+// 生成至少 target_size 字节、含 exports 个导出函数的共享库，函数间隔 stride 字节（至少 8）
+static int bench_lib_generate(const size_t target_size, const size_t exports, const size_t stride, bench_lib_t* lib) {
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    const size_t nsyms = exports + 1;
+    const uint32_t nbuckets = (uint32_t) (exports / 4 + 1);
+    uint32_t bloom_words = 1;
+    while (bloom_words < exports / 32 + 1) bloom_words <<= 1;
+    const uint32_t bloom_shift = 6;
+
+    memset(lib, 0, sizeof(*lib));
+    lib->exports = exports;
+    lib->names = calloc(exports, sizeof(char*));
+    uint32_t* hashes = malloc(exports * sizeof(uint32_t));
+    size_t* order = malloc(exports * sizeof(size_t));
+    uint32_t* bucket_start = calloc((size_t) nbuckets + 1, sizeof(uint32_t));
+    if (!lib->names || !hashes || !order || !bucket_start) {
+        free(hashes);
+        free(order);
+        free(bucket_start);
+        bench_lib_free(lib);
+        return -1;
+    }
+
+    // GNU 哈希要求同一桶的符号在 .dynsym 中连续，按桶计数排序
+    size_t strsz = 1;
+    for (size_t i = 0; i < exports; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "bench_sym_%zu", i);
+        lib->names[i] = strdup(name);
+        hashes[i] = gnu_hash(name);
+        bucket_start[hashes[i] % nbuckets + 1]++;
+        strsz += strlen(name) + 1;
+    }
+    for (uint32_t b = 0; b < nbuckets; b++) {
+        bucket_start[b + 1] += bucket_start[b];
+    }
+    for (size_t i = 0; i < exports; i++) {
+        order[bucket_start[hashes[i] % nbuckets]++] = i;
+    }
+
+    const size_t phnum = 4;
+    const size_t hash_off = align_up(sizeof(Elf64_Ehdr) + phnum * sizeof(Elf64_Phdr), 8);
+    const size_t hash_size = 16 + bloom_words * 8 + nbuckets * 4 + exports * 4;
+    const size_t sym_off = align_up(hash_off + hash_size, 8);
+    const size_t str_off = sym_off + nsyms * sizeof(Elf64_Sym);
+    const size_t text_off = align_up(str_off + strsz, 16);
+    const size_t text_end = text_off + exports * stride;
+    const size_t dyn_count = 6;
+    const size_t min_rw_off = align_up(text_end, page);
+    const size_t rw_off = target_size > min_rw_off + dyn_count * sizeof(Elf64_Dyn)
+                              ? align_up(target_size - dyn_count * sizeof(Elf64_Dyn), page)
+                              : min_rw_off;
+    const size_t total = rw_off + dyn_count * sizeof(Elf64_Dyn);
+
+    unsigned char* image = calloc(1, total);
+    if (!image) {
+        free(hashes);
+        free(order);
+        free(bucket_start);
+        bench_lib_free(lib);
+        return -1;
+    }
+
+    Elf64_Ehdr* eh = (Elf64_Ehdr*) image;
+    memcpy(eh->e_ident, ELFMAG, SELFMAG);
+    eh->e_ident[EI_CLASS] = ELFCLASS64;
+    eh->e_ident[EI_DATA] = ELFDATA2LSB;
+    eh->e_ident[EI_VERSION] = EV_CURRENT;
+    eh->e_type = ET_DYN;
+#if defined(__x86_64__)
+    eh->e_machine = EM_X86_64;
+#else
+    eh->e_machine = EM_AARCH64;
+#endif
+    eh->e_version = EV_CURRENT;
+    eh->e_phoff = sizeof(Elf64_Ehdr);
+    eh->e_ehsize = sizeof(Elf64_Ehdr);
+    eh->e_phentsize = sizeof(Elf64_Phdr);
+    eh->e_phnum = (Elf64_Half) phnum;
+
+    Elf64_Phdr* ph = (Elf64_Phdr*) (image + eh->e_phoff);
+    ph[0] = (Elf64_Phdr) {PT_LOAD, PF_R | PF_X, 0, 0, 0, rw_off, rw_off, page};
+    ph[1] = (Elf64_Phdr) {PT_LOAD, PF_R | PF_W, rw_off, rw_off, rw_off, total - rw_off, total - rw_off, page};
+    ph[2] = (Elf64_Phdr) {PT_DYNAMIC, PF_R | PF_W, rw_off, rw_off, rw_off, total - rw_off, total - rw_off, 8};
+    ph[3] = (Elf64_Phdr) {PT_GNU_STACK, PF_R | PF_W, 0, 0, 0, 0, 0, 16};
+
+    uint32_t* gnu = (uint32_t*) (image + hash_off);
+    gnu[0] = nbuckets;
+    gnu[1] = 1;
+    gnu[2] = bloom_words;
+    gnu[3] = bloom_shift;
+    uint64_t* bloom = (uint64_t*) (gnu + 4);
+    uint32_t* buckets = (uint32_t*) (bloom + bloom_words);
+    uint32_t* chain = buckets + nbuckets;
+
+    Elf64_Sym* syms = (Elf64_Sym*) (image + sym_off);
+    char* strtab = (char*) (image + str_off);
+    size_t str_pos = 1;
+    for (size_t k = 0; k < exports; k++) {
+        const size_t i = order[k];
+        const uint32_t h = hashes[i];
+        const uint32_t index = (uint32_t) (k + 1);
+        bloom[(h / 64) % bloom_words] |= (1ull << (h % 64)) | (1ull << ((h >> bloom_shift) % 64));
+        if (buckets[h % nbuckets] == 0) buckets[h % nbuckets] = index;
+        const int last = k + 1 == exports || hashes[order[k + 1]] % nbuckets != h % nbuckets;
+        chain[k] = last ? (h | 1) : (h & ~1u);
+
+        // 函数体：返回编号
+        unsigned char* code = image + text_off + i * stride;
+#if defined(__x86_64__)
+        code[0] = 0xB8;                                  // mov eax, imm32
+        memcpy(code + 1, &i, 4);
+        code[5] = 0xC3;                                  // ret
+#else
+        const uint32_t insns[2] = {0x52800000u | (uint32_t) (i & 0xFFFF) << 5, 0xD65F03C0u};  // mov w0, #imm; ret
+        memcpy(code, insns, sizeof(insns));
+#endif
+        const size_t len = strlen(lib->names[i]) + 1;
+        memcpy(strtab + str_pos, lib->names[i], len);
+        syms[index].st_name = (Elf64_Word) str_pos;
+        syms[index].st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
+        syms[index].st_other = STV_DEFAULT;
+        syms[index].st_shndx = 1;
+        syms[index].st_value = text_off + i * stride;
+        syms[index].st_size = 8;
+        str_pos += len;
+    }
+
+    // 填充字从 64 个随机字中抽取，压缩率与真实代码段相近（压缩加载基准使用）
+    uint64_t seed = 0x9E3779B97F4A7C15ull ^ target_size ^ exports;
+    uint64_t words[64];
+    for (int i = 0; i < 64; i++) words[i] = xorshift64(&seed);
+    for (size_t off = align_up(text_end, 8); off + 8 <= rw_off; off += 8) {
+        const uint64_t word = words[xorshift64(&seed) % 64];
+        memcpy(image + off, &word, 8);
+    }
+
+    Elf64_Dyn* dyn = (Elf64_Dyn*) (image + rw_off);
+    dyn[0] = (Elf64_Dyn) {DT_GNU_HASH, {hash_off}};
+    dyn[1] = (Elf64_Dyn) {DT_STRTAB, {str_off}};
+    dyn[2] = (Elf64_Dyn) {DT_SYMTAB, {sym_off}};
+    dyn[3] = (Elf64_Dyn) {DT_STRSZ, {strsz}};
+    dyn[4] = (Elf64_Dyn) {DT_SYMENT, {sizeof(Elf64_Sym)}};
+    dyn[5] = (Elf64_Dyn) {DT_NULL, {0}};
+
+    free(hashes);
+    free(order);
+    free(bucket_start);
+    lib->data = image;
+    lib->size = total;
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 加载策略基准：open/sym/close 延迟分布与吞吐，JSON 输出
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char* name;
+    int flags;
+    int buffer;                 // 使用 memdl_buffer_alloc 的零拷贝缓冲区
+    int warm;                   // 计时前先加载一次（测缓存命中）
+    int lz4;                    // 加载 LZ4 帧压缩后的镜像（测解压吞吐）
+} strategy_t;
+
+static const strategy_t strategies[] = {
+    {"memfd", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE, 0, 0, 0},
+    {"tempfile", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE | MEMDL_TMPFILE, 0, 0, 0},
+    {"native", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE | MEMDL_NATIVE, 0, 0, 0},
+    {"buffer", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE, 1, 0, 0},
+    {"cached", MEMDL_NOW | MEMDL_LOCAL, 0, 1, 0},
+    {"lz4", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE, 0, 0, 1},
+    {"ondemand", MEMDL_NOW | MEMDL_LOCAL | MEMDL_ONDEMAND, 0, 0, 0},
+    {"ondemand-lz4", MEMDL_NOW | MEMDL_LOCAL | MEMDL_ONDEMAND, 0, 0, 1},
+};
+#define STRATEGY_COUNT (sizeof(strategies) / sizeof(strategies[0]))
+
+#define BENCH_SYM_LOOKUPS 256
+
+// ---------------------------------------------------------------------------
+// 最小 LZ4 帧压缩器：贪心哈希匹配，256KB 独立块，供 lz4 策略生成输入
+// ---------------------------------------------------------------------------
+
+#define BENCH_LZ4_BLOCK (256 * 1024)
+
+static size_t lz4_put_length(uint8_t* out, size_t length) {
+    size_t n = 0;
+    for (; length >= 255; length -= 255) out[n++] = 255;
+    out[n++] = (uint8_t) length;
+    return n;
+}
+
+// 写出一个序列：literals 后接 (offset, match) 匹配；match 为 0 表示末尾只有字面量
+static size_t lz4_put_sequence(uint8_t* out, const uint8_t* literals, const size_t count, const size_t offset,
+                               const size_t match) {
+    size_t n = 1;
+    const size_t extra = match ? match - 4 : 0;
+    out[0] = (uint8_t) (((count < 15 ? count : 15) << 4) | (extra < 15 ? extra : 15));
+    if (count >= 15) n += lz4_put_length(out + n, count - 15);
+    memcpy(out + n, literals, count);
+    n += count;
+    if (!match) return n;
+    out[n++] = (uint8_t) offset;
+    out[n++] = (uint8_t) (offset >> 8);
+    if (extra >= 15) n += lz4_put_length(out + n, extra - 15);
+    return n;
+}
+
+// 压缩一个块；out 至少 size + size / 255 + 16 字节
+static size_t lz4_compress_block(const uint8_t* src, const size_t size, uint8_t* out) {
+    static __thread uint32_t table[1 << 12];
+    memset(table, 0, sizeof(table));
+    size_t ip = 0, anchor = 0, n = 0;
+    // 规范要求最后一个匹配至少在块尾 12 字节前开始，且最后 5 字节必须是字面量
+    while (size >= 12 && ip + 12 <= size) {
+        uint32_t sequence;
+        memcpy(&sequence, src + ip, 4);
+        const uint32_t h = (sequence * 2654435761u) >> 20;
+        const size_t candidate = table[h];
+        table[h] = (uint32_t) ip + 1;
+        uint32_t previous;
+        if (candidate && ip - (candidate - 1) <= 65535 && (memcpy(&previous, src + candidate - 1, 4), previous == sequence)) {
+            const size_t match = candidate - 1;
+            size_t length = 4;
+            while (ip + length < size - 5 && src[match + length] == src[ip + length]) length++;
+            n += lz4_put_sequence(out + n, src + anchor, ip - anchor, ip - match, length);
+            ip += length;
+            anchor = ip;
+        } else {
+            ip++;
+        }
+    }
+    return n + lz4_put_sequence(out + n, src + anchor, size - anchor, 0, 0);
+}
+
+// 生成 LZ4 帧：FLG=0x60（版本 01、块独立），BD=0x50（256KB），HC=0xFB 为描述符 XXH32 的第二字节
+static uint8_t* lz4_compress_frame(const uint8_t* src, const size_t size, size_t* out_size) {
+    const size_t blocks = size / BENCH_LZ4_BLOCK + 1;
+    uint8_t* out = malloc(7 + size + blocks * (4 + BENCH_LZ4_BLOCK / 255 + 16) + 4);
+    if (!out) return NULL;
+    static const uint8_t header[] = {0x04, 0x22, 0x4D, 0x18, 0x60, 0x50, 0xFB};
+    memcpy(out, header, sizeof(header));
+    size_t n = sizeof(header);
+    for (size_t off = 0; off < size; off += BENCH_LZ4_BLOCK) {
+        const size_t length = size - off < BENCH_LZ4_BLOCK ? size - off : BENCH_LZ4_BLOCK;
+        size_t packed = lz4_compress_block(src + off, length, out + n + 4);
+        uint32_t word = (uint32_t) packed;
+        // 压缩无收益时存原始块
+        if (packed >= length) {
+            memcpy(out + n + 4, src + off, length);
+            packed = length;
+            word = (uint32_t) length | 0x80000000u;
+        }
+        for (int i = 0; i < 4; i++) out[n + i] = (uint8_t) (word >> (i * 8));
+        n += 4 + packed;
+    }
+    memset(out + n, 0, 4);
+    *out_size = n + 4;
+    return out;
+}
+
+typedef struct {
+    const bench_lib_t* lib;
+    const strategy_t* strategy;
+    size_t iterations;
+    uint64_t* open_ns;
+    uint64_t* sym_ns;
+    uint64_t* close_ns;
+    size_t sym_count;
+    size_t failures;
+    size_t image_size;          // 实际传给 memdl_open 的字节数（lz4 策略为压缩后大小）
+    memdl_page_info_t pages;    // 原生加载时最后一次迭代关闭前的页面驻留情况
+    char error[256];
+    pthread_barrier_t* barrier;
+} load_job_t;
+
+static void* load_worker(void* arg) {
+    load_job_t* job = arg;
+    const bench_lib_t* lib = job->lib;
+    const void* image = lib->data;
+    size_t image_size = lib->size;
+    void* buffer = NULL;
+    uint8_t* packed = NULL;
+    if (job->strategy->buffer) {
+        buffer = memdl_buffer_alloc(lib->size);
+        if (buffer) {
+            memcpy(buffer, lib->data, lib->size);
+            image = buffer;
+        }
+    }
+    if (job->strategy->lz4) {
+        packed = lz4_compress_frame(lib->data, lib->size, &image_size);
+        if (packed) {
+            image = packed;
+        } else {
+            image_size = lib->size;
+        }
+    }
+    job->image_size = image_size;
+    memdl_handle_t warm = job->strategy->warm ? memdl_open(image, image_size, job->strategy->flags) : NULL;
+    uint64_t seed = (uint64_t) (uintptr_t) job | 1;
+
+    pthread_barrier_wait(job->barrier);
+    for (size_t it = 0; it < job->iterations; it++) {
+        uint64_t start = now_ns();
+        memdl_handle_t handle = memdl_open(image, image_size, job->strategy->flags);
+        job->open_ns[it] = now_ns() - start;
+        if (!handle) {
+            job->failures++;
+            snprintf(job->error, sizeof(job->error), "%s", memdl_error());
+            job->close_ns[it] = 0;
+            continue;
+        }
+
+        const size_t lookups = lib->exports < BENCH_SYM_LOOKUPS ? lib->exports : BENCH_SYM_LOOKUPS;
+        for (size_t i = 0; i < lookups; i++) {
+            const size_t index = (size_t) (xorshift64(&seed) % lib->exports);
+            start = now_ns();
+            int (*fn)(void) = (int (*)(void)) memdl_sym(handle, lib->names[index]);
+            job->sym_ns[job->sym_count++] = now_ns() - start;
+            if (!fn || fn() != BENCH_FN_VALUE(index)) {
+                job->failures++;
+                snprintf(job->error, sizeof(job->error), "bad symbol %s", lib->names[index]);
+            }
+        }
+
+        memdl_get_page_info(handle, &job->pages);
+        start = now_ns();
+        memdl_close(handle);
+        job->close_ns[it] = now_ns() - start;
+    }
+
+    if (warm) memdl_close(warm);
+    if (buffer) memdl_buffer_free(buffer);
+    free(packed);
+    return NULL;
+}
+
+static void print_dist(const char* key, uint64_t* values, const size_t count) {
+    if (count == 0) {
+        printf("\"%s\": null", key);
+        return;
+    }
+    qsort(values, count, sizeof(uint64_t), compare_u64);
+    double sum = 0;
+    for (size_t i = 0; i < count; i++) sum += (double) values[i];
+    const size_t p99 = count * 99 / 100 < count ? count * 99 / 100 : count - 1;
+    printf("\"%s\": {\"p50\": %llu, \"p99\": %llu, \"min\": %llu, \"max\": %llu, \"mean\": %.1f}", key,
+           (unsigned long long) values[count / 2], (unsigned long long) values[p99],
+           (unsigned long long) values[0], (unsigned long long) values[count - 1], sum / (double) count);
+}
+
+// 每个 (策略, 镜像, 线程数) 组合输出一个 JSON 对象
+static void run_case(const bench_lib_t* lib, const strategy_t* strategy, const int threads, const size_t iterations,
+                     int* first) {
+    pthread_t tids[64];
+    load_job_t jobs[64];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, (unsigned) threads + 1);
+
+    const size_t lookups = lib->exports < BENCH_SYM_LOOKUPS ? lib->exports : BENCH_SYM_LOOKUPS;
+    const size_t total = iterations * (size_t) threads;
+    uint64_t* open_ns = calloc(total, sizeof(uint64_t));
+    uint64_t* close_ns = calloc(total, sizeof(uint64_t));
+    uint64_t* sym_ns = calloc(total * lookups + 1, sizeof(uint64_t));
+    for (int t = 0; t < threads; t++) {
+        jobs[t] = (load_job_t) {lib, strategy, iterations, open_ns + t * iterations, sym_ns + t * iterations * lookups,
+                                close_ns + t * iterations, 0, 0, lib->size, {0}, "", &barrier};
+        pthread_create(&tids[t], NULL, load_worker, &jobs[t]);
+    }
+    pthread_barrier_wait(&barrier);
+    const uint64_t start = now_ns();
+    size_t failures = 0, syms = 0;
+    const char* error = "";
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+        failures += jobs[t].failures;
+        if (jobs[t].failures && !*error) error = jobs[t].error;
+    }
+    const uint64_t wall = now_ns() - start;
+    pthread_barrier_destroy(&barrier);
+
+    // 各线程的查找延迟按线程紧凑排列
+    for (int t = 0; t < threads; t++) {
+        memmove(sym_ns + syms, jobs[t].sym_ns, jobs[t].sym_count * sizeof(uint64_t));
+        syms += jobs[t].sym_count;
+    }
+
+    const double seconds = (double) wall / 1e9;
+    printf("%s    {\"strategy\": \"%s\", \"size\": %zu, \"exports\": %zu, \"threads\": %d, \"iterations\": %zu, ",
+           *first ? "" : ",\n", strategy->name, lib->size, lib->exports, threads, iterations);
+    print_dist("open_ns", open_ns, total);
+    printf(", ");
+    print_dist("sym_ns", sym_ns, syms);
+    printf(", ");
+    print_dist("close_ns", close_ns, total);
+    printf(", \"wall_ns\": %llu, \"opens_per_sec\": %.1f, \"mb_per_sec\": %.1f, \"failures\": %zu",
+           (unsigned long long) wall, (double) total / seconds,
+           (double) total * (double) lib->size / (1024.0 * 1024.0) / seconds, failures);
+    if (strategy->lz4) {
+        printf(", \"compressed_size\": %zu", jobs[0].image_size);
+    }
+    if (strategy->flags & (MEMDL_NATIVE | MEMDL_ONDEMAND)) {
+        printf(", \"pages\": %zu, \"pages_faulted\": %zu, \"fault_ns\": %llu", jobs[0].pages.pages,
+               jobs[0].pages.faulted, (unsigned long long) jobs[0].pages.fault_ns);
+    }
+    if (failures) {
+        printf(", \"error\": \"");
+        for (const char* p = error; *p; p++) {
+            if (*p == '"' || *p == '\\') putchar('\\');
+            putchar(*p);
+        }
+        printf("\"");
+    }
+    printf("}");
+    fflush(stdout);
+    *first = 0;
+
+    free(open_ns);
+    free(close_ns);
+    free(sym_ns);
+}
+
+// 解析逗号分隔的列表，支持 K/M/G 后缀
+static size_t parse_list(const char* text, size_t* values, const size_t max) {
+    size_t count = 0;
+    while (*text && count < max) {
+        char* end;
+        double value = strtod(text, &end);
+        if (*end == 'K' || *end == 'k') value *= 1024, end++;
+        else if (*end == 'M' || *end == 'm') value *= 1024 * 1024, end++;
+        else if (*end == 'G' || *end == 'g') value *= 1024.0 * 1024 * 1024, end++;
+        values[count++] = (size_t) value;
+        text = *end == ',' ? end + 1 : end;
+        if (end == text && *text != ',') break;
+    }
+    return count;
+}
+
+static int bench_suite(int argc, char** argv) {
+    // 默认矩阵：导出数量扫描（最小镜像）+ 镜像大小扫描（1000 个导出）
+    size_t sizes[16] = {10 << 10, 1 << 20, 16 << 20, 128 << 20, 500 << 20};
+    size_t size_count = 5;
+    size_t exports[16] = {10, 1000, 10000, 100000};
+    size_t export_count = 4;
+    int max_threads = (int) memdl_get_threads();
+    size_t budget = (size_t) 2 << 30;
+    const char* only = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            size_count = parse_list("10K,1M", sizes, 16);
+            export_count = parse_list("10,1000", exports, 16);
+            if (max_threads > 2) max_threads = 2;
+        } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            size_count = parse_list(argv[++i], sizes, 16);
+        } else if (strcmp(argv[i], "--exports") == 0 && i + 1 < argc) {
+            export_count = parse_list(argv[++i], exports, 16);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--strategies") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            parse_list(argv[++i], &budget, 1);
+        } else {
+            return -1;
+        }
+    }
+    if (max_threads < 1) max_threads = 1;
+    if (max_threads > 64) max_threads = 64;
+
+    // 组合列表：(最小大小, 各导出数量) 与 (各大小, 1000 导出)，去重
+    size_t cases[32][2];
+    size_t case_count = 0;
+    for (size_t e = 0; e < export_count && case_count < 32; e++) {
+        cases[case_count][0] = sizes[0];
+        cases[case_count++][1] = exports[e];
+    }
+    const size_t default_exports = export_count > 1 ? exports[1] : exports[0];
+    for (size_t s = 1; s < size_count && case_count < 32; s++) {
+        cases[case_count][0] = sizes[s];
+        cases[case_count++][1] = default_exports;
+    }
+
+    printf("{\n  \"platform\": %d,\n  \"cpus\": %ld,\n  \"page_size\": %ld,\n  \"results\": [\n", memdl_get_platform(),
+           sysconf(_SC_NPROCESSORS_ONLN), sysconf(_SC_PAGESIZE));
+    int first = 1;
+    for (size_t c = 0; c < case_count; c++) {
+        bench_lib_t lib;
+        if (bench_lib_generate(cases[c][0], cases[c][1], 8, &lib) != 0) {
+            fprintf(stderr, "Failed to generate %zu byte library\n", cases[c][0]);
+            return 1;
+        }
+        // 迭代次数随大小递减，保证每个组合耗时相近
+        size_t iterations = ((size_t) 256 << 20) / lib.size;
+        if (iterations > 200) iterations = 200;
+        if (iterations < 3) iterations = 3;
+
+        for (size_t s = 0; s < STRATEGY_COUNT; s++) {
+            if (only && !strstr(only, strategies[s].name)) continue;
+            // 线程数依次为 1、2、4……，最后一项总是 max_threads
+            for (int threads = 1;; threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+                // 源镜像与加载副本同时驻留，超出内存预算的组合跳过
+                if ((size_t) threads * lib.size * 2 > budget) break;
+                fprintf(stderr, "%-8s size=%-10zu exports=%-6zu threads=%d\n", strategies[s].name, lib.size,
+                        lib.exports, threads);
+                run_case(&lib, &strategies[s], threads, iterations, &first);
+                if (threads >= max_threads) break;
+            }
+        }
+        bench_lib_free(&lib);
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 大页基准：导出函数按 16KB 间隔散布在大代码段中，以随机顺序反复调用，
+// 对比 4KB 页与 MEMDL_HUGEPAGES 的用户态 iTLB 缺失和每次调用耗时
+// ---------------------------------------------------------------------------
+
+#define ITLB_STRIDE 16384
+
+typedef int (*itlb_fn_t)(void);
+
+// 用户态 iTLB 读缺失计数器；没有 PMU（多数虚拟机）或权限不足时返回 -1
+static int itlb_counter_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_ITLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void itlb_case(const bench_lib_t* lib, const char* name, const int flags, const size_t* order,
+                      const size_t rounds, int* first) {
+    memdl_handle_t handle = memdl_open(lib->data, lib->size, flags);
+    itlb_fn_t* fns = malloc(lib->exports * sizeof(itlb_fn_t));
+    if (!handle || !fns) {
+        fprintf(stderr, "%s: %s\n", name, memdl_error());
+        free(fns);
+        if (handle) memdl_close(handle);
+        return;
+    }
+    for (size_t i = 0; i < lib->exports; i++) {
+        fns[i] = (itlb_fn_t) memdl_sym(handle, lib->names[order[i]]);
+        if (!fns[i]) {
+            fprintf(stderr, "%s: %s\n", name, memdl_error());
+            free(fns);
+            memdl_close(handle);
+            return;
+        }
+    }
+    memdl_segment_t segments[16];
+    const size_t count = memdl_get_segments(handle, segments, 16);
+    size_t text_bytes = 0, huge_bytes = 0;
+    for (size_t i = 0; i < count && i < 16; i++) {
+        if (segments[i].flags & PF_X) {
+            text_bytes += segments[i].size;
+            huge_bytes += segments[i].huge_bytes;
+        }
+    }
+
+    // 预热一轮，之后只计稳定状态的调用；返回值之和用来校验调用到了正确的函数
+    uint64_t sum = 0;
+    for (size_t i = 0; i < lib->exports; i++) sum += (uint64_t) fns[i]();
+    const int counter = itlb_counter_open();
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    const uint64_t start = now_ns();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < lib->exports; i++) sum += (uint64_t) fns[i]();
+    }
+    const uint64_t elapsed = now_ns() - start;
+    long long misses = -1;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &misses, sizeof(misses)) != (ssize_t) sizeof(misses)) misses = -1;
+        close(counter);
+    }
+    const uint64_t expected = (uint64_t) (rounds + 1) * lib->exports * (lib->exports - 1) / 2;
+    const size_t calls = rounds * lib->exports;
+
+    printf("%s    {\"mode\": \"%s\", \"image_size\": %zu, \"functions\": %zu, \"text_bytes\": %zu, "
+           "\"huge_bytes\": %zu, \"calls\": %zu, \"ns_per_call\": %.2f, \"checksum_ok\": %s, ",
+           *first ? "" : ",\n", name, lib->size, lib->exports, text_bytes, huge_bytes, calls,
+           (double) elapsed / (double) calls, sum == expected ? "true" : "false");
+    if (misses >= 0) {
+        printf("\"itlb_misses\": %lld, \"itlb_misses_per_call\": %.4f}", misses, (double) misses / (double) calls);
+    } else {
+        printf("\"itlb_misses\": null, \"itlb_misses_per_call\": null}");
+    }
+    *first = 0;
+    free(fns);
+    memdl_close(handle);
+}
+
+static int bench_itlb(const char* size_text) {
+    size_t size = (size_t) 64 << 20;
+    if (size_text && parse_list(size_text, &size, 1) != 1) {
+        return 1;
+    }
+    const size_t exports = size / ITLB_STRIDE > 16 ? size / ITLB_STRIDE - 16 : 1;
+    bench_lib_t lib;
+    if (bench_lib_generate(size, exports, ITLB_STRIDE, &lib) != 0) {
+        fprintf(stderr, "Failed to generate %zu byte library\n", size);
+        return 1;
+    }
+    // 随机调用顺序，使相邻调用落在不同页上
+    size_t* order = malloc(exports * sizeof(size_t));
+    if (!order) {
+        bench_lib_free(&lib);
+        return 1;
+    }
+    uint64_t seed = 0x2545F4914F6CDD1Dull;
+    for (size_t i = 0; i < exports; i++) order[i] = i;
+    for (size_t i = exports - 1; i > 0; i--) {
+        const size_t j = xorshift64(&seed) % (i + 1);
+        const size_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    const size_t rounds = ((size_t) 16 << 20) / exports + 1;
+
+    static const struct {
+        const char* name;
+        int flags;
+    } modes[] = {
+        {"memfd", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE},
+        {"memfd-huge", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE | MEMDL_HUGEPAGES},
+        {"native", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE | MEMDL_NATIVE},
+        {"native-huge", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE | MEMDL_NATIVE | MEMDL_HUGEPAGES},
+    };
+    int first = 1;
+    printf("{\n  \"page_size\": %ld,\n  \"results\": [\n", sysconf(_SC_PAGESIZE));
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        itlb_case(&lib, modes[m].name, modes[m].flags, order, rounds, &first);
+    }
+    printf("\n  ]\n}\n");
+    free(order);
+    bench_lib_free(&lib);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 预取基准：每个函数独占一页，统计加载与首轮调用期间本线程的缺页次数和耗时，对比 MEMDL_PREFAULT
+// ---------------------------------------------------------------------------
+
+static uint64_t thread_faults(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return (uint64_t) usage.ru_minflt + (uint64_t) usage.ru_majflt;
+}
+
+static void prefault_case(const bench_lib_t* lib, const char* name, const int flags, int* first) {
+    const uint64_t open_faults = thread_faults();
+    const uint64_t open_start = now_ns();
+    memdl_handle_t handle = memdl_open(lib->data, lib->size, flags);
+    const uint64_t open_ns = now_ns() - open_start;
+    const uint64_t open_delta = thread_faults() - open_faults;
+    itlb_fn_t* fns = malloc(lib->exports * sizeof(itlb_fn_t));
+    if (!handle || !fns) {
+        fprintf(stderr, "%s: %s\n", name, memdl_error());
+        free(fns);
+        if (handle) memdl_close(handle);
+        return;
+    }
+    for (size_t i = 0; i < lib->exports; i++) {
+        fns[i] = (itlb_fn_t) memdl_sym(handle, lib->names[i]);
+    }
+
+    // 首轮调用：每次调用单独计时，最慢一次即首个请求可能遇到的尖峰
+    uint64_t sum = 0, max_call = 0;
+    const uint64_t call_faults = thread_faults();
+    const uint64_t call_start = now_ns();
+    for (size_t i = 0; i < lib->exports; i++) {
+        const uint64_t t = now_ns();
+        sum += fns[i] ? (uint64_t) fns[i]() : 0;
+        const uint64_t elapsed = now_ns() - t;
+        if (elapsed > max_call) max_call = elapsed;
+    }
+    const uint64_t call_ns = now_ns() - call_start;
+    const uint64_t call_delta = thread_faults() - call_faults;
+
+    printf("%s    {\"mode\": \"%s\", \"image_size\": %zu, \"functions\": %zu, \"open_ns\": %llu, "
+           "\"open_faults\": %llu, \"first_pass_ns\": %llu, \"first_pass_faults\": %llu, \"max_call_ns\": %llu, "
+           "\"checksum_ok\": %s}",
+           *first ? "" : ",\n", name, lib->size, lib->exports, (unsigned long long) open_ns,
+           (unsigned long long) open_delta, (unsigned long long) call_ns, (unsigned long long) call_delta,
+           (unsigned long long) max_call,
+           sum == (uint64_t) lib->exports * (lib->exports - 1) / 2 ? "true" : "false");
+    *first = 0;
+    free(fns);
+    memdl_close(handle);
+}
+
+static int bench_prefault(const char* size_text) {
+    size_t size = (size_t) 16 << 20;
+    if (size_text && parse_list(size_text, &size, 1) != 1) {
+        return 1;
+    }
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    const size_t exports = size / page > 16 ? size / page - 16 : 1;
+    bench_lib_t lib;
+    if (bench_lib_generate(size, exports, page, &lib) != 0) {
+        fprintf(stderr, "Failed to generate %zu byte library\n", size);
+        return 1;
+    }
+    static const struct {
+        const char* name;
+        int flags;
+    } modes[] = {
+        {"memfd", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE},
+        {"memfd-prefault", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE | MEMDL_PREFAULT},
+        {"native", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE | MEMDL_NATIVE},
+        {"native-prefault", MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE | MEMDL_NATIVE | MEMDL_PREFAULT},
+        {"ondemand", MEMDL_NOW | MEMDL_LOCAL | MEMDL_ONDEMAND},
+        {"ondemand-prefault", MEMDL_NOW | MEMDL_LOCAL | MEMDL_ONDEMAND | MEMDL_PREFAULT},
+    };
+    int first = 1;
+    printf("{\n  \"page_size\": %zu,\n  \"results\": [\n", page);
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        prefault_case(&lib, modes[m].name, modes[m].flags, &first);
+    }
+    printf("\n  ]\n}\n");
+    bench_lib_free(&lib);
+    return 0;
+}
+#endif
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [--quick] [--sizes 10K,1M,...] [--exports 10,1000,...] [--threads N]\n"
+            "          [--strategies memfd,tempfile,native,buffer,cached,lz4,ondemand,ondemand-lz4] [--memory 2G]\n"
+            "       %s sym <library> [max_threads]\n"
+            "       %s share <library> [workers,...]\n"
+            "       %s instances <library> [count]\n"
+            "       %s itlb [image_size]\n"
+            "       %s prefault [image_size]\n",
+            argv0, argv0, argv0, argv0, argv0, argv0);
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && strcmp(argv[1], "sym") == 0) {
+        return bench_sym(argv[2], argc > 3 ? atoi(argv[3]) : 8);
+    }
+#ifdef __linux__
+    if (argc >= 3 && strcmp(argv[1], "share") == 0) {
+        return bench_share(argv[2], argc > 3 ? argv[3] : "1,8,32");
+    }
+    if (argc >= 3 && strcmp(argv[1], "instances") == 0) {
+        return bench_instances(argv[2], argc > 3 ? atoi(argv[3]) : 8);
+    }
+#endif
+#ifdef BENCH_SYNTHETIC
+    if (argc >= 2 && strcmp(argv[1], "itlb") == 0) {
+        return bench_itlb(argc > 2 ? argv[2] : NULL);
+    }
+    if (argc >= 2 && strcmp(argv[1], "prefault") == 0) {
+        return bench_prefault(argc > 2 ? argv[2] : NULL);
+    }
+    if (bench_suite(argc, argv) == 0) {
+        return 0;
+    }
+#endif
+    usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,157 @@
+/*******************************************************************************
+ * File: memdl_pack.c
+ * Project: memdl
+ * Created: 2025/11/7
+ * Author: eternalfuture-e38299
+ * Github: https://github.com/eternalfuture-e38299
+ *
+ * MIT License
+ *
+ * Copyright (c) 2025 EternalFuture
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memdl.h"
+
+// 打包工具：memdl_pack -o plugins.bundle a.so b.so name=path/c.so
+//          memdl_pack -l plugins.bundle
+
+static void* read_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = (size_t) ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void* data = malloc(*size ? *size : 1);
+    if (data && fread(data, 1, *size, file) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+// 成员名默认取文件名，"名称=路径" 可指定
+static const char* member_name(const char* arg, const char** path) {
+    const char* eq = strchr(arg, '=');
+    if (eq) {
+        *path = eq + 1;
+        return arg;
+    }
+    *path = arg;
+    const char* slash = strrchr(arg, '/');
+#ifdef _WIN32
+    const char* backslash = strrchr(arg, '\\');
+    if (backslash && (!slash || backslash > slash)) slash = backslash;
+#endif
+    return slash ? slash + 1 : arg;
+}
+
+static int list_bundle(const char* path) {
+    memdl_bundle_t* bundle = memdl_bundle_open_file(path);
+    if (!bundle) {
+        fprintf(stderr, "Cannot open %s: %s\n", path, memdl_error());
+        return 1;
+    }
+    for (size_t i = 0; i < memdl_bundle_count(bundle); i++) {
+        const char* name = memdl_bundle_name(bundle, i);
+        memdl_source_t image;
+        memdl_bundle_find(bundle, name, &image);
+        printf("%-40s %10zu bytes  arch=%d  exports=%zu\n", name, image.size,
+               memdl_get_arch(image.data, image.size), memdl_bundle_exports(bundle, name, NULL, 0));
+    }
+    memdl_bundle_close(bundle);
+    return 0;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s -o <bundle> [-a align] <library | name=library>...\n"
+            "       %s -l <bundle>\n",
+            argv0, argv0);
+}
+
+int main(int argc, char** argv) {
+    const char* output = NULL;
+    size_t align = 0;
+    int first = 1;
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        if (strcmp(argv[first], "-l") == 0 && first + 1 < argc) {
+            return list_bundle(argv[first + 1]);
+        } else if (strcmp(argv[first], "-o") == 0 && first + 1 < argc) {
+            output = argv[++first];
+        } else if (strcmp(argv[first], "-a") == 0 && first + 1 < argc) {
+            align = (size_t) strtoul(argv[++first], NULL, 0);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    const size_t count = first < argc ? (size_t) (argc - first) : 0;
+    if (!output || count == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char** names = calloc(count, sizeof(char*));
+    memdl_source_t* images = calloc(count, sizeof(memdl_source_t));
+    int status = names && images ? 0 : 1;
+    for (size_t i = 0; status == 0 && i < count; i++) {
+        const char* path;
+        const char* name = member_name(argv[first + i], &path);
+        // "名称=路径" 中的名称需要单独的字符串
+        if (path != argv[first + i]) {
+            const size_t len = (size_t) (path - 1 - name);
+            char* copy = malloc(len + 1);
+            if (copy) {
+                memcpy(copy, name, len);
+                copy[len] = '\0';
+            }
+            names[i] = copy;
+        } else {
+            names[i] = name;
+        }
+        images[i].data = read_file(path, &images[i].size);
+        if (!names[i] || !images[i].data) {
+            fprintf(stderr, "Cannot read %s\n", path);
+            status = 1;
+        }
+    }
+    if (status == 0 && memdl_bundle_write(output, names, images, count, align) != 0) {
+        fprintf(stderr, "Cannot write %s: %s\n", output, memdl_error());
+        status = 1;
+    }
+    if (status == 0) {
+        printf("Packed %zu libraries into %s\n", count, output);
+    }
+    for (size_t i = 0; names && images && i < count; i++) {
+        if (names[i] && strchr(argv[first + i], '=')) free((void*) names[i]);
+        free((void*) images[i].data);
+    }
+    free(names);
+    free(images);
+    return status;
+}
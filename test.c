@@ -30,12 +30,95 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "memdl.h"
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#endif
+
 // 测试函数类型
 typedef void (*test_func_t)(void);
 typedef int (*calculate_t)(int, int);
 typedef const char* (*get_message_t)(void);
+typedef int (*top_value_t)(void);
+typedef void* (*top_dep_addr_t)(void);
+
+static void* read_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void* data = malloc(*size);
+    if (data && fread(data, 1, *size, file) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+// 流式读取：每次最多交出 chunk 字节；data 为 NULL 时产生无穷的垃圾数据
+typedef struct {
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+    size_t chunk;
+    int calls;
+} stream_ctx_t;
+
+static ptrdiff_t stream_read(void* ctx, void* buf, size_t size) {
+    stream_ctx_t* stream = ctx;
+    stream->calls++;
+    size_t n = size < stream->chunk ? size : stream->chunk;
+    if (!stream->data) {
+        if (stream->calls > 1000) return 0;
+        memset(buf, 'x', n);
+        return (ptrdiff_t) n;
+    }
+    if (n > stream->size - stream->offset) n = stream->size - stream->offset;
+    memcpy(buf, stream->data + stream->offset, n);
+    stream->offset += n;
+    return (ptrdiff_t) n;
+}
+
+// 依赖只存在于内存中：注册 libtest_dep.so 后加载 libtest_top.so
+static void test_dependencies(int flags, const char* mode) {
+    size_t dep_size, top_size;
+    void* dep_data = read_file("libtest_dep.so", &dep_size);
+    void* top_data = read_file("libtest_top.so", &top_size);
+    if (!dep_data || !top_data) {
+        printf("⚠️  Dependency test libraries not found\n");
+        free(dep_data);
+        free(top_data);
+        return;
+    }
+
+    memdl_register("libtest_dep.so", dep_data, dep_size);
+    memdl_handle_t dep = memdl_open(dep_data, dep_size, flags);
+    memdl_handle_t top = memdl_open(top_data, top_size, flags);
+    top_value_t top_value = top ? memdl_sym(top, "top_value") : NULL;
+    top_dep_addr_t top_dep_addr = top ? memdl_sym(top, "top_dep_addr") : NULL;
+    if (top_value && top_dep_addr && top_value() == 42 && dep && top_dep_addr() == memdl_sym(dep, "dep_value")) {
+        printf("✅ In-memory dependency resolved (%s)\n", mode);
+    } else {
+        printf("⚠️  In-memory dependency failed (%s): %s\n", mode, memdl_error());
+    }
+    if (top) {
+        memdl_close(top);
+    }
+    if (dep) {
+        memdl_close(dep);
+    }
+    memdl_unregister("libtest_dep.so");
+    free(dep_data);
+    free(top_data);
+}
 
 int main() {
     printf("memdl Test - Platform: %d\n", memdl_get_platform());
@@ -75,6 +158,26 @@ int main() {
     int arch = memdl_get_arch(data, size);
     printf("🏗️  Library architecture: %d\n", arch);
 
+    // 预解析镜像：描述符可重复实例化，且与直接加载共用缓存
+    memdl_image_t* prepared = memdl_image_prepare(data, size);
+    memdl_image_info_t image_info;
+    if (prepared && memdl_image_get_info(prepared, &image_info) == 0 && image_info.arch == arch) {
+        printf("✅ Image prepared: format=%d bits=%d segments=%zu needed=%zu\n", image_info.format,
+               image_info.bits, image_info.segments, image_info.needed);
+    } else {
+        printf("⚠️  Image prepare failed: %s\n", memdl_error());
+    }
+
+    // 导出符号内省：不加载镜像即可列出并查找导出符号
+    memdl_export_t export_info;
+    const size_t export_count = prepared ? memdl_image_exports(prepared, NULL, 0) : 0;
+    if (prepared && memdl_image_find_export(prepared, "calculate_sum", &export_info) == 0 &&
+        export_info.type == MEMDL_SYMBOL_FUNC && memdl_image_find_export(prepared, "no_such_symbol", NULL) != 0) {
+        printf("✅ Image exports %zu symbols without loading\n", export_count);
+    } else {
+        printf("⚠️  Export introspection failed: %s\n", memdl_error());
+    }
+
     // 内存加载
     memdl_handle_t handle = memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL);
     if (!handle) {
@@ -106,6 +209,469 @@ int main() {
         printf("💬 get_message() = %s\n", msg);
     }
 
+#ifdef __linux__
+    // 测试 IFUNC：建索引时不调用解析函数，查找时才解析
+    top_value_t resolver_calls = memdl_sym(handle, "ifunc_resolver_calls");
+    const int calls_before = resolver_calls ? resolver_calls() : -1;
+    top_value_t ifunc_value = memdl_sym(handle, "ifunc_value");
+    if (calls_before == 0 && ifunc_value && ifunc_value() == 7) {
+        printf("✅ IFUNC resolved on lookup only\n");
+    } else {
+        printf("⚠️  IFUNC resolution misbehaved (resolver calls before lookup: %d)\n", calls_before);
+    }
+#endif
+
+    memdl_handle_t from_image = prepared ? memdl_image_open(prepared, MEMDL_NOW | MEMDL_LOCAL) : NULL;
+    if (prepared && from_image != handle) {
+        printf("⚠️  Prepared image did not reuse the cached handle: %s\n", memdl_error());
+    }
+    if (from_image) {
+        memdl_close(from_image);
+    }
+    memdl_image_release(prepared);
+
+    // 测试批量符号绑定：按函数指针结构体的成员顺序填充
+    struct {
+        test_func_t native_test;
+        calculate_t calculate_sum;
+        get_message_t get_message;
+    } api;
+    const char* api_names[] = {"native_test", "calculate_sum", "get_message"};
+    const size_t bound = memdl_sym_many(handle, api_names, (void**) &api, 3);
+    if (bound == 3 && api.calculate_sum == calc_func) {
+        printf("✅ Batch binding resolved %zu symbols\n", bound);
+    } else {
+        printf("⚠️  Batch binding resolved %zu of 3 symbols: %s\n", bound, memdl_error());
+    }
+
+    // 测试句柄缓存：相同内容的镜像应复用已加载的句柄
+    memdl_handle_t again = memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL);
+    memdl_cache_stats_t cache_stats;
+    memdl_cache_stats(&cache_stats);
+    printf("🗃️  Cache: hits=%llu misses=%llu entries=%zu\n",
+           (unsigned long long) cache_stats.hits, (unsigned long long) cache_stats.misses,
+           cache_stats.entries);
+    if (again != handle) {
+        printf("⚠️  Repeated open did not reuse the cached handle\n");
+    }
+    if (again) {
+        memdl_close(again);
+    }
+    // 加载标志不同的打开不能复用同一句柄
+    memdl_handle_t lazy_open = memdl_open(data, size, MEMDL_LAZY | MEMDL_LOCAL);
+    if (!lazy_open || lazy_open == handle) {
+        printf("⚠️  Open with different flags reused the cached handle\n");
+    }
+    if (lazy_open) {
+        memdl_close(lazy_open);
+    }
+
+    // 测试完整性校验：摘要命中缓存时复用句柄，未命中时边复制边校验，摘要不符时拒绝加载
+    const uint64_t digest = memdl_digest(data, size);
+    memdl_handle_t verified = memdl_open_verified(data, size, MEMDL_NOW | MEMDL_LOCAL, digest);
+    memdl_handle_t verified_fresh = memdl_open_verified(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE, digest);
+    memdl_handle_t tampered = memdl_open_verified(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE, digest ^ 1);
+    memdl_error_info_t verify_error;
+    memdl_last_error(&verify_error);
+    if (verified == handle && verified_fresh && !tampered && verify_error.code == MEMDL_ERR_INTEGRITY) {
+        printf("✅ Verified open accepts digest %016llx and rejects a mismatch\n", (unsigned long long) digest);
+    } else {
+        printf("⚠️  Verified open misbehaved: %s\n", memdl_error());
+    }
+    if (verified) {
+        memdl_close(verified);
+    }
+    if (verified_fresh) {
+        memdl_close(verified_fresh);
+    }
+
+    // 测试零拷贝缓冲区：直接填充 memfd 映射后加载
+    void* image = memdl_buffer_alloc(size);
+    if (image) {
+        memcpy(image, data, size);
+        memdl_handle_t zc = memdl_open(image, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE);
+        calculate_t zc_calc = zc ? memdl_sym(zc, "calculate_sum") : NULL;
+        if (zc_calc && zc_calc(1, 2) == 3) {
+            printf("✅ Zero-copy buffer load works\n");
+        } else {
+            printf("⚠️  Zero-copy buffer load failed: %s\n", memdl_error());
+        }
+        if (zc) {
+            memdl_close(zc);
+        }
+        memdl_buffer_free(image);
+    }
+
+    // 测试加载统计：开启计时后重新加载，检查各阶段记录
+    memdl_set_instrumentation(1);
+    memdl_handle_t timed = memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE);
+    memdl_load_info_t load_info;
+    if (timed && memdl_get_load_info(timed, &load_info) == 0 && load_info.total_ns > 0) {
+        printf("⏱️  Load: strategy=%d total=%lluns copy=%lluns link=%lluns bytes=%llu\n", load_info.strategy,
+               (unsigned long long) load_info.total_ns,
+               (unsigned long long) load_info.stage_ns[MEMDL_TRACE_COPY],
+               (unsigned long long) load_info.stage_ns[MEMDL_TRACE_LINK],
+               (unsigned long long) load_info.bytes_copied);
+    } else {
+        printf("⚠️  Load info unavailable: %s\n", memdl_error());
+    }
+    if (timed) {
+        memdl_close(timed);
+    }
+    memdl_set_instrumentation(0);
+
+    // 测试流式加载：分块读入 memfd；无效数据在第一个数据块后即被拒绝
+    stream_ctx_t stream = {data, size, 0, 4096, 0};
+    memdl_handle_t streamed = memdl_open_stream(stream_read, &stream, 0, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE);
+    calculate_t stream_calc = streamed ? memdl_sym(streamed, "calculate_sum") : NULL;
+    stream_ctx_t garbage = {NULL, 0, 0, 4096, 0};
+    if (stream_calc && stream_calc(4, 5) == 9 && !memdl_open_stream(stream_read, &garbage, 0, MEMDL_NOW) &&
+        garbage.calls == 1) {
+        printf("✅ Streaming load works (%d chunks)\n", stream.calls);
+    } else {
+        printf("⚠️  Streaming load failed: %s\n", memdl_error());
+    }
+    if (streamed) {
+        memdl_close(streamed);
+    }
+
+    // 测试 LZ4 帧：以 64KB 独立原始块封装，memdl_open 按魔数识别后解码进 memfd
+    size_t frame_size = 7 + size + (size / 65536 + 1) * 4 + 4;
+    unsigned char* frame = malloc(frame_size);
+    size_t frame_len = 0;
+    if (frame) {
+        // 魔数 0x184D2204，FLG=0x60（版本 01、块独立），BD=0x40（64KB 块），HC 为描述符的 XXH32 第二字节
+        const unsigned char frame_header[] = {0x04, 0x22, 0x4D, 0x18, 0x60, 0x40, 0x82};
+        memcpy(frame, frame_header, sizeof(frame_header));
+        frame_len = sizeof(frame_header);
+        for (size_t offset = 0; offset < size; offset += 65536) {
+            size_t block = size - offset < 65536 ? size - offset : 65536;
+            unsigned int word = (unsigned int)block | 0x80000000u;
+            for (int i = 0; i < 4; i++) frame[frame_len++] = (unsigned char)(word >> (i * 8));
+            memcpy(frame + frame_len, (const char*)data + offset, block);
+            frame_len += block;
+        }
+        memset(frame + frame_len, 0, 4);
+        frame_len += 4;
+    }
+    memdl_handle_t packed_lz4 = frame ? memdl_open(frame, frame_len, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE) : NULL;
+    calculate_t lz4_calc = packed_lz4 ? memdl_sym(packed_lz4, "calculate_sum") : NULL;
+    if (lz4_calc && lz4_calc(6, 7) == 13) {
+        printf("✅ LZ4 frame load works (%zu -> %zu bytes)\n", frame_len, size);
+    } else {
+        printf("⚠️  LZ4 frame load failed: %s\n", memdl_error());
+    }
+    if (packed_lz4) {
+        memdl_close(packed_lz4);
+    }
+
+    // 测试按需调页：原始镜像与 LZ4 帧都只在访问时填充页面，源数据在关闭前保持有效
+    memdl_handle_t lazy = memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_ONDEMAND);
+    memdl_handle_t lazy_lz4 = frame ? memdl_open(frame, frame_len, MEMDL_NOW | MEMDL_LOCAL | MEMDL_ONDEMAND) : NULL;
+    calculate_t lazy_calc = lazy ? memdl_sym(lazy, "calculate_sum") : NULL;
+    calculate_t lazy_lz4_calc = lazy_lz4 ? memdl_sym(lazy_lz4, "calculate_sum") : NULL;
+    memdl_page_info_t pages;
+    if (lazy_calc && lazy_lz4_calc && lazy_calc(1, 2) == 3 && lazy_lz4_calc(3, 4) == 7 &&
+        memdl_get_page_info(lazy, &pages) == 0 && pages.faulted <= pages.pages) {
+        printf("✅ On-demand paging works (%zu of %zu pages faulted in)\n", pages.faulted, pages.pages);
+    } else {
+        printf("⚠️  On-demand paging failed: %s\n", memdl_error());
+    }
+    if (lazy) {
+        memdl_close(lazy);
+    }
+    if (lazy_lz4) {
+        memdl_close(lazy_lz4);
+    }
+    free(frame);
+
+    // 测试大页代码段：测试库小于 2MB，不会被替换，但段信息可查且代码照常可调用
+    memdl_handle_t huge = memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE | MEMDL_HUGEPAGES);
+    calculate_t huge_calc = huge ? memdl_sym(huge, "calculate_sum") : NULL;
+    memdl_segment_t segments[8];
+    size_t segment_count = huge ? memdl_get_segments(huge, segments, 8) : 0;
+    if (huge_calc && huge_calc(4, 5) == 9 && segment_count > 0) {
+        printf("✅ Huge-page load works (%zu segments, %zu huge bytes in the first)\n", segment_count,
+               segments[0].huge_bytes);
+    } else {
+        printf("⚠️  Huge-page load failed: %s\n", memdl_error());
+    }
+    if (huge) {
+        memdl_close(huge);
+    }
+
+    // 测试预取：MEMDL_PREFAULT 加载后再显式 memdl_warm 一次
+    memdl_handle_t warm = memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE | MEMDL_PREFAULT);
+    calculate_t warm_calc = warm ? memdl_sym(warm, "calculate_sum") : NULL;
+    if (warm_calc && memdl_warm(warm) == 0 && warm_calc(5, 6) == 11) {
+        printf("✅ Prefault and warm-up work\n");
+    } else {
+        printf("⚠️  Prefault failed: %s\n", memdl_error());
+    }
+    if (warm) {
+        memdl_close(warm);
+    }
+
+    // 测试热替换：经符号表间接调用，替换后版本号递增且新表可用
+    const char* swap_symbols[] = {"calculate_sum"};
+    memdl_swap_t* swap = memdl_swap_open(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE, swap_symbols, 1);
+    memdl_swap_view_t view;
+    int swap_ok = swap != NULL;
+    if (swap_ok) {
+        memdl_swap_enter(swap, &view);
+        swap_ok = ((calculate_t) view.syms[0])(1, 1) == 2 && view.version == 1;
+        memdl_swap_leave(swap, &view);
+    }
+    if (swap_ok && memdl_replace(swap, data, size) == 0) {
+        memdl_swap_enter(swap, &view);
+        swap_ok = ((calculate_t) view.syms[0])(2, 2) == 4 && view.version == 2;
+        memdl_swap_leave(swap, &view);
+    } else {
+        swap_ok = 0;
+    }
+    if (swap_ok) {
+        printf("✅ Hot swap works (version %llu)\n", (unsigned long long) memdl_swap_version(swap));
+    } else {
+        printf("⚠️  Hot swap failed: %s\n", memdl_error());
+    }
+    if (swap) {
+        memdl_swap_close(swap);
+    }
+
+    // 测试插件管理器：预算只容得下一个插件，pin 第二个时淘汰第一个，再次 pin 时重新加载
+    memdl_manager_t* manager = memdl_manager_create(1, MEMDL_NOW | MEMDL_LOCAL);
+    memdl_manager_stats_t manager_stats;
+    int manager_ok = manager && memdl_manager_add(manager, "a", data, size) == 0 &&
+                     memdl_manager_add(manager, "b", data, size) == 0;
+    for (int i = 0; manager_ok && i < 3; i++) {
+        const char* name = i == 1 ? "b" : "a";
+        memdl_handle_t plugin = memdl_manager_pin(manager, name);
+        calculate_t plugin_calc = plugin ? memdl_sym(plugin, "calculate_sum") : NULL;
+        manager_ok = plugin_calc && plugin_calc(i, 1) == i + 1 && memdl_manager_unpin(manager, name) == 0;
+    }
+    if (manager_ok) {
+        memdl_manager_stats(manager, &manager_stats);
+        manager_ok = manager_stats.misses == 3 && manager_stats.evictions == 3 && manager_stats.resident == 0;
+    }
+    if (manager_ok) {
+        printf("✅ Plugin manager evicts idle plugins (%llu evictions)\n",
+               (unsigned long long) manager_stats.evictions);
+    } else {
+        printf("⚠️  Plugin manager failed: %s\n", memdl_error());
+    }
+    memdl_manager_destroy(manager);
+
+#ifdef __linux__
+    // 测试共享 memfd：导出一次，经 SCM_RIGHTS 传递后从收到的 fd 加载
+    int shared_fd = memdl_export_fd(data, size);
+    int sockets[2] = {-1, -1};
+    int received_fd = -1;
+    if (shared_fd >= 0 && socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0 &&
+        memdl_send_fd(sockets[0], shared_fd) == 0) {
+        received_fd = memdl_recv_fd(sockets[1]);
+    }
+    memdl_handle_t shared = received_fd >= 0 ? memdl_open_fd(received_fd, MEMDL_NOW | MEMDL_LOCAL) : NULL;
+    calculate_t shared_calc = shared ? memdl_sym(shared, "calculate_sum") : NULL;
+    if (shared_calc && shared_calc(8, 9) == 17) {
+        printf("✅ Shared memfd export works\n");
+    } else {
+        printf("⚠️  Shared memfd export failed: %s\n", memdl_error());
+    }
+    if (shared) {
+        memdl_close(shared);
+    }
+    for (int i = 0; i < 2; i++) {
+        if (sockets[i] >= 0) close(sockets[i]);
+    }
+    if (received_fd >= 0) close(received_fd);
+    if (shared_fd >= 0) close(shared_fd);
+
+    // 测试从普通文件的描述符原生加载：flags 与 memdl_open 一致生效
+    const int file_fd = open("libtest_lib.so", O_RDONLY | O_CLOEXEC);
+    memdl_handle_t fd_native = file_fd >= 0 ? memdl_open_fd(file_fd, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NATIVE) : NULL;
+    memdl_load_info_t fd_info;
+    calculate_t fd_calc = fd_native ? memdl_sym(fd_native, "calculate_sum") : NULL;
+    if (fd_calc && fd_calc(4, 5) == 9 && memdl_get_load_info(fd_native, &fd_info) == 0 &&
+        fd_info.strategy == MEMDL_STRATEGY_NATIVE) {
+        printf("✅ Descriptor load honours MEMDL_NATIVE\n");
+    } else {
+        printf("⚠️  Descriptor native load failed: %s\n", memdl_error());
+    }
+    if (fd_native) memdl_close(fd_native);
+    if (file_fd >= 0) close(file_fd);
+
+    // 测试独立实例：两个实例的全局变量互不影响
+    typedef int (*counter_t)(void);
+    memdl_handle_t inst_a = memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_INSTANCE);
+    memdl_handle_t inst_b = memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_INSTANCE);
+    counter_t inc_a = inst_a ? (counter_t) memdl_sym(inst_a, "increment_counter") : NULL;
+    counter_t get_b = inst_b ? (counter_t) memdl_sym(inst_b, "get_counter") : NULL;
+    if (inst_a != inst_b && inc_a && get_b && inc_a() == 1 && get_b() == 0) {
+        printf("✅ Isolated instances keep separate globals\n");
+    } else {
+        printf("⚠️  Isolated instances failed: %s\n", memdl_error());
+    }
+    if (inst_a) memdl_close(inst_a);
+    if (inst_b) memdl_close(inst_b);
+
+    // 测试 perf 符号表：加载后 /tmp/perf-<pid>.map 含本镜像的函数，关闭后条目被删去
+    char perf_path[64];
+    snprintf(perf_path, sizeof(perf_path), "/tmp/perf-%d.map", (int) getpid());
+    memdl_set_perf_map(1);
+    memdl_handle_t profiled = memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE);
+    memdl_set_perf_map(0);
+    calculate_t profiled_calc = profiled ? memdl_sym(profiled, "calculate_sum") : NULL;
+    char perf_entry[64];
+    snprintf(perf_entry, sizeof(perf_entry), "%lx ", (unsigned long) (uintptr_t) profiled_calc);
+    char perf_text[65536] = "";
+    FILE* perf_map = fopen(perf_path, "r");
+    if (perf_map) {
+        perf_text[fread(perf_text, 1, sizeof(perf_text) - 1, perf_map)] = '\0';
+        fclose(perf_map);
+    }
+    int perf_ok = profiled_calc && strstr(perf_text, perf_entry) && strstr(perf_text, " calculate_sum\n");
+    if (profiled) memdl_close(profiled);
+    perf_map = fopen(perf_path, "r");
+    if (perf_map) {
+        perf_text[fread(perf_text, 1, sizeof(perf_text) - 1, perf_map)] = '\0';
+        fclose(perf_map);
+        perf_ok = perf_ok && !strstr(perf_text, " calculate_sum\n");
+    }
+    unlink(perf_path);
+    if (perf_ok) {
+        printf("✅ perf map entries written and removed\n");
+    } else {
+        printf("⚠️  perf map failed: %s\n", memdl_error());
+    }
+
+    // 测试落地方式：路径方式排在 memfd 之前时应先用路径方式，加载记录为临时文件策略
+    memdl_caps_t caps;
+    int backings[2] = {MEMDL_BACKING_DISK, MEMDL_BACKING_MEMFD};
+    if (memdl_get_caps(&caps) == 0 && caps.probe_ns[MEMDL_BACKING_SHM]) {
+        backings[0] = MEMDL_BACKING_SHM;
+    }
+    const int backing = backings[0];
+    memdl_load_info_t backing_info;
+    memdl_handle_t backed = memdl_set_strategy(backings, 2) == 0
+                                ? memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NOCACHE)
+                                : NULL;
+    memdl_set_strategy(NULL, 0);
+    calculate_t backed_calc = backed ? memdl_sym(backed, "calculate_sum") : NULL;
+    if (backed_calc && backed_calc(9, 9) == 18 && memdl_get_load_info(backed, &backing_info) == 0 &&
+        backing_info.strategy == MEMDL_STRATEGY_TMPFILE && caps.order[0] != 0) {
+        printf("✅ Strategy override works (caps 0x%x, backing %d)\n", caps.caps, backing);
+    } else {
+        printf("⚠️  Strategy override failed: %s\n", memdl_error());
+    }
+    if (backed) memdl_close(backed);
+#endif
+
+    // 测试原生加载器：不经过 memfd 和 dlopen
+    memdl_handle_t native = memdl_open(data, size, MEMDL_NOW | MEMDL_LOCAL | MEMDL_NATIVE);
+    if (native) {
+        calculate_t native_calc = memdl_sym(native, "calculate_sum");
+        get_message_t native_msg = memdl_sym(native, "get_message");
+        if (native_calc && native_msg && native_calc(2, 3) == 5) {
+            printf("✅ Native loader works: %s\n", native_msg());
+        } else {
+            printf("⚠️  Native loader symbol lookup failed: %s\n", memdl_error());
+        }
+#ifdef __linux__
+        top_value_t native_ifunc = memdl_sym(native, "ifunc_value");
+        if (native_ifunc && native_ifunc() == 7) {
+            printf("✅ Native loader resolves IFUNC symbols\n");
+        } else {
+            printf("⚠️  Native loader IFUNC lookup failed: %s\n", memdl_error());
+        }
+#endif
+        memdl_close(native);
+    } else {
+        printf("⚠️  Native loader unavailable: %s\n", memdl_error());
+    }
+
+    // 测试批量加载：重复镜像应得到同一个缓存句柄，无效镜像单独报错
+    const char bogus[] = "not an elf image";
+    const memdl_source_t sources[] = {
+        {data, size}, {data, size}, {bogus, sizeof(bogus)},
+    };
+    memdl_open_result_t results[3];
+    memdl_batch_info_t batch;
+    const size_t opened = memdl_open_many(sources, 3, MEMDL_NOW | MEMDL_LOCAL, results, &batch);
+    if (opened == 2 && results[0].handle == handle && results[1].handle == handle &&
+        results[2].error.code == MEMDL_ERR_FORMAT) {
+        printf("✅ Batch open loaded %zu/%zu images with %u threads\n", batch.loaded,
+               batch.loaded + batch.failed, batch.threads);
+    } else {
+        printf("⚠️  Batch open loaded %zu of 3 images\n", opened);
+    }
+    for (size_t i = 0; i < 3; i++) {
+        if (results[i].handle) {
+            memdl_close(results[i].handle);
+        }
+    }
+
+    // 测试异步加载：等待票据完成后取得缓存句柄
+    memdl_ticket_t* ticket = memdl_open_async(data, size, MEMDL_NOW | MEMDL_LOCAL);
+    if (ticket && memdl_ticket_wait(ticket, 5000) == 0) {
+        memdl_handle_t async_handle = memdl_ticket_result(ticket);
+        if (async_handle == handle) {
+            printf("✅ Asynchronous open completed\n");
+        } else {
+            printf("⚠️  Asynchronous open failed: %s\n", memdl_error());
+        }
+        if (async_handle) {
+            memdl_close(async_handle);
+        }
+    } else {
+        printf("⚠️  Asynchronous open did not complete: %s\n", memdl_error());
+    }
+    memdl_ticket_free(ticket);
+
+    // 测试打包文件：按名称打开成员，内容哈希取自索引并命中同一个缓存句柄
+    const char* bundle_names[] = {"test_lib"};
+    const memdl_source_t bundle_images[] = {{data, size}};
+    memdl_bundle_t* bundle = memdl_bundle_write("test.bundle", bundle_names, bundle_images, 1, 0) == 0
+                                 ? memdl_bundle_open_file("test.bundle")
+                                 : NULL;
+    memdl_handle_t packed = bundle ? memdl_bundle_load(bundle, "test_lib", MEMDL_NOW | MEMDL_LOCAL) : NULL;
+    if (packed == handle && memdl_bundle_exports(bundle, "test_lib", NULL, 0) == export_count) {
+        printf("✅ Bundle member loaded by name\n");
+    } else {
+        printf("⚠️  Bundle load failed: %s\n", memdl_error());
+    }
+    if (packed) {
+        memdl_close(packed);
+    }
+    memdl_bundle_close(bundle);
+
+    // 索引哈希被改动的打包文件不能借用已缓存的句柄
+    size_t bundle_size = 0;
+    unsigned char* bundle_data = read_file("test.bundle", &bundle_size);
+    if (bundle_data && bundle_size >= 72) {
+        size_t entries = 0;
+        for (int i = 0; i < 8; i++) entries |= (size_t) bundle_data[32 + i] << (8 * i);
+        bundle_data[entries + 32] ^= 1;
+    }
+    memdl_bundle_t* forged = bundle_data ? memdl_bundle_open(bundle_data, bundle_size) : NULL;
+    memdl_handle_t forged_handle = forged ? memdl_bundle_load(forged, "test_lib", MEMDL_NOW | MEMDL_LOCAL) : NULL;
+    memdl_error_info_t forged_error = {0};
+    memdl_last_error(&forged_error);
+    if (forged && !forged_handle && forged_error.code == MEMDL_ERR_INTEGRITY) {
+        printf("✅ Bundle index hash checked against member\n");
+    } else {
+        printf("⚠️  Forged bundle hash was accepted\n");
+    }
+    if (forged_handle) {
+        memdl_close(forged_handle);
+    }
+    memdl_bundle_close(forged);
+    free(bundle_data);
+    remove("test.bundle");
+
+    // 测试内存依赖
+    test_dependencies(MEMDL_NOW | MEMDL_LOCAL, "dlopen");
+    test_dependencies(MEMDL_NOW | MEMDL_LOCAL | MEMDL_NATIVE, "native");
+
     // 清理
     memdl_close(handle);
     free(data);
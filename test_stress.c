@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * File: test_stress.c
+ * Project: memdl
+ * Created: 2025/11/7
+ * Author: eternalfuture-e38299
+ * Github: https://github.com/eternalfuture-e38299
+ *
+ * MIT License
+ *
+ * Copyright (c) 2025 EternalFuture
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "memdl.h"
+
+// 多线程并发 open/sym/close 压力测试，检查线程局部错误信息互不干扰
+
+#define STRESS_THREADS    16
+#define STRESS_ITERATIONS 200
+
+typedef const char* (*get_version_t)(void);
+
+static void* lib_data = NULL;
+static size_t lib_size = 0;
+
+typedef struct {
+    int id;
+    int failures;
+} stress_job_t;
+
+static void* stress_worker(void* arg) {
+    stress_job_t* job = arg;
+    const int modes[] = {0, MEMDL_NOCACHE, MEMDL_NATIVE};
+    char missing[64];
+
+    for (int i = 0; i < STRESS_ITERATIONS; i++) {
+        const int mode = modes[(job->id + i) % 3];
+        memdl_handle_t handle = memdl_open(lib_data, lib_size, MEMDL_NOW | MEMDL_LOCAL | mode);
+        if (!handle) {
+            printf("❌ [thread %d] open failed: %s\n", job->id, memdl_error());
+            job->failures++;
+            continue;
+        }
+
+        get_version_t get_version = memdl_sym(handle, "get_version");
+        if (!get_version || strcmp(get_version(), "1.0.0-memory-loaded") != 0) {
+            job->failures++;
+        }
+
+        // 每个线程查找不同的缺失符号，错误信息必须是自己的
+        snprintf(missing, sizeof(missing), "missing_symbol_%d_%d", job->id, i);
+        if (memdl_sym(handle, missing) != NULL) {
+            job->failures++;
+        }
+        memdl_error_info_t info;
+        if (memdl_last_error(&info) != MEMDL_ERR_SYMBOL || info.stage != MEMDL_STAGE_SYMBOL ||
+            !strstr(info.message, missing)) {
+            printf("❌ [thread %d] unexpected error state: code=%d stage=%d %s\n",
+                   job->id, info.code, info.stage, info.message);
+            job->failures++;
+        }
+
+        if (memdl_close(handle) != 0) {
+            job->failures++;
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "test_lib.dll";
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("❌ Cannot open test library file\n");
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    lib_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    lib_data = malloc(lib_size);
+    if (!lib_data || fread(lib_data, 1, lib_size, file) != lib_size) {
+        fclose(file);
+        printf("❌ Cannot read test library file\n");
+        return 1;
+    }
+    fclose(file);
+
+    pthread_t threads[STRESS_THREADS];
+    stress_job_t jobs[STRESS_THREADS];
+    for (int t = 0; t < STRESS_THREADS; t++) {
+        jobs[t].id = t;
+        jobs[t].failures = 0;
+        pthread_create(&threads[t], NULL, stress_worker, &jobs[t]);
+    }
+
+    int failures = 0;
+    for (int t = 0; t < STRESS_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        failures += jobs[t].failures;
+    }
+
+    memdl_cache_stats_t stats;
+    memdl_cache_stats(&stats);
+    printf("🧵 %d threads x %d iterations, cache hits=%llu misses=%llu entries=%zu\n",
+           STRESS_THREADS, STRESS_ITERATIONS,
+           (unsigned long long) stats.hits, (unsigned long long) stats.misses, stats.entries);
+    free(lib_data);
+
+    if (failures || stats.entries != 0) {
+        printf("❌ Stress test failed: %d failures\n", failures);
+        return 1;
+    }
+    printf("✅ Stress test passed\n");
+    return 0;
+}